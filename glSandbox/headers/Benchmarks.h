@@ -0,0 +1,8 @@
+#pragma once
+
+namespace benchmarks
+{
+	void drawUI(bool* open);
+	//runs every benchmark with its default settings and prints the results, needs no window or context
+	void runAll();
+}
@@ -0,0 +1,196 @@
+#pragma once
+#include "Geometry.h"
+#include "Util.h"
+#include "SIMD.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+class Prop;
+
+//dynamic AABB tree over props, moved props only refit their ancestors
+//and the whole tree is rebuilt with the surface area heuristic once refitting degraded it enough
+class BoundingVolumeHierarchy
+{
+private:
+	struct Volume
+	{
+		glm::vec3 min{0.0f};
+		glm::vec3 max{0.0f};
+		int parent = -1;
+		int left = -1;
+		int right = -1;
+		Prop* prop = nullptr;
+		bool outdated = false;
+
+		bool isLeaf() const
+		{
+			return left == -1;
+		}
+	};
+	static constexpr int binCount = 16;
+	static constexpr float rebuildThreshold = 1.5f;
+	std::vector<Volume> volumes;
+	std::vector<int> freeVolumes;
+	std::vector<int> outdatedLeaves;
+	int root = -1;
+	int leafCount = 0;
+	float internalArea = 0.0f;
+	float builtCost = 0.0f;
+	//scratch space for fitting leaves in batches
+	std::vector<glm::mat4> leafTransformations;
+	simd::BoundsSoA leafBounds;
+
+public:
+	BoundingVolumeHierarchy() = default;
+	BoundingVolumeHierarchy(BoundingVolumeHierarchy const&) = delete;
+	BoundingVolumeHierarchy(BoundingVolumeHierarchy&&) = default;
+	BoundingVolumeHierarchy& operator=(BoundingVolumeHierarchy const&) = delete;
+	BoundingVolumeHierarchy& operator=(BoundingVolumeHierarchy&&) = default;
+	~BoundingVolumeHierarchy() = default;
+
+private:
+	static float area(glm::vec3 const& min, glm::vec3 const& max);
+	static float area(Volume const& volume);
+	int allocate();
+	void release(int volume);
+	void fitLeaf(int leaf);
+	void fitLeaves(std::vector<int>& leaves);
+	void fitInternal(int volume);
+	void refitAncestors(int volume);
+	void insertLeaf(int leaf);
+	void removeLeaf(int leaf);
+	int build(std::vector<int>& leaves, int begin, int end);
+
+public:
+	void insert(Prop* prop);
+	void remove(Prop* prop);
+	void outdated(Prop* prop);
+	void refit();
+	void rebuild();
+	int getSize() const;
+	float getCost() const;
+	Bounds getBounds() const;
+	template<typename Callable>
+	void query(Frustum const& frustum, Callable&& operation) const;
+	template<typename Callable>
+	void query(Sphere const& sphere, Callable&& operation) const;
+	template<typename Callable>
+	void query(Bounds const& bounds, Callable&& operation) const;
+	template<typename Callable>
+	void raycast(Ray const& ray, float maxDistance, Callable&& operation) const;
+
+private:
+	template<typename Test, typename Callable>
+	void traverse(Test&& test, Callable&& operation) const;
+
+};
+
+template<typename Test, typename Callable>
+void BoundingVolumeHierarchy::traverse(Test&& test, Callable&& operation) const
+{
+	if(root == -1)
+		return;
+	std::vector<int> stack;
+	stack.reserve(64);
+	stack.push_back(root);
+	while(!stack.empty())
+	{
+		int const current = stack.back();
+		stack.pop_back();
+		Volume const& volume = volumes[current];
+		if(!test(volume.min, volume.max))
+			continue;
+		if(volume.isLeaf())
+		{
+			operation(volume.prop);
+		}
+		else
+		{
+			stack.push_back(volume.left);
+			stack.push_back(volume.right);
+		}
+	}
+}
+
+template<typename Callable>
+void BoundingVolumeHierarchy::query(Frustum const& frustum, Callable&& operation) const
+{
+	traverse([&](glm::vec3 const& min, glm::vec3 const& max){
+		return frustum.intersects(min, max);
+	}, operation);
+}
+
+template<typename Callable>
+void BoundingVolumeHierarchy::query(Sphere const& sphere, Callable&& operation) const
+{
+	traverse([&](glm::vec3 const& min, glm::vec3 const& max){
+		return sphere.intersects(min, max);
+	}, operation);
+}
+
+template<typename Callable>
+void BoundingVolumeHierarchy::query(Bounds const& bounds, Callable&& operation) const
+{
+	if(bounds.empty())
+		return;
+	auto const[queryMin, queryMax] = bounds.getValues();
+	traverse([&](glm::vec3 const& min, glm::vec3 const& max){
+		return glm::all(glm::lessThanEqual(min, queryMax)) && glm::all(glm::lessThanEqual(queryMin, max));
+	}, operation);
+}
+
+//operation receives a prop and the distance at which the ray enters its bounds,
+//and returns the distance of the closest hit found so far, props are visited roughly front to back
+template<typename Callable>
+void BoundingVolumeHierarchy::raycast(Ray const& ray, float maxDistance, Callable&& operation) const
+{
+	if(root == -1)
+		return;
+	glm::vec3 const inverseDirection = ray.getInverseDirection();
+	std::vector<std::pair<int, float>> stack;
+	float entry;
+	if(!ray.intersects(volumes[root].min, volumes[root].max, inverseDirection, maxDistance, entry))
+		return;
+	stack.emplace_back(root, entry);
+	while(!stack.empty())
+	{
+		auto const[current, currentEntry] = stack.back();
+		stack.pop_back();
+		if(currentEntry > maxDistance)
+			continue;
+		Volume const& volume = volumes[current];
+		if(volume.isLeaf())
+		{
+			maxDistance = std::min(maxDistance, operation(volume.prop, currentEntry));
+			continue;
+		}
+		float leftEntry, rightEntry;
+		Volume const& left = volumes[volume.left];
+		Volume const& right = volumes[volume.right];
+		bool const hitLeft = ray.intersects(left.min, left.max, inverseDirection, maxDistance, leftEntry);
+		bool const hitRight = ray.intersects(right.min, right.max, inverseDirection, maxDistance, rightEntry);
+		if(hitLeft && hitRight)
+		{
+			//the nearer child is pushed last so it is visited first
+			if(leftEntry < rightEntry)
+			{
+				stack.emplace_back(volume.right, rightEntry);
+				stack.emplace_back(volume.left, leftEntry);
+			}
+			else
+			{
+				stack.emplace_back(volume.left, leftEntry);
+				stack.emplace_back(volume.right, rightEntry);
+			}
+		}
+		else if(hitLeft)
+		{
+			stack.emplace_back(volume.left, leftEntry);
+		}
+		else if(hitRight)
+		{
+			stack.emplace_back(volume.right, rightEntry);
+		}
+	}
+}
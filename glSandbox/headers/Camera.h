@@ -6,8 +6,12 @@
 #include <glm/gtc\quaternion.hpp>
 #include <tuple>
 
+class RingBuffer;
+
 class Camera final : public Transformed<Translation, Rotation>
 {
+	friend class SceneSnapshot;
+
 private:
 	bool visualizeFrustum = true;
 	bool projectionOrtho = false;
@@ -17,16 +21,18 @@ private:
 	float orthoScale = 0.005f;
 
 public:
-	Camera();
+	static constexpr NodeType type = NodeType::camera;
 
-private:
-	static unsigned int ubo();
+public:
+	Camera();
 
 protected:
 	std::string getNamePrefix() const override;
 
 public:
-	void use() const;
+	NodeType getType() const override;
+	//projection and view are written to the camera uniform block at binding 0
+	void use(RingBuffer& frameData) const;
 	glm::mat4 getProjectionMatrix() const;
 	glm::mat4 getViewMatrix() const;
 	float getNearPlane() const;
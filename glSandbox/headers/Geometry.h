@@ -0,0 +1,100 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <array>
+#include <algorithm>
+
+struct Sphere
+{
+	glm::vec3 center{0.0f};
+	float radius = 0.0f;
+
+	bool intersects(glm::vec3 const& min, glm::vec3 const& max) const
+	{
+		glm::vec3 const closest = glm::clamp(center, min, max);
+		glm::vec3 const d = closest - center;
+		return glm::dot(d, d) <= radius * radius;
+	}
+};
+
+struct Ray
+{
+	glm::vec3 origin{0.0f};
+	glm::vec3 direction{0.0f, 0.0f, -1.0f};
+
+	glm::vec3 getInverseDirection() const
+	{
+		return 1.0f / direction;
+	}
+
+	glm::vec3 at(float t) const
+	{
+		return origin + direction * t;
+	}
+
+	//slab test, entry holds the distance at which the ray enters the box
+	bool intersects(glm::vec3 const& min, glm::vec3 const& max, glm::vec3 const& inverseDirection, float maxDistance, float& entry) const
+	{
+		glm::vec3 const t0 = (min - origin) * inverseDirection;
+		glm::vec3 const t1 = (max - origin) * inverseDirection;
+		glm::vec3 const tMin = glm::min(t0, t1);
+		glm::vec3 const tMax = glm::max(t0, t1);
+		entry = std::max({tMin.x, tMin.y, tMin.z, 0.0f});
+		float const exit = std::min({tMax.x, tMax.y, tMax.z, maxDistance});
+		return entry <= exit;
+	}
+};
+
+class Frustum
+{
+private:
+	//normals point inwards
+	std::array<glm::vec4, 6> planes;
+
+public:
+	Frustum(glm::mat4 const& viewProjection)
+	{
+		glm::mat4 const m = glm::transpose(viewProjection);
+		planes[0] = m[3] + m[0];
+		planes[1] = m[3] - m[0];
+		planes[2] = m[3] + m[1];
+		planes[3] = m[3] - m[1];
+		planes[4] = m[3] + m[2];
+		planes[5] = m[3] - m[2];
+		for(auto& plane : planes)
+			plane /= glm::length(glm::vec3{plane});
+	}
+
+public:
+	std::array<glm::vec4, 6> const& getPlanes() const
+	{
+		return planes;
+	}
+
+	bool intersects(glm::vec3 const& min, glm::vec3 const& max) const
+	{
+		for(auto const& plane : planes)
+		{
+			glm::vec3 const positive{
+				plane.x >= 0.0f ? max.x : min.x,
+				plane.y >= 0.0f ? max.y : min.y,
+				plane.z >= 0.0f ? max.z : min.z};
+			if(glm::dot(glm::vec3{plane}, positive) + plane.w < 0.0f)
+				return false;
+		}
+		return true;
+	}
+
+	bool contains(glm::vec3 const& min, glm::vec3 const& max) const
+	{
+		for(auto const& plane : planes)
+		{
+			glm::vec3 const negative{
+				plane.x >= 0.0f ? min.x : max.x,
+				plane.y >= 0.0f ? min.y : max.y,
+				plane.z >= 0.0f ? min.z : max.z};
+			if(glm::dot(glm::vec3{plane}, negative) + plane.w < 0.0f)
+				return false;
+		}
+		return true;
+	}
+};
@@ -5,11 +5,14 @@
 #include <glm/glm.hpp>
 #include <imgui.h>
 #include <vector>
+#include <cstdint>
 
 namespace info
 {
 	inline int windowWidth = 2560;
 	inline int windowHeight = 1440;
+	//counts the frames of the main loop, work shared by renderers is done once per frame
+	inline uint64_t frame = 0;
 	inline float aspect()
 	{
 		return float(windowWidth) / windowHeight;
@@ -14,6 +14,6 @@ private:
 	void generate() const override;
 
 public:
-	void drawUI() override;
+	bool drawUI() override;
 
 };
\ No newline at end of file
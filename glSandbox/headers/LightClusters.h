@@ -0,0 +1,90 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+class Scene;
+class Camera;
+class ShadowAtlas;
+
+//lights packed into storage buffers, point and spot lights are assigned to a grid of view space clusters,
+//sliced exponentially in depth, so the lighting shaders only iterate the lights reaching the cluster of a fragment
+class LightClusters
+{
+private:
+	//matches the std430 layout of Light in the lighting shaders, positions and directions are in view space
+	struct GPULight
+	{
+		glm::vec3 color;
+		float intensity;
+		glm::vec3 position;
+		float range;
+		glm::vec3 direction;
+		float innerCutoff;
+		glm::vec3 worldPosition;
+		float outerCutoff;
+		int type;
+		int shadow;
+		//directional lights own this many consecutive shadows, one per cascade
+		int cascades;
+		int padding;
+	};
+	static_assert(sizeof(GPULight) == 80);
+	//precedes the cluster ranges in the cluster buffer
+	struct Header
+	{
+		glm::uvec4 counts;
+		glm::vec4 parameters;
+	};
+	glm::ivec3 gridSize{16, 9, 24};
+	float attenuationCutoff = 0.005f;
+	bool computeAssignment = false;
+	int maxComputeClusterLights = 128;
+	unsigned int lightBuffer = 0;
+	unsigned int clusterBuffer = 0;
+	unsigned int indexBuffer = 0;
+	unsigned int boundsBuffer = 0;
+	std::vector<GPULight> lights;
+	int directionalLights = 0;
+	//view space bounds of every cluster, as min max pairs, rebuilt when the projection changes
+	std::vector<glm::vec4> bounds;
+	std::vector<float> sliceDepths;
+	glm::mat4 boundsProjection{0.0f};
+	glm::ivec3 boundsGridSize{0};
+	std::vector<glm::uvec2> clusters;
+	std::vector<std::vector<int>> sliceCandidates;
+	std::vector<std::vector<uint32_t>> sliceIndices;
+	struct
+	{
+		int clusteredLights = 0;
+		int assignedIndices = 0;
+		int maxClusterLights = 0;
+		float assignmentTime = 0.0f;
+	}stats;
+
+public:
+	LightClusters();
+	LightClusters(LightClusters const&) = delete;
+	LightClusters(LightClusters&&) = delete;
+	LightClusters& operator=(LightClusters const&) = delete;
+	LightClusters& operator=(LightClusters&&) = delete;
+	~LightClusters();
+
+private:
+	int getClusterCount() const;
+	void updateBounds(glm::mat4 const& projection, float nearPlane, float farPlane);
+	void assignSlice(int slice);
+	void assignOnCPU();
+	void assignOnGPU();
+
+public:
+	//lights index their shadow in the atlas, shadows is nullptr when they are off, directional lights index the cascades
+	//of the view from firstCascade
+	void update(Scene const& scene, Camera const& camera, int viewportWidth, int viewportHeight, ShadowAtlas const* shadows,
+		int firstCascade, bool flashHighlighted);
+	void bind() const;
+	int getDirectionalLightCount() const;
+	float getAttenuationCutoff() const;
+	void drawUI();
+
+};
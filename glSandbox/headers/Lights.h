@@ -1,11 +1,26 @@
 #pragma once
 #include "TransformedNode.h"
+#include "Shader.h"
 
 #include <glm/glm.hpp>
-class Shader;
 
 class Light
 {
+public:
+	//one element of a light array in the lighting shaders, named from a prefix like "pointLights[0]."
+	struct Uniforms
+	{
+		Shader::Uniform<glm::vec3> color;
+		Shader::Uniform<float> intensity;
+		Shader::Uniform<glm::vec3> direction;
+		Shader::Uniform<glm::vec3> position;
+		Shader::Uniform<glm::vec3> worldPosition;
+		Shader::Uniform<float> innerCutoff;
+		Shader::Uniform<float> outerCutoff;
+
+		Uniforms(std::string const& prefix);
+	};
+
 private:
 	glm::vec3 color{1.0f};
 	float intensity = 1.0f;
@@ -14,34 +29,52 @@ public:
 	Light() = default;
 	virtual ~Light() = default;
 
+protected:
+	//lights aren't nodes themselves, the node they are mixed into stamps itself
+	virtual void parametersOutdated() = 0;
+
 public:
 	void setColor(glm::vec3 color);
 	glm::vec3 const& getColor() const;
 	void setIntensity(float intensity);
 	float getIntensity() const;
-	void use(std::string const& prefix, Shader& shader, bool flash) const;
+	//highlighted lights flash
+	float getIntensity(bool flash) const;
+	//distance at which the inverse square falloff drops below cutoff
+	float getRange(float cutoff) const;
+	void use(Uniforms const& uniforms, Shader& shader, bool flash) const;
 	virtual void drawUI();
 
 };
 
 class DirectionalLight final : public Light, public Transformed<Rotation>
 {
+public:
+	static constexpr NodeType type = NodeType::directionalLight;
+
 protected:
 	std::string getNamePrefix() const override;
+	void parametersOutdated() override;
 
 public:
-	void use(std::string const& prefix, glm::mat4 const& viewMatrix, Shader& shader, bool flash) const;
+	NodeType getType() const override;
+	void use(Uniforms const& uniforms, glm::mat4 const& viewMatrix, Shader& shader, bool flash) const;
 	void drawUI() override;
 
 };
 
 class PointLight final : public Light, public Transformed<Translation>
 {
+public:
+	static constexpr NodeType type = NodeType::pointLight;
+
 protected:
 	std::string getNamePrefix() const override;
+	void parametersOutdated() override;
 
 public:
-	void use(std::string const& prefix, glm::mat4 const& viewMatrix, Shader& shader, bool flash) const;
+	NodeType getType() const override;
+	void use(Uniforms const& uniforms, glm::mat4 const& viewMatrix, Shader& shader, bool flash) const;
 	void drawUI() override;
 
 };
@@ -51,15 +84,20 @@ class SpotLight final : public Light, public Transformed<Translation, Rotation>
 private:
 	float innerCutoff = 15.0f;
 	float outerCutoff = 20.0f;
+
+public:
+	static constexpr NodeType type = NodeType::spotLight;
 	
 protected:
 	std::string getNamePrefix() const override;
+	void parametersOutdated() override;
 
 public:
+	NodeType getType() const override;
 	void setCutoff(float inner, float outer);
 	float getInnerCutoff() const;
 	float getOuterCutoff() const;
-	void use(std::string const& prefix, glm::mat4 const& viewMatrix, Shader& shader, bool flash) const;
+	void use(Uniforms const& uniforms, glm::mat4 const& viewMatrix, Shader& shader, bool flash) const;
 	void drawUI() override;
 
 };
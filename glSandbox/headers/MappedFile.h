@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+//read only view of a whole file, mapped into memory
+class MappedFile
+{
+private:
+	uint8_t const* data = nullptr;
+	uint64_t size = 0;
+#ifdef _WIN32
+	void* file = nullptr;
+	void* mapping = nullptr;
+#endif
+
+public:
+	MappedFile(std::string_view const filename);
+	MappedFile(MappedFile const&) = delete;
+	MappedFile(MappedFile&&) = delete;
+	MappedFile& operator=(MappedFile const&) = delete;
+	MappedFile& operator=(MappedFile&&) = delete;
+	~MappedFile();
+
+public:
+	bool isOpen() const;
+	uint8_t const* getData() const;
+	uint64_t getSize() const;
+
+};
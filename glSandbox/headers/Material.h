@@ -1,5 +1,6 @@
 #pragma once
 #include "AutoName.h"
+#include "Timestamp.h"
 
 #include <glm/glm.hpp>
 #include <optional>
@@ -7,8 +8,10 @@
 class Texture;
 class Shader;
 
-class Material : public AutoName<Material>
+class Material : public AutoName<Material>, public Timestamp
 {
+	friend class SceneSnapshot;
+
 public:
 	enum class Map
 	{
@@ -26,6 +29,8 @@ private:
 	bool occlusionMapping = true;
 	Texture* emissiveMap = nullptr;
 	glm::vec3 emissiveFactor = glm::vec3{0.0f};
+	//of the latest change of any material
+	static inline uint64_t latestTimestamp = 0;
 
 public:
 	Material() = default;
@@ -33,8 +38,11 @@ public:
 
 protected:
 	std::string getNamePrefix() const override;
+	void updateTimestamp();
 
 public:
+	//renderers don't know which materials their scene uses, so they look at the latest change of any
+	static uint64_t getLatestTimestamp();
 	void setNormalMap(Texture* map);
 	void enableNormalMapping();
 	void disableNormalMapping();
@@ -3,6 +3,8 @@
 
 class MaterialPBRMetallicRoughness : public Material
 {
+	friend class SceneSnapshot;
+
 private:
 	Texture* baseColorMap = nullptr;
 	glm::vec4 baseColorFactor = glm::vec4{1.0f};
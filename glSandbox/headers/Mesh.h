@@ -1,15 +1,21 @@
 #pragma once
 #include "AutoName.h"
 #include "Util.h"
+#include "MeshArena.h"
 
 #include <glm/glm.hpp>
 #include <glad/glad.h>
+#include <memory>
 #include <optional>
 #include <array>
 #include <vector>
 
+class TriangleBVH;
+
 class Mesh : public AutoName<Mesh>
 {
+	friend class SceneSnapshot;
+
 public:
 	enum AttributeType
 	{
@@ -43,11 +49,18 @@ public:
 		uint32_t count;
 		GLenum dataType;
 	};
+	//cpu side copy of small triangle meshes, rasterized by the occlusion culler,
+	//strips and fans are converted to triangle lists
+	struct OccluderGeometry
+	{
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t> indices;
+	};
+	static constexpr uint32_t maxOccluderTriangles = 4096;
 
 private:
-	mutable unsigned int VAO = 0;
-	mutable unsigned int VBO = 0;
-	mutable unsigned int EBO = 0;
+	//vertices and indices live in the shared buffers of a mesh arena pool
+	MeshArena::Range arenaRange;
 	GLenum drawMode = GL_POINTS;
 	uint32_t const vertexCount;
 	uint32_t const indexCount;
@@ -55,6 +68,11 @@ private:
 	bool indexedDrawing;
 	Bounds const bounds;
 	bool availableAttributes[AttributeType::N];
+	//interleaved layout of the vertices in the arena, without data pointers, offsets are relative to the first vertex
+	Attributes layout;
+	std::optional<OccluderGeometry> occluderGeometry;
+	//built on the first raycast against the mesh
+	mutable std::unique_ptr<TriangleBVH> triangleBVH;
 
 public:
 	Mesh(Bounds bounds, GLenum drawMode, Attributes&& attributes, std::optional<IndexBuffer>&& indices = std::nullopt);
@@ -64,6 +82,11 @@ public:
 	Mesh& operator=(Mesh const&) = delete;
 	Mesh& operator=(Mesh&&) = delete;
 
+private:
+	bool hasTrianglePositions(Attributes const& attributes) const;
+	std::optional<OccluderGeometry> extractTriangles(uint8_t const* positionData, uint64_t positionDataSize, uint32_t stride, uint8_t const* indexData) const;
+	void copyOccluderGeometry(Attributes const& attributes, std::optional<IndexBuffer> const& indices);
+
 protected:
 	std::string getNamePrefix() const override;
 
@@ -71,7 +94,14 @@ public:
 	bool hasAttribute(AttributeType attributeType) const;
 	bool hasSurface() const;
 	Bounds const& getBounds() const;
+	OccluderGeometry const* getOccluderGeometry() const;
+	//nullptr for meshes without a surface
+	TriangleBVH const* getTriangleBVH() const;
+	GLenum getDrawMode() const;
+	MeshArena::Range const& getArenaRange() const;
 	void use() const;
+	//depth only passes draw from the packed positions
+	void use(int instanceCount, int baseInstance, bool positionsOnly = false) const;
 	void drawUI();
 
 };
@@ -0,0 +1,134 @@
+#pragma once
+#include <glad/glad.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+//meshes sharing a vertex format and index type are suballocated from the buffers of one pool, so a pool's vertex array
+//is bound once for all of its meshes and their draws can be submitted together with glMultiDraw*Indirect
+//positions are also kept tightly packed in a buffer of their own, with a vertex array that shares the pool's indices,
+//so depth only passes fetch nothing but positions
+class MeshArena
+{
+public:
+	//slots are indexed by Mesh::AttributeType
+	static constexpr int attributeSlots = 4;
+	static constexpr int positionSlot = 0;
+	struct Format
+	{
+		struct Attribute
+		{
+			uint32_t componentSize = 0;
+			GLenum dataType = 0;
+		};
+		//a componentSize of 0 marks a missing attribute
+		std::array<Attribute, attributeSlots> attributes;
+		//0 for meshes drawn without indices
+		GLenum indexDataType = 0;
+	};
+	//vertices are stored interleaved, every attribute padded to 4 bytes
+	struct VertexLayout
+	{
+		uint32_t stride = 0;
+		std::array<uint32_t, attributeSlots> offsets{};
+		std::array<uint32_t, attributeSlots> sizes{};
+	};
+	struct Range
+	{
+		int pool = -1;
+		uint32_t baseVertex = 0;
+		uint32_t vertexCount = 0;
+		uint32_t firstIndex = 0;
+		uint32_t indexCount = 0;
+	};
+	//match the layouts glMultiDrawElementsIndirect and glMultiDrawArraysIndirect read
+	struct DrawElementsCommand
+	{
+		uint32_t count;
+		uint32_t instanceCount;
+		uint32_t firstIndex;
+		int32_t baseVertex;
+		uint32_t baseInstance;
+	};
+	struct DrawArraysCommand
+	{
+		uint32_t count;
+		uint32_t instanceCount;
+		uint32_t first;
+		uint32_t baseInstance;
+	};
+	//both kinds of commands are written with the same stride
+	static constexpr GLsizei commandStride = sizeof(DrawElementsCommand);
+
+private:
+	struct Pool
+	{
+		Format format;
+		VertexLayout layout;
+		uint32_t indexSize = 0;
+		unsigned int VAO = 0;
+		unsigned int VBO = 0;
+		unsigned int EBO = 0;
+		//0 for formats without positions
+		uint32_t positionSize = 0;
+		unsigned int positionVAO = 0;
+		unsigned int positionVBO = 0;
+		uint32_t vertexCapacity = 0;
+		uint32_t indexCapacity = 0;
+		//free ranges as first element and count, neighbouring ranges are always merged
+		std::map<uint32_t, uint32_t> freeVertices;
+		std::map<uint32_t, uint32_t> freeIndices;
+		int meshes = 0;
+	};
+	std::vector<Pool> pools;
+	unsigned int boundVertexArray = 0;
+	struct
+	{
+		int growths = 0;
+	}stats;
+
+public:
+	MeshArena() = default;
+	MeshArena(MeshArena const&) = delete;
+	MeshArena(MeshArena&&) = delete;
+	MeshArena& operator=(MeshArena const&) = delete;
+	MeshArena& operator=(MeshArena&&) = delete;
+	~MeshArena();
+
+private:
+	static bool matches(Format const& lhs, Format const& rhs);
+	static bool allocateRange(std::map<uint32_t, uint32_t>& freeRanges, uint32_t count, uint32_t& first);
+	static void freeRange(std::map<uint32_t, uint32_t>& freeRanges, uint32_t first, uint32_t count);
+	static void growBuffer(unsigned int& buffer, GLsizeiptr oldSize, GLsizeiptr newSize);
+	int createPool(Format const& format);
+	uint32_t allocateVertices(Pool& pool, uint32_t count);
+	uint32_t allocateIndices(Pool& pool, uint32_t count);
+
+public:
+	//never destroyed, it outlives the meshes held by the resource managers
+	static MeshArena& shared();
+	//finds or creates the pool of the format
+	int getPool(Format const& format);
+	VertexLayout const& getVertexLayout(int pool) const;
+	GLenum getIndexDataType(int pool) const;
+	//vertices have to be in the layout of the pool, positions tightly packed
+	Range allocate(int pool, void const* vertices, void const* positions, uint32_t vertexCount, void const* indices, uint32_t indexCount);
+	void release(Range const& range);
+	unsigned int getVertexBuffer(int pool) const;
+	//0 for pools without positions
+	unsigned int getPositionBuffer(int pool) const;
+	GLintptr getPositionOffset(Range const& range) const;
+	unsigned int getIndexBuffer(int pool) const;
+	GLintptr getVertexOffset(Range const& range) const;
+	GLintptr getIndexOffset(Range const& range) const;
+	//the vertex array stays bound, only switching pools or streams rebinds it
+	void bind(int pool, bool positionsOnly = false);
+	void draw(Range const& range, GLenum drawMode, int instanceCount = 1, int baseInstance = 0, bool positionsOnly = false);
+	void writeCommand(std::byte* command, Range const& range, int instanceCount, int baseInstance) const;
+	//commands are read from the buffer bound to GL_DRAW_INDIRECT_BUFFER
+	void multiDraw(int pool, GLenum drawMode, GLintptr commands, int drawCount, bool positionsOnly = false);
+	void drawUI();
+
+};
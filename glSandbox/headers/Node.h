@@ -1,35 +1,65 @@
 #pragma once
 #include "AutoName.h"
 #include "Util.h"
+#include "SmallVector.h"
+#include "Timestamp.h"
 
 #include <glm/glm.hpp>
 #include <vector>
 #include <memory>
+#include <cstdint>
 #include <type_traits>
 class Scene;
 
-class Node : public AutoName<Node>
+enum class NodeType
+{
+	transformedNode,
+	camera,
+	prop,
+	directionalLight,
+	pointLight,
+	spotLight
+};
+
+class Node : public AutoName<Node>, public Timestamp
 {
 	friend class Scene;
+	friend class TransformHierarchy;
 	friend class std::unique_ptr<Node>;
 
+public:
+	static constexpr int inlineChildren = 4;
+	using Children = SmallVector<std::unique_ptr<Node>, inlineChildren>;
+
 private:
 	Scene* scene = nullptr;
 	bool enabled = true;
 	bool highlighted = false;
-	std::vector<std::unique_ptr<Node>> children;
+	int registryIndex = -1;
+	Children children;
+	//drawn from one counter shared by all nodes, so versions also order the changes of different nodes
+	static inline uint64_t latestTransformationVersion = 0;
+	uint64_t transformationVersion = 0;
 
 protected:
 	Node* parent = nullptr;
+	mutable struct{
+		bool localOutdated = true;
+		bool globalOutdated = true;
+		glm::mat4 local{1.0f};
+		glm::mat4 global{1.0f};
+	}transformationCache;
 
 public:
 	Node() = default;
 	Node(Node const&) = delete;
 	Node(Node&&);
 	Node(std::vector<std::unique_ptr<Node>>&&);
-	virtual ~Node() = default;
+	virtual ~Node();
 	Node& operator=(Node const&) = delete;
 	Node& operator=(Node&&) = delete;
+	static void* operator new(std::size_t size);
+	static void operator delete(void* pointer, std::size_t size);
 
 private:
 	void invalidateSceneCache();
@@ -38,8 +68,13 @@ private:
 
 protected:
 	virtual std::string getNamePrefix() const override;
+	void localTransformationOutdated();
+	void globalTransformationOutdated();
+	//stamps the node and its scene, for every change that shows up in a rendered frame
+	void updateTimestamp();
 
 public:
+	virtual NodeType getType() const = 0;
 	Scene* getScene() const;
 	bool isEnabled() const;
 	void enable();
@@ -50,11 +85,16 @@ public:
 	void addChildren(std::vector<std::unique_ptr<Node>>&& nodes, bool retainGlobalTransformation = false);
 	std::unique_ptr<Node> release();
 	std::vector<std::unique_ptr<Node>> releaseChildren();
-	std::vector<std::unique_ptr<Node>> const& getChildren() const;
+	Children const& getChildren() const;
+	//changes whenever the global transformation does
+	uint64_t getTransformationVersion() const;
+	static uint64_t getLatestTransformationVersion();
 	virtual void setLocalTransformation(glm::mat4&&) = 0;
 	virtual void setGlobalTransformation(glm::mat4&&) = 0;
 	virtual glm::mat4 getLocalTransformation() const = 0;
 	virtual glm::mat4 getGlobalTransformation() const = 0;
+	virtual std::tuple<glm::vec3, glm::quat, glm::vec3> getLocalComponents() const = 0;
+	virtual bool inheritsAllComponents() const = 0;
 	virtual Bounds getBounds() const;
 	virtual void drawUI();
 	template<typename Callable>
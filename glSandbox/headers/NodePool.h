@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+
+//size segregated slab allocator backing every Node, only used from the main thread
+class NodePool
+{
+public:
+	struct Stats
+	{
+		int liveObjects = 0;
+		int slabs = 0;
+		int slabAllocations = 0;
+		int unpooledAllocations = 0;
+	};
+	static constexpr std::size_t slabSize = 64 * 1024;
+	static constexpr std::size_t granularity = 16;
+	static constexpr std::size_t maxPooledSize = 1024;
+
+public:
+	static void* allocate(std::size_t size);
+	static void deallocate(void* pointer, std::size_t size);
+	//returns slabs without live objects to the system
+	static void trim();
+	static Stats const& getStats();
+
+};
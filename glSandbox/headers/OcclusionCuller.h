@@ -0,0 +1,48 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+
+//software rasterizer for a handful of occluders into a small depth buffer,
+//props are then tested against a max depth pyramid built on top of it
+class OcclusionCuller
+{
+private:
+	int width = 0;
+	int height = 0;
+	glm::mat4 viewProjection{1.0f};
+	//level 0 holds the nearest occluder depth of every pixel, each further level the farthest depth of 2x2 texels below
+	std::vector<std::vector<float>> pyramid;
+	std::vector<glm::ivec2> levelSizes;
+	std::vector<glm::vec4> clipPositions;
+	std::vector<float> scratch;
+	int rasterizedTriangles = 0;
+
+public:
+	OcclusionCuller(int width = 256, int height = 128);
+	OcclusionCuller(OcclusionCuller const&) = delete;
+	OcclusionCuller(OcclusionCuller&&) = default;
+	OcclusionCuller& operator=(OcclusionCuller const&) = delete;
+	OcclusionCuller& operator=(OcclusionCuller&&) = default;
+	~OcclusionCuller() = default;
+
+private:
+	void rasterizeTriangle(glm::vec4 const& c0, glm::vec4 const& c1, glm::vec4 const& c2);
+	void rasterizeTriangle(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2);
+	//every texel takes the farthest depth of its 3x3 neighborhood
+	void erode();
+
+public:
+	void resize(int width, int height);
+	int getWidth() const;
+	int getHeight() const;
+	//clears the depth buffer
+	void begin(glm::mat4 const& viewProjection);
+	void rasterize(std::vector<glm::vec3> const& positions, std::vector<uint32_t> const& indices, glm::mat4 const& model);
+	//builds the depth pyramid, has to be called after the last occluder and before testing
+	void finish();
+	bool isVisible(glm::vec3 const& min, glm::vec3 const& max) const;
+	std::vector<float> const& getDepthBuffer() const;
+	int getRasterizedTriangles() const;
+
+};
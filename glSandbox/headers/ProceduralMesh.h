@@ -17,6 +17,7 @@ protected:
 
 public:
 	Mesh* get() const;
-	virtual void drawUI() = 0;
+	//returns whether the parameters changed, the mesh is regenerated the next time it is accessed
+	virtual bool drawUI() = 0;
 
 };
\ No newline at end of file
@@ -1,7 +1,45 @@
 #pragma once
+#include <atomic>
+#include <string>
 
 namespace profiler
 {
+	class Counter
+	{
+	private:
+		std::string const name;
+		std::atomic<int> current = 0;
+		int lastFrame = 0;
+
+	public:
+		Counter(std::string name);
+		Counter(Counter const&) = delete;
+		Counter(Counter&&) = delete;
+		Counter& operator=(Counter const&) = delete;
+		Counter& operator=(Counter&&) = delete;
+		~Counter() = default;
+
+	public:
+		void increment(int amount = 1)
+		{
+			current.fetch_add(amount, std::memory_order_relaxed);
+		}
+		std::string const& getName() const;
+		int get() const;
+		void nextFrame();
+
+	};
+
+	namespace counters
+	{
+		inline Counter transformationUpdates{"Transformation Updates"};
+		inline Counter visibleProps{"Visible Props"};
+		inline Counter culledProps{"Culled Props"};
+		inline Counter occludedProps{"Occluded Props"};
+		inline Counter shadowCasters{"Shadow Casters"};
+		inline Counter drawCalls{"Prop Draw Calls"};
+	}
+
 	inline float frametime = 0.0f;
 	inline float fps = 0.0f;
 	void recordFrame();
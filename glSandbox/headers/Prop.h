@@ -10,11 +10,19 @@ class Material;
 
 class Prop final : public Transformed<Translation, Rotation, Scale>
 {
+	friend class BoundingVolumeHierarchy;
+	friend class RenderQueue;
+
 private:
+	int boundingVolume = -1;
+	int renderQueueItem = -1;
 	Mesh* staticMesh = nullptr;
 	std::unique_ptr<ProceduralMesh> proceduralMesh = nullptr;
 	Material* material = MaterialManager::uvChecker();
 
+public:
+	static constexpr NodeType type = NodeType::prop;
+
 public:
 	Prop() = default;
 	Prop(Mesh* mesh, Material* material = MaterialManager::uvChecker());
@@ -25,8 +33,10 @@ protected:
 	std::string getNamePrefix() const override;
 
 public:
+	NodeType getType() const override;
 	Mesh& getMesh() const;
 	Material* getMaterial() const;
+	Bounds getOwnBounds() const;
 	Bounds getBounds() const override;
 	void drawUI() override;
 
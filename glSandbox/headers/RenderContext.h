@@ -0,0 +1,125 @@
+#pragma once
+#include "ShadowAtlas.h"
+
+#include <glm/glm.hpp>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <utility>
+#include <vector>
+
+class Scene;
+class Camera;
+class Prop;
+class Node;
+class Shader;
+class SpotLight;
+class PointLight;
+
+//view independent work of a scene, shared by every renderer showing it, shadow maps of spot and point lights are drawn
+//once per frame by the first renderer that needs them, cascades of directional lights follow the cameras, so every view
+//gets cascades of its own in the same atlas, drawn the first time its camera asks for them in a frame
+class RenderContext
+{
+public:
+	//draws the props depth only, with the shader in use, through the renderer running the update
+	using DepthRenderer = std::function<void(Shader*, std::vector<Prop*> const&)>;
+
+private:
+	Scene const& scene;
+	struct
+	{
+		bool faceCulling = true;
+		int faceCullingMode = GL_BACK;
+		//exponent of the largest tile, spot light tiles shrink with their distance to the closest view
+		int resolution = 11;
+		int atlasResolution = 12;
+		float fullResolutionDistance = 10.0f;
+		int pointResolution = 10;
+		int pointCapacity = 4;
+		//directional lights split the camera frustum up to cascadeDistance into cascades, blending logarithmic and
+		//uniform split distances by cascadeSplitBlend
+		int cascades = 3;
+		float cascadeDistance = 50.0f;
+		float cascadeSplitBlend = 0.75f;
+		float spotLightNearPlane = 0.1f;
+		float spotLightFarPlane = 20.0f;
+		float pointLightNearPlane = 0.1f;
+		float pointLightFarPlane = 100.0f;
+		ShadowAtlas atlas;
+		bool cullCasters = true;
+		std::vector<Prop*> casters;
+		std::array<std::vector<Prop*>, 64> castersByFaceMask;
+		std::vector<std::pair<Node const*, int>> casterCounts;
+		//shadow maps are only redrawn when their light or casters change, props that moved within the last
+		//dynamicFrames frames are drawn over a static layer holding the others
+		bool caching = true;
+		bool staticLayer = true;
+		int dynamicFrames = 30;
+		//the latest transformation version at each of the last frames
+		std::deque<uint64_t> versionHistory;
+		std::vector<Prop*> staticCasters;
+		std::vector<Prop*> dynamicCasters;
+		//lights are ranked by how much of the views they reach, the alwaysUpdated highest ranked ones and shadow maps
+		//that were never drawn are updated every frame, the others take turns within the budgets, point lights one
+		//cube face at a time, a budget of 0 is unlimited
+		int alwaysUpdated = 4;
+		int drawBudget = 2000;
+		float timeBudget = 2.0f;
+		std::vector<std::pair<float, Node*>> schedule;
+		int drawnCasters = 0;
+	}shadows;
+	//what the shadow maps of the current frame are drawn with
+	struct
+	{
+		uint64_t frame = 0;
+		std::chrono::steady_clock::time_point start;
+		uint64_t movedSince = 0;
+		uint64_t settings = 0;
+	}current;
+	//cameras whose cascades are kept in the atlas, their index picks the first cascade of their view,
+	//views that weren't drawn during the last frame give up their cascades
+	struct View
+	{
+		Camera const* camera = nullptr;
+		bool allocated = false;
+		bool drawn = false;
+	};
+	std::vector<View> views;
+
+public:
+	RenderContext(Scene const& scene);
+	RenderContext(RenderContext const&) = delete;
+	RenderContext(RenderContext&&) = delete;
+	RenderContext& operator=(RenderContext const&) = delete;
+	RenderContext& operator=(RenderContext&&) = delete;
+	~RenderContext() = default;
+
+private:
+	void resizeShadowMaps();
+	int getView(Camera const& camera);
+	float getViewDistance(glm::vec3 const& position) const;
+	void allocateShadowMaps();
+	std::array<float, ShadowAtlas::maxCascades + 1> getCascadeSplits(Camera const& camera) const;
+	glm::mat4 getCascadeLightSpace(Camera const& camera, glm::vec3 lightDirection, float nearSplit, float farSplit, int tileSize) const;
+	template<typename Volume>
+	std::vector<Prop*> const& cullCasters(Volume const& volume);
+	bool overBudget() const;
+	//draws the stale faces of the layers whose light or casters changed, returns false when nothing was drawn
+	bool renderCasters(Node const* light, uint64_t lightSignature, std::vector<Prop*> const& casters,
+		std::function<void(std::vector<Prop*> const&, int)> const& draw, bool always, int cascade = 0);
+	void renderCascades(Camera const& camera, int firstCascade, DepthRenderer const& renderDepth);
+	void renderSpotLight(SpotLight* light, bool always, DepthRenderer const& renderDepth);
+	void renderPointLight(PointLight* light, bool always, DepthRenderer const& renderDepth);
+	void renderLocalLights(float attenuationCutoff, DepthRenderer const& renderDepth);
+
+public:
+	//the first call of a frame allocates every shadow map and draws the ones of spot and point lights, cascades are drawn
+	//for the camera's view, returns the first cascade of the view
+	int updateShadows(uint64_t frame, Camera const& camera, float attenuationCutoff, DepthRenderer const& renderDepth);
+	ShadowAtlas& getShadowAtlas();
+	void drawUI();
+
+};
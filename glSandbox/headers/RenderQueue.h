@@ -0,0 +1,103 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class Prop;
+class Mesh;
+class Shader;
+
+//retained draw items for the props of a scene, ordered by packed keys laid out as
+//pass | shader | material | mesh | depth, so consecutive draws share as much state as possible,
+//while more materials, meshes or arena pools are in use than their fields can tell apart, props are
+//ordered by comparing their state instead
+class RenderQueue
+{
+public:
+	enum class Pass
+	{
+		opaque,
+		shadow,
+		highlight,
+		wireframe
+	};
+	static constexpr int depthBits = 16;
+	static constexpr int meshBits = 20;
+	//high bits of the mesh field, so meshes of one arena pool sort next to each other
+	static constexpr int poolBits = 4;
+	static constexpr int materialBits = 16;
+	static constexpr int shaderBits = 8;
+	static constexpr int passBits = 4;
+	static_assert(depthBits + meshBits + materialBits + shaderBits + passBits == 64);
+
+private:
+	//ids of the materials and meshes in the queue, released ids are handed out again
+	struct IDs
+	{
+		struct Reference
+		{
+			uint64_t id;
+			int count;
+		};
+		std::unordered_map<void const*, Reference> references;
+		std::vector<uint64_t> released;
+		uint64_t next = 0;
+	};
+	//state holds the material and mesh fields, patched when the prop changes,
+	//along with what they were made from, so their ids can be released
+	struct Item
+	{
+		Prop* prop = nullptr;
+		uint64_t state = 0;
+		void const* material = nullptr;
+		Mesh const* mesh = nullptr;
+		bool overflowing = false;
+		bool outdated = false;
+	};
+	struct Entry
+	{
+		uint64_t key;
+		int item;
+	};
+	std::vector<Item> items;
+	std::vector<int> freeItems;
+	std::vector<int> outdatedItems;
+	IDs materialIDs;
+	IDs meshIDs;
+	//items whose ids don't fit their fields
+	int overflowingItems = 0;
+	mutable std::unordered_map<void const*, uint64_t> shaderIDs;
+	mutable std::vector<Entry> entries;
+	mutable std::vector<Entry> scratch;
+
+public:
+	RenderQueue() = default;
+	RenderQueue(RenderQueue const&) = delete;
+	RenderQueue(RenderQueue&&) = default;
+	RenderQueue& operator=(RenderQueue const&) = delete;
+	RenderQueue& operator=(RenderQueue&&) = default;
+	~RenderQueue() = default;
+
+private:
+	static uint64_t getShaderID(std::unordered_map<void const*, uint64_t>& ids, void const* object);
+	static uint64_t acquireID(IDs& ids, void const* object);
+	static void releaseID(IDs& ids, void const* object);
+	//acquires the ids of the prop's current material and mesh, then releases the ones the item had
+	void updateState(Item& item);
+	void releaseState(Item& item);
+	void radixSort() const;
+	void comparisonSort(bool useMaterials) const;
+
+public:
+	void insert(Prop* prop);
+	void remove(Prop* prop);
+	void outdated(Prop* prop);
+	void update();
+	int getSize() const;
+	//orders props, which have to be in the queue, front to back within equal state,
+	//the material field is left out when the pass doesn't use materials, a range of 0 leaves out depth
+	void sort(std::vector<Prop*> const& props, Pass pass, Shader const* shader, bool useMaterials,
+		glm::vec3 const& eye, float range, std::vector<Prop*>& out) const;
+
+};
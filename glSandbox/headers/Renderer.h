@@ -5,13 +5,20 @@
 #include "Grid.h"
 #include "Texture.h"
 #include "Cubemap.h"
+#include "OcclusionCuller.h"
+#include "RenderQueue.h"
+#include "LightClusters.h"
+#include "RingBuffer.h"
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <vector>
+#include <utility>
 
 class Camera;
 class Scene;
+class Prop;
+class Node;
 
 class Renderer : public AutoName<Renderer>
 {
@@ -24,7 +31,10 @@ private:
 	unsigned int simpleFramebuffer = 0;
 	unsigned int simpleColorbuffer = 0;
 	unsigned int simpleRenderbuffer = 0;
-	bool explicitRendering = false;
+	//when enabled, frames are only rendered when the timestamps of what they are rendered from change, or when asked to,
+	//not everything that can change the image is timestamped, so it is left off by default
+	bool skipUnchangedFrames = false;
+	mutable uint64_t renderedTimestamp = 0;
 	mutable bool _shouldRender = true;
 	mutable bool shouldRenderSecondary = true;
 	struct {
@@ -49,6 +59,39 @@ private:
 		bool overlay = false;
 		bool boundingBox = false;
 	}highlighting;
+	struct{
+		bool frustum = true;
+		mutable std::vector<Prop*> visibleProps;
+		mutable int culledProps = 0;
+		bool occlusion = false;
+		int maxOccluders = 16;
+		float minOccluderSize = 0.01f;
+		mutable OcclusionCuller occlusionCuller;
+		mutable std::vector<std::pair<float, Prop*>> occluders;
+		mutable int occludedProps = 0;
+		mutable float occlusionTime = 0.0f;
+	}culling;
+	//camera matrices and per draw data of the frame are written to a persistently mapped ring buffer
+	mutable RingBuffer frameData;
+	//props sharing a mesh and material are drawn with one call, indexing their per draw data by instance,
+	//with multi draw indirect every run of props sharing a material and mesh arena pool is one call
+	struct{
+		bool enabled = true;
+		bool multiDrawIndirect = true;
+		mutable std::vector<Prop*> drawn;
+		mutable std::vector<Prop*> sorted;
+		mutable int drawCalls = 0;
+		mutable int indirectCommands = 0;
+	}instancing;
+	//draws are ordered by the render queue of the scene, unsorted counts are what the given order would have needed
+	struct{
+		mutable int materialBinds = 0;
+		mutable int skippedMaterialBinds = 0;
+		mutable int unsortedMaterialBinds = 0;
+		mutable int unsortedRedundantMaterialBinds = 0;
+		mutable int meshSwitches = 0;
+		mutable int unsortedMeshSwitches = 0;
+	}stateChanges;
 	struct{
 		Shader* current = ShaderManager::unlit();
 		struct
@@ -76,21 +119,11 @@ private:
 			bool unlitShowAlphaChannel = true;
 		}debugging;
 		struct{
+			//shadow maps are drawn by the render context of the scene, shared with the other renderers showing it,
+			//only how they are sampled is up to every renderer
 			struct
 			{
 				bool enabled = true;
-				bool faceCulling = true;
-				int faceCullingMode = GL_BACK;
-				int resolution = 11;
-				float directionalLightProjectionSize = 10.0f;
-				float spotLightNearPlane = 0.1f;
-				float spotLightFarPlane = 20.0f;
-				float pointLightNearPlane = 0.1f;
-				float pointLightFarPlane = 100.0f;
-				mutable std::vector<Texture> shadowMapsD;
-				mutable std::vector<Texture> shadowMapsS;
-				mutable std::vector<Cubemap> shadowMapsP;
-				int showMap = -1;
 				int depthComparison = GL_LEQUAL;
 				float bias[2] = {0.0005f, 0.0020f};
 				bool usePoissonSampling = false;
@@ -105,6 +138,8 @@ private:
 				float pcfRadius[2] = {0.5f, 10.0f};
 				bool pcfEarlyExit = true;
 			}shadows;
+			//used by lighting shaders that read their lights from storage buffers
+			mutable LightClusters clusters;
 			float ambientStrength = 1.0f;
 		}lighting;
 	}shading;
@@ -146,6 +181,8 @@ public:
 	~Renderer();
 
 private:
+	//the latest timestamp of the scene, including the camera, and of the materials, textures and shaders
+	uint64_t getDependencyTimestamp() const;
 	bool skipFrame() const;
 	void configureFramebuffers() const;
 	void configureDepthTesting() const;
@@ -154,11 +191,16 @@ private:
 	void clearBuffers() const;
 	void renderAuxiliaryGeometry() const;
 	void renderLights() const;
-	void updateShadowMaps() const;
-	void renderShadowMaps() const;
+	//returns the first cascade of the view's directional light shadows
+	int renderShadowMaps() const;
 	void configureShaders() const;
 	void renderHighlightedProps() const;
-	void renderProps(Shader* shader) const;
+	void cullProps() const;
+	void cullOccludedProps(glm::mat4 const& viewProjection) const;
+	void renderProps(Shader* shader, std::vector<Prop*> const& props) const;
+	//depth only passes skip materials, highlighting and wireframes, and draw from the packed positions of the meshes
+	void renderDepth(Shader* shader, std::vector<Prop*> const& props) const;
+	void drawProps(Shader* shader, std::vector<Prop*> const& props, RenderQueue::Pass pass, bool useMaterials) const;
 	void renderSkybox() const;
 	void updateFramebuffers();
 
@@ -0,0 +1,61 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+#include <vector>
+
+//persistently mapped buffer split into one region per frame in flight, a region is written again only after the fence
+//placed at the end of its last frame has signaled, so writes go straight to memory the gpu reads without driver copies
+class RingBuffer
+{
+public:
+	struct Allocation
+	{
+		void* data = nullptr;
+		unsigned int buffer = 0;
+		GLintptr offset = 0;
+		GLsizeiptr size = 0;
+	};
+	static constexpr int frames = 3;
+
+private:
+	unsigned int buffer = 0;
+	std::byte* mapping = nullptr;
+	GLsizeiptr regionSize = 0;
+	int region = 0;
+	GLsizeiptr head = 0;
+	GLsync fences[frames] = {};
+	//buffers outgrown during a frame stay alive until the frame has been submitted
+	std::vector<unsigned int> retired;
+	int uniformAlignment = 0;
+	int storageAlignment = 0;
+	struct
+	{
+		GLsizeiptr used = 0;
+		int waits = 0;
+		int growths = 0;
+	}stats;
+
+public:
+	RingBuffer(GLsizeiptr regionSize = 1 << 20);
+	RingBuffer(RingBuffer const&) = delete;
+	RingBuffer(RingBuffer&&) = delete;
+	RingBuffer& operator=(RingBuffer const&) = delete;
+	RingBuffer& operator=(RingBuffer&&) = delete;
+	~RingBuffer();
+
+private:
+	void createStorage(GLsizeiptr regionSize);
+	void releaseFences();
+	Allocation allocate(GLsizeiptr size, GLsizeiptr alignment);
+
+public:
+	void beginFrame();
+	void endFrame();
+	//aligned for binding with glBindBufferRange to the respective target
+	Allocation allocateUniform(GLsizeiptr size);
+	Allocation allocateStorage(GLsizeiptr size);
+	//for draw commands read from GL_DRAW_INDIRECT_BUFFER
+	Allocation allocateIndirect(GLsizeiptr size);
+	void drawUI();
+
+};
@@ -0,0 +1,219 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define SIMD_SSE
+#include <xmmintrin.h>
+#endif
+//avx kernels are built whatever the target instruction set, and only run when the cpu supports them
+#if defined(_M_X64) || defined(__x86_64__)
+#define SIMD_AVX
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SIMD_TARGET_AVX
+#else
+#define SIMD_TARGET_AVX __attribute__((target("avx")))
+#endif
+#endif
+
+namespace simd
+{
+	inline bool hasAVX()
+	{
+#if defined(SIMD_AVX) && defined(_MSC_VER)
+		static bool const supported = [](){
+			int info[4];
+			__cpuid(info, 1);
+			//the os has to save the ymm registers too
+			bool const osxsave = info[2] & (1 << 27);
+			bool const avx = info[2] & (1 << 28);
+			return osxsave && avx && (_xgetbv(0) & 6) == 6;
+		}();
+		return supported;
+#elif defined(SIMD_AVX)
+		static bool const supported = __builtin_cpu_supports("avx");
+		return supported;
+#else
+		return false;
+#endif
+	}
+
+	//out may alias either operand
+	inline void multiply(glm::mat4 const& lhs, glm::mat4 const& rhs, glm::mat4& out)
+	{
+#ifdef SIMD_SSE
+		__m128 const c0 = _mm_loadu_ps(&lhs[0][0]);
+		__m128 const c1 = _mm_loadu_ps(&lhs[1][0]);
+		__m128 const c2 = _mm_loadu_ps(&lhs[2][0]);
+		__m128 const c3 = _mm_loadu_ps(&lhs[3][0]);
+		for(int i = 0; i < 4; i++)
+		{
+			__m128 column = _mm_mul_ps(c0, _mm_set1_ps(rhs[i][0]));
+			column = _mm_add_ps(column, _mm_mul_ps(c1, _mm_set1_ps(rhs[i][1])));
+			column = _mm_add_ps(column, _mm_mul_ps(c2, _mm_set1_ps(rhs[i][2])));
+			column = _mm_add_ps(column, _mm_mul_ps(c3, _mm_set1_ps(rhs[i][3])));
+			_mm_storeu_ps(&out[i][0], column);
+		}
+#else
+		out = lhs * rhs;
+#endif
+	}
+
+	//boxes with one array per component, so consecutive boxes fill a register
+	struct BoundsSoA
+	{
+		std::vector<float> min[3];
+		std::vector<float> max[3];
+
+		int size() const
+		{
+			return int(min[0].size());
+		}
+
+		void resize(int size)
+		{
+			for(int i = 0; i < 3; i++)
+			{
+				min[i].resize(size);
+				max[i].resize(size);
+			}
+		}
+
+		void set(int index, glm::vec3 const& boxMin, glm::vec3 const& boxMax)
+		{
+			for(int i = 0; i < 3; i++)
+			{
+				min[i][index] = boxMin[i];
+				max[i][index] = boxMax[i];
+			}
+		}
+
+		glm::vec3 getMin(int index) const
+		{
+			return {min[0][index], min[1][index], min[2][index]};
+		}
+
+		glm::vec3 getMax(int index) const
+		{
+			return {max[0][index], max[1][index], max[2][index]};
+		}
+	};
+
+#ifdef SIMD_AVX
+	//eight boxes at a time, returns how many were transformed
+	SIMD_TARGET_AVX inline int transformBoundsAVX(glm::mat4 const* transformations, BoundsSoA const& in, BoundsSoA& out)
+	{
+		int const count = in.size();
+		int i = 0;
+		__m256 const half8 = _mm256_set1_ps(0.5f);
+		__m256 const sign8 = _mm256_set1_ps(-0.0f);
+		for(; i + 8 <= count; i += 8)
+		{
+			//transposed, m[column][row] holds that element of all eight transformations
+			__m256 m[4][4];
+			for(int column = 0; column < 4; column++)
+			{
+				__m128 low[4];
+				__m128 high[4];
+				for(int j = 0; j < 4; j++)
+				{
+					low[j] = _mm_loadu_ps(&transformations[i + j][column][0]);
+					high[j] = _mm_loadu_ps(&transformations[i + j + 4][column][0]);
+				}
+				_MM_TRANSPOSE4_PS(low[0], low[1], low[2], low[3]);
+				_MM_TRANSPOSE4_PS(high[0], high[1], high[2], high[3]);
+				for(int row = 0; row < 4; row++)
+					m[column][row] = _mm256_insertf128_ps(_mm256_castps128_ps256(low[row]), high[row], 1);
+			}
+			__m256 center[3];
+			__m256 extent[3];
+			for(int axis = 0; axis < 3; axis++)
+			{
+				__m256 const boxMin = _mm256_loadu_ps(&in.min[axis][i]);
+				__m256 const boxMax = _mm256_loadu_ps(&in.max[axis][i]);
+				center[axis] = _mm256_mul_ps(_mm256_add_ps(boxMin, boxMax), half8);
+				extent[axis] = _mm256_mul_ps(_mm256_sub_ps(boxMax, boxMin), half8);
+			}
+			for(int row = 0; row < 3; row++)
+			{
+				__m256 transformedCenter = m[3][row];
+				__m256 transformedExtent = _mm256_setzero_ps();
+				for(int column = 0; column < 3; column++)
+				{
+					transformedCenter = _mm256_add_ps(transformedCenter, _mm256_mul_ps(m[column][row], center[column]));
+					transformedExtent = _mm256_add_ps(transformedExtent, _mm256_mul_ps(_mm256_andnot_ps(sign8, m[column][row]), extent[column]));
+				}
+				_mm256_storeu_ps(&out.min[row][i], _mm256_sub_ps(transformedCenter, transformedExtent));
+				_mm256_storeu_ps(&out.max[row][i], _mm256_add_ps(transformedCenter, transformedExtent));
+			}
+		}
+		//keeps the sse code that follows from paying for the upper halves
+		_mm256_zeroupper();
+		return i;
+	}
+#endif
+
+	//same as Bounds::operator*= for every box, each with its own affine transformation, in may be out
+	inline void transformBounds(glm::mat4 const* transformations, BoundsSoA const& in, BoundsSoA& out)
+	{
+		int const count = in.size();
+		out.resize(count);
+		int i = 0;
+#ifdef SIMD_AVX
+		if(hasAVX())
+			i = transformBoundsAVX(transformations, in, out);
+#endif
+#ifdef SIMD_SSE
+		__m128 const half4 = _mm_set1_ps(0.5f);
+		__m128 const sign4 = _mm_set1_ps(-0.0f);
+		for(; i + 4 <= count; i += 4)
+		{
+			__m128 m[4][4];
+			for(int column = 0; column < 4; column++)
+			{
+				for(int j = 0; j < 4; j++)
+					m[column][j] = _mm_loadu_ps(&transformations[i + j][column][0]);
+				_MM_TRANSPOSE4_PS(m[column][0], m[column][1], m[column][2], m[column][3]);
+			}
+			__m128 center[3];
+			__m128 extent[3];
+			for(int axis = 0; axis < 3; axis++)
+			{
+				__m128 const boxMin = _mm_loadu_ps(&in.min[axis][i]);
+				__m128 const boxMax = _mm_loadu_ps(&in.max[axis][i]);
+				center[axis] = _mm_mul_ps(_mm_add_ps(boxMin, boxMax), half4);
+				extent[axis] = _mm_mul_ps(_mm_sub_ps(boxMax, boxMin), half4);
+			}
+			for(int row = 0; row < 3; row++)
+			{
+				__m128 transformedCenter = m[3][row];
+				__m128 transformedExtent = _mm_setzero_ps();
+				for(int column = 0; column < 3; column++)
+				{
+					transformedCenter = _mm_add_ps(transformedCenter, _mm_mul_ps(m[column][row], center[column]));
+					transformedExtent = _mm_add_ps(transformedExtent, _mm_mul_ps(_mm_andnot_ps(sign4, m[column][row]), extent[column]));
+				}
+				_mm_storeu_ps(&out.min[row][i], _mm_sub_ps(transformedCenter, transformedExtent));
+				_mm_storeu_ps(&out.max[row][i], _mm_add_ps(transformedCenter, transformedExtent));
+			}
+		}
+#endif
+		for(; i < count; i++)
+		{
+			glm::vec3 const boxMin = in.getMin(i);
+			glm::vec3 const boxMax = in.getMax(i);
+			glm::vec3 const center = (boxMin + boxMax) * 0.5f;
+			glm::vec3 const extent = (boxMax - boxMin) * 0.5f;
+			glm::vec3 transformedCenter = transformations[i][3];
+			glm::vec3 transformedExtent{0.0f};
+			for(int column = 0; column < 3; column++)
+			{
+				transformedCenter += glm::vec3{transformations[i][column]} * center[column];
+				transformedExtent += glm::abs(glm::vec3{transformations[i][column]}) * extent[column];
+			}
+			out.set(i, transformedCenter - transformedExtent, transformedCenter + transformedExtent);
+		}
+	}
+}
@@ -4,102 +4,172 @@
 #include "Lights.h"
 #include "Cubemap.h"
 #include "Timestamp.h"
+#include "TransformHierarchy.h"
+#include "BoundingVolumeHierarchy.h"
+#include "RenderQueue.h"
 
 #include <vector>
 #include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <cfloat>
 
 class Prop;
 class Camera;
 class Node;
+class RenderContext;
 
-class Scene : public AutoName<Scene>
+//the timestamp of a scene is the latest one of its nodes, or of its own settings
+class Scene : public AutoName<Scene>, public Timestamp
 {
+	friend class Node;
+
+public:
+	struct RaycastHit
+	{
+		Prop* prop;
+		int triangle;
+		float distance;
+		glm::vec3 position;
+	};
 
 private:
+	template<typename T>
+	struct Registry
+	{
+		std::vector<T*> all;
+		std::vector<T*> enabled;
+		bool enabledOutdated = true;
+	};
 	bool useSkybox = false;
 	glm::vec3 backgroundColor{0.0f, 0.015f, 0.015f};
 	Cubemap* skybox = nullptr;
 	std::unique_ptr<Node> root = std::make_unique<TransformedNode>();
 	float idealSize = 4.0f;
+	//opt in, global transformations are updated in one parents first pass over a flat copy of the tree,
+	//rebuilt along with the cache, instead of on demand through the nodes
+	bool useTransformHierarchy = false;
+	bool parallelTransformations = false;
 	mutable struct{
 		bool dirty = true;
-		std::vector<TransformedNode*> transformedNodes;
-		std::vector<Camera*> cameras;
-		std::vector<Prop*> props;
-		std::vector<DirectionalLight*> directionalLights;
-		std::vector<PointLight*> pointLights;
-		std::vector<SpotLight*> spotLights;
+		bool transformationsOutdated = true;
+		TransformHierarchy transformHierarchy;
 	}cache;
+	mutable std::tuple<Registry<TransformedNode>, Registry<Camera>, Registry<Prop>,
+		Registry<DirectionalLight>, Registry<PointLight>, Registry<SpotLight>, Registry<Light>> registries;
+	mutable bool lightsOutdated = true;
+	mutable BoundingVolumeHierarchy boundingVolumes;
+	mutable RenderQueue renderQueue;
+	//made on first use, it keeps a reference to the scene, so it is not moved along with it
+	mutable std::unique_ptr<RenderContext> renderContext;
 	Node* current = nullptr;
+	//outcome of the latest snapshot save, shown in the UI
+	std::string snapshotStatus;
 
 public:
 	Scene();
 	Scene(Scene const&) = delete;
 	Scene(Scene&&);
-	Scene(std::unique_ptr<Node>&& root);
+	//unprepared roots are taken as they are, without fitting them or adding default nodes
+	Scene(std::unique_ptr<Node>&& root, bool prepare = true);
 	Scene& operator=(Scene const&) = delete;
 	Scene& operator=(Scene&&) = delete;
-	~Scene() = default;
+	~Scene();
 
 private:
 	void addDefaultNodes();
 	void updateCache() const;
+	template<typename T>
+	Registry<T>& getRegistry() const;
+	void registerNode(Node* node);
+	void unregisterNode(Node* node);
+	void enabledOutdated(Node* node) const;
 
 protected:
 	std::string getNamePrefix() const override;
 
 public:
 	void cacheOutdated() const;
+	void transformationsOutdated() const;
+	void updateTransformations() const;
+	void boundsOutdated(Node* node) const;
+	BoundingVolumeHierarchy const& getBoundingVolumes() const;
+	//props whose mesh or material changed
+	void renderStateOutdated(Node* node) const;
+	RenderQueue const& getRenderQueue() const;
+	//work shared by the renderers showing the scene
+	RenderContext& getRenderContext() const;
 	Node* getRoot() const;
 	Node* getCurrent() const;
+	void setCurrent(Node* node);
 	template<typename T>
 	std::vector<T*> const& getAll() const;
 	template<typename T>
-	std::vector<T*> getAllEnabled() const;
+	std::vector<T*> const& getAllEnabled() const;
 	bool usesSkybox() const;
 	glm::vec3 const& getBackground() const;
 	Cubemap const* getSkyBox() const;
 	
+	//closest enabled prop along the ray, tested against the triangles of its mesh
+	std::optional<RaycastHit> raycast(glm::vec3 const& origin, glm::vec3 const& direction, float maxDistance = FLT_MAX) const;
 	void fitToIdealSize() const;
 	void drawUI();
 
 };
 
+template<typename T>
+Scene::Registry<T>& Scene::getRegistry() const
+{
+	return std::get<Registry<T>>(registries);
+}
+
 template<typename T>
 std::vector<T*> const& Scene::getAll() const
 {
-	if(cache.dirty)
-		updateCache();
-	if constexpr(std::is_same<T, TransformedNode>())
-		return cache.transformedNodes;
-	else if constexpr(std::is_same<T, Camera>())
-		return cache.cameras;
-	else if constexpr(std::is_same<T, Prop>())
-		return cache.props;
-	else if constexpr(std::is_same<T, DirectionalLight>())
-		return cache.directionalLights;
-	else if constexpr(std::is_same<T, PointLight>())
-		return cache.pointLights;
-	else if constexpr(std::is_same<T, SpotLight>())
-		return cache.spotLights;
-	else if constexpr(std::is_same<T, Light>())
+	auto& registry = getRegistry<T>();
+	if constexpr(std::is_same<T, Light>())
 	{
-		static std::vector<Light*> ret;
-		ret.clear();
-		ret.reserve(cache.directionalLights.size() + cache.pointLights.size() + cache.spotLights.size());
-		std::copy(cache.directionalLights.begin(), cache.directionalLights.end(), std::back_inserter(ret));
-		std::copy(cache.pointLights.begin(), cache.pointLights.end(), std::back_inserter(ret));
-		std::copy(cache.spotLights.begin(), cache.spotLights.end(), std::back_inserter(ret));
-		return ret;
+		if(lightsOutdated)
+		{
+			registry.all.clear();
+			for(auto light : getAll<DirectionalLight>())
+				registry.all.push_back(light);
+			for(auto light : getAll<PointLight>())
+				registry.all.push_back(light);
+			for(auto light : getAll<SpotLight>())
+				registry.all.push_back(light);
+			registry.enabledOutdated = true;
+			lightsOutdated = false;
+		}
 	}
+	return registry.all;
 }
 
 template<typename T>
-std::vector<T*> Scene::getAllEnabled() const
+std::vector<T*> const& Scene::getAllEnabled() const
 {
-	std::vector<T*> ret;
-	for(auto n : getAll<T>())
-		if(n->isEnabled())
-			ret.push_back(n);
-	return ret;
+	auto& all = getAll<T>();
+	auto& registry = getRegistry<T>();
+	if(registry.enabledOutdated)
+	{
+		registry.enabled.clear();
+		if constexpr(std::is_same<T, Light>())
+		{
+			for(auto light : getAllEnabled<DirectionalLight>())
+				registry.enabled.push_back(light);
+			for(auto light : getAllEnabled<PointLight>())
+				registry.enabled.push_back(light);
+			for(auto light : getAllEnabled<SpotLight>())
+				registry.enabled.push_back(light);
+		}
+		else
+		{
+			for(auto n : all)
+				if(n->isEnabled())
+					registry.enabled.push_back(n);
+		}
+		registry.enabledOutdated = false;
+	}
+	return registry.enabled;
 }
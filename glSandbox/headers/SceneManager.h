@@ -4,9 +4,23 @@
 
 class SceneManager : public ResourceManager<Scene>
 {
+public:
+	struct ImportStats
+	{
+		std::string file;
+		float milliseconds = 0.0f;
+		int nodes = 0;
+		int parents = 0;
+		int unpooledNodes = 0;
+		int spilledChildren = 0;
+		int slabAllocations = 0;
+	};
+
 public:
 	static void initialize();
 	static Scene* importGLTF(std::string_view const filename);
+	static Scene* loadSnapshot(std::string_view const filename);
+	static ImportStats const& getLastImport();
 	static Scene* basic();
 	static Scene* testShadowMapping();
 
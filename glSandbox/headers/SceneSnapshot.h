@@ -0,0 +1,25 @@
+#pragma once
+#include "ImportGLTF.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+class Scene;
+
+//versioned binary copy of a scene along with the meshes, materials and textures it references,
+//all references are offsets into the file, so loading maps it and reads every record in place
+class SceneSnapshot
+{
+public:
+	static constexpr uint32_t version = 2;
+	static constexpr char const* extension = ".glss";
+
+public:
+	//the scene name with everything a file name can't hold replaced, in the working directory
+	static std::string getFilename(std::string_view const sceneName);
+	static bool save(Scene const& scene, std::string_view const filename);
+	static std::optional<Asset> load(std::string_view const filename);
+
+};
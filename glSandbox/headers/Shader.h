@@ -1,5 +1,6 @@
 #pragma once
 #include "AutoName.h"
+#include "Timestamp.h"
 
 #include <glm\gtc\matrix_transform.hpp>
 #include <glad\glad.h>
@@ -12,34 +13,112 @@
 #include <unordered_map>
 #include <vector>
 #include <unordered_set>
+#include <deque>
 
-class Shader : public AutoName<Shader>
+class Shader : public AutoName<Shader>, public Timestamp
 {
+public:
+	//a uniform name interned once, every shader resolves it the first time it is set and caches the location
+	template <typename T>
+	class Uniform
+	{
+		friend class Shader;
+	private:
+		int slot;
+
+	public:
+		explicit Uniform(std::string_view const name)
+			:slot(Shader::getSlot(name))
+		{
+		}
+
+	};
+	//elements are named prefix + index + suffix and interned the first time they are accessed,
+	//Element can be a Uniform or any struct of them constructible from the element name
+	template <typename Element>
+	class UniformArray
+	{
+	private:
+		std::string const prefix;
+		std::string const suffix;
+		mutable std::vector<Element> elements;
+
+	public:
+		UniformArray(std::string prefix, std::string suffix = "")
+			:prefix(std::move(prefix)), suffix(std::move(suffix))
+		{
+		}
+
+	public:
+		Element const& operator[](int index) const
+		{
+			while(int(elements.size()) <= index)
+				elements.emplace_back(prefix + std::to_string(elements.size()) + suffix);
+			return elements[index];
+		}
+
+	};
+
 private:
+	static constexpr int unresolved = -2;
 	unsigned int ID = -1;
 	bool initialized = false;
+	bool instanced = false;
+	bool clusteredLighting = false;
+	//active uniforms of the linked program, array elements are listed individually as well as by their base name
+	std::deque<std::string> uniformNames;
+	std::unordered_map<std::string_view, int> uniformLocations;
+	mutable std::vector<int> slotLocations;
 	std::string const vertexPath;
 	std::string const fragmentPath;
 	std::optional<std::string const> const geometryPath;
+	std::optional<std::string const> const computePath;
+	//of the latest reload of any shader
+	static inline uint64_t latestTimestamp = 0;
 
 public:
 	Shader(std::string const vertexPath, std::string const fragmentPath, std::optional<std::string const> geometryPath = std::nullopt);
+	Shader(std::string const computePath);
 
 private:
+	static std::vector<std::string>& getSlotNames();
+	static int getSlot(std::string_view const name);
+	void introspect();
 	int getLocation(std::string_view const name) const;
+	int getLocation(int slot) const;
+	static void upload(int location, int value);
+	static void upload(int location, float value);
+	static void upload(int location, glm::vec2 const& value);
+	static void upload(int location, glm::vec3 const& value);
+	static void upload(int location, glm::vec4 const& value);
+	static void upload(int location, glm::mat4 const& value);
 
 protected:
 	std::string getNamePrefix() const override;
+	void updateTimestamp();
 
 public:
+	//renderers don't know which shaders they end up using, so they look at the latest reload of any
+	static uint64_t getLatestTimestamp();
 	void reload();
 	void use();
 	void validate();
+	//whether the vertex stage reads model matrices from the instance buffer
+	bool supportsInstancing() const;
+	//whether the fragment stage reads lights from the cluster buffers
+	bool supportsClusteredLighting() const;
 	void set(std::string_view const name, int value) const;
 	void set(std::string_view const name, float value) const;
 	void set(std::string_view const name, glm::vec2 const& value) const;
 	void set(std::string_view const name, glm::vec3 const& value) const;
 	void set(std::string_view const name, glm::vec4 const& value) const;
 	void set(std::string_view const name, glm::mat4 const& value) const;
+	void set(Uniform<int> const& uniform, int value) const;
+	void set(Uniform<float> const& uniform, float value) const;
+	void set(Uniform<glm::vec2> const& uniform, glm::vec2 const& value) const;
+	void set(Uniform<glm::vec3> const& uniform, glm::vec3 const& value) const;
+	void set(Uniform<glm::vec4> const& uniform, glm::vec4 const& value) const;
+	void set(Uniform<glm::mat4> const& uniform, glm::mat4 const& value) const;
+	int getUniformCount() const;
 	void drawUI();
 };
\ No newline at end of file
@@ -27,6 +27,7 @@ public:
 	static Shader* debugDepthBuffer();
 	static Shader* shadowMappingUnidirectional();
 	static Shader* shadowMappingOmnidirectional();
+	static Shader* clusterLights();
 	static Shader* skybox();
 	static Shader* gammaHDR();
 	static Shader* passthrough();
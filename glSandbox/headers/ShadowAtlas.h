@@ -0,0 +1,181 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class Node;
+
+//shadow maps of directional and spot lights are square tiles of one depth atlas, handed out by a quadtree, point lights
+//get layers of a cube map array, a light keeps its tile across frames until it stops asking for one or asks for another size
+//directional lights ask for one tile per cascade, the shadows of a light's cascades follow each other, lights seen by
+//several views ask for every view's cascades from a first cascade of their own
+//shadow maps are only redrawn when their light or casters change, casters that haven't moved lately are kept in a static
+//layer, a copy of the atlas and the cube array, which is copied back under the moving ones instead of redrawing it
+class ShadowAtlas
+{
+public:
+	enum class Layer
+	{
+		//the shadow map is drawn from scratch, without a static layer
+		all,
+		staticCasters,
+		//the static layer is copied into the shadow map, to draw the moving casters over it
+		dynamicCasters
+	};
+	//masks of the faces whose layers are out of date, tiles in the atlas only have face 0
+	struct Update
+	{
+		int staticFaces = 0;
+		int dynamicFaces = 0;
+		//the shadow map was never drawn, so it can't wait for later frames
+		bool fresh = false;
+	};
+	//matches the std430 layout of Shadow in the lighting shaders
+	struct Shadow
+	{
+		glm::mat4 lightSpace;
+		//offset and scale of the tile in the atlas, for point lights the cube array layer and far plane
+		glm::vec4 rect;
+		//view space depth up to which a cascade is used
+		float cascadeEnd;
+		float padding[3];
+	};
+	static constexpr int maxCascades = 4;
+	struct Tile
+	{
+		glm::ivec2 offset;
+		int size;
+	};
+
+private:
+	struct QuadNode
+	{
+		Tile tile;
+		int parent = -1;
+		//first of four consecutive nodes, -1 for leaves
+		int children = -1;
+		bool used = false;
+	};
+	struct Allocation
+	{
+		int node = -1;
+		int layer = -1;
+		//the size last asked for, tiles only get smaller than that when the atlas is full
+		int requestedSize = 0;
+		int shadow = -1;
+		//only set for the first cascade of a view, counts the cascades that got tiles this frame
+		int cascades = 0;
+		bool requested = false;
+		//what the shadow map was last drawn with, shadows keep it while their updates wait for later frames
+		glm::mat4 lightSpace{1.0f};
+		float cascadeEnd = 0.0f;
+		//signatures of what the shadow map is drawn from, a new tile starts out invalid and
+		//faces stay stale until they are drawn
+		struct
+		{
+			bool valid = false;
+			bool drawn = false;
+			uint64_t light = 0;
+			uint64_t staticCasters = 0;
+			uint64_t dynamicCasters = 0;
+			int staleStatic = 0;
+			int staleDynamic = 0;
+			//frames the stale faces have been waiting for
+			int deferredFrames = 0;
+		}cache;
+	};
+	int atlasSize = 0;
+	int cubeSize = 0;
+	int cubeLayers = 0;
+	unsigned int atlas = 0;
+	//shares the storage of the atlas, without depth comparison, so the atlas can be shown in the ui
+	unsigned int atlasView = 0;
+	unsigned int cubeArray = 0;
+	//created on first use, shadows without static layers don't pay for them
+	unsigned int staticAtlas = 0;
+	unsigned int staticCubeArray = 0;
+	unsigned int framebuffer = 0;
+	unsigned int shadowBuffer = 0;
+	std::vector<QuadNode> nodes;
+	std::vector<int> freeChildren;
+	std::vector<int> freeLayers;
+	//allocations are kept per light and cascade
+	using Key = std::pair<Node const*, int>;
+	struct KeyHash
+	{
+		std::size_t operator()(Key const& key) const;
+	};
+	std::unordered_map<Key, Allocation, KeyHash> allocations;
+	std::vector<Shadow> shadows;
+	struct
+	{
+		int tiles = 0;
+		int usedArea = 0;
+		int reallocations = 0;
+		int failures = 0;
+		int staticLayers = 0;
+		int dynamicLayers = 0;
+		int cached = 0;
+		int deferred = 0;
+	}stats;
+
+public:
+	ShadowAtlas(int atlasSize = 4096, int cubeSize = 1024, int cubeLayers = 4);
+	ShadowAtlas(ShadowAtlas const&) = delete;
+	ShadowAtlas(ShadowAtlas&&) = delete;
+	ShadowAtlas& operator=(ShadowAtlas const&) = delete;
+	ShadowAtlas& operator=(ShadowAtlas&&) = delete;
+	~ShadowAtlas();
+
+private:
+	void createTextures();
+	void createStaticTextures();
+	void deleteTextures();
+	void split(int node);
+	int allocateNode(int node, int size);
+	void freeNode(int node);
+	void release(Allocation& allocation);
+
+public:
+	//drops every tile, lights get new ones on their next request
+	void resize(int atlasSize, int cubeSize, int cubeLayers);
+	int getAtlasSize() const;
+	int getCubeSize() const;
+	int getCubeLayers() const;
+	void beginUpdate();
+	//returns the index of the light's shadow for this frame, or -1 if there is no room left
+	int request(Node const* light, int size, int cascade = 0);
+	//returns the number of cascades that got tiles, stopping at the first one without room
+	int requestCascades(Node const* light, int size, int cascades, int firstCascade = 0);
+	int requestCube(Node const* light, float farPlane);
+	//lights that didn't ask for a shadow since beginUpdate give up their tiles
+	void endUpdate();
+	//-1 for lights without a shadow this frame
+	int getShadow(Node const* light, int cascade = 0) const;
+	//0 for lights without a shadow this frame
+	int getCascades(Node const* light, int firstCascade = 0) const;
+	Tile getTile(Node const* light, int cascade = 0) const;
+	int getLayer(Node const* light) const;
+	//compares the signatures with the ones the light's shadow map was last drawn with and remembers them, a changed light
+	//or static layer makes every face of both layers stale, faces drawn since are left out of the returned masks
+	Update getUpdate(Node const* light, uint64_t lightSignature, uint64_t staticSignature, uint64_t dynamicSignature, int cascade = 0);
+	//counts the frame for stale shadows left waiting
+	void defer(Node const* light, int cascade = 0);
+	int getDeferredFrames(Node const* light, int cascade = 0) const;
+	//whether the last update left stale shadows waiting
+	bool hasDeferred() const;
+	//every shadow map is redrawn on its next update
+	void invalidate();
+	//binds the atlas, the cube array or their static copies for rendering a layer of the light's shadow map, and clears
+	//its part of it or copies the static layer into it, face -1 covers every face of a cube
+	void renderTo(Node const* light, Layer layer = Layer::all, int cascade = 0, int face = -1);
+	void setLightSpace(Node const* light, glm::mat4 const& lightSpace, float cascadeEnd = 0.0f, int cascade = 0);
+	void setDepthComparison(GLenum comparison);
+	//uploads the shadows of the frame and binds them to storage buffer 5
+	void use(int atlasUnit, int cubeArrayUnit) const;
+	void drawUI();
+
+};
@@ -0,0 +1,159 @@
+#pragma once
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+
+//move only vector keeping up to N elements inline, only spills to the heap past that
+template <typename T, int N>
+class SmallVector
+{
+private:
+	T* elements;
+	int count = 0;
+	int capacity = N;
+	alignas(T) unsigned char storage[N * sizeof(T)];
+
+public:
+	SmallVector()
+		: elements(reinterpret_cast<T*>(storage))
+	{
+	}
+	SmallVector(SmallVector const&) = delete;
+	SmallVector(SmallVector&& other)
+		: SmallVector()
+	{
+		*this = std::move(other);
+	}
+	SmallVector& operator=(SmallVector const&) = delete;
+	SmallVector& operator=(SmallVector&& other)
+	{
+		if(this == &other)
+			return *this;
+		clear();
+		release();
+		if(other.isInline())
+		{
+			for(int i = 0; i < other.count; i++)
+				new(elements + i) T(std::move(other.elements[i]));
+			count = other.count;
+			other.clear();
+		}
+		else
+		{
+			elements = other.elements;
+			count = other.count;
+			capacity = other.capacity;
+			other.elements = reinterpret_cast<T*>(other.storage);
+			other.count = 0;
+			other.capacity = N;
+		}
+		return *this;
+	}
+	~SmallVector()
+	{
+		clear();
+		release();
+	}
+
+private:
+	bool isInline() const
+	{
+		return elements == reinterpret_cast<T const*>(storage);
+	}
+	void release()
+	{
+		if(!isInline())
+			::operator delete(elements);
+		elements = reinterpret_cast<T*>(storage);
+		capacity = N;
+	}
+
+public:
+	bool isSpilled() const
+	{
+		return !isInline();
+	}
+	T* begin()
+	{
+		return elements;
+	}
+	T* end()
+	{
+		return elements + count;
+	}
+	T const* begin() const
+	{
+		return elements;
+	}
+	T const* end() const
+	{
+		return elements + count;
+	}
+	std::reverse_iterator<T const*> rbegin() const
+	{
+		return std::reverse_iterator<T const*>(end());
+	}
+	std::reverse_iterator<T const*> rend() const
+	{
+		return std::reverse_iterator<T const*>(begin());
+	}
+	int size() const
+	{
+		return count;
+	}
+	bool empty() const
+	{
+		return count == 0;
+	}
+	T& operator[](int index)
+	{
+		return elements[index];
+	}
+	T const& operator[](int index) const
+	{
+		return elements[index];
+	}
+	T& back()
+	{
+		return elements[count - 1];
+	}
+	void reserve(int newCapacity)
+	{
+		if(newCapacity <= capacity)
+			return;
+		T* newElements = static_cast<T*>(::operator new(newCapacity * sizeof(T)));
+		for(int i = 0; i < count; i++)
+		{
+			new(newElements + i) T(std::move(elements[i]));
+			elements[i].~T();
+		}
+		if(!isInline())
+			::operator delete(elements);
+		elements = newElements;
+		capacity = newCapacity;
+	}
+	void push_back(T&& element)
+	{
+		if(count == capacity)
+			reserve(capacity * 2);
+		new(elements + count) T(std::move(element));
+		count++;
+	}
+	T* erase(T const* position)
+	{
+		T* const ret = elements + (position - elements);
+		std::move(ret + 1, end(), ret);
+		count--;
+		elements[count].~T();
+		return ret;
+	}
+	void clear()
+	{
+		for(int i = 0; i < count; i++)
+			elements[i].~T();
+		count = 0;
+	}
+
+};
@@ -1,14 +1,16 @@
 #pragma once
 #include "glad/glad.h"
 #include "AutoName.h"
+#include "Timestamp.h"
 
 #include <string>
 #include <glm/glm.hpp>
 #include <optional>
 
-class Texture : public AutoName<Texture>
+class Texture : public AutoName<Texture>, public Timestamp
 {
 	friend class Cubemap;
+	friend class SceneSnapshot;
 private:
 	mutable bool allocated = false;
 	mutable unsigned int ID;
@@ -22,6 +24,8 @@ private:
 	bool linear = true;
 	bool hdr = false;
 	std::optional<std::string> path = std::nullopt;
+	//of the latest change of any texture, loading on first use doesn't count, it happens within the frame using it
+	static inline uint64_t latestTimestamp = 0;
 
 public:
 	Texture() = delete;
@@ -41,8 +45,10 @@ private:
 
 protected:
 	std::string getNamePrefix() const override;
+	void updateTimestamp();
 
 public:
+	static uint64_t getLatestTimestamp();
 	unsigned int getID() const;
 	int getWidth() const;
 	int getHeight() const;
@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+//every worker owns a queue, it pops its own work from the back and steals from the front of the others
+//threads outside the pool submit to a shared queue and help out while waiting
+class ThreadPool
+{
+private:
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> workers;
+	std::atomic<int> queuedTasks = 0;
+	std::atomic<int> pendingTasks = 0;
+	std::atomic<bool> stopping = false;
+	std::mutex sleepMutex;
+	std::condition_variable sleepCondition;
+	static thread_local ThreadPool* currentPool;
+	static thread_local int currentQueue;
+
+public:
+	ThreadPool(int workerCount);
+	ThreadPool(ThreadPool const&) = delete;
+	ThreadPool(ThreadPool&&) = delete;
+	ThreadPool& operator=(ThreadPool const&) = delete;
+	ThreadPool& operator=(ThreadPool&&) = delete;
+	~ThreadPool();
+
+private:
+	int getOwnQueue() const;
+	bool tryRunTask(int ownQueue);
+	void workerLoop(int ownQueue);
+
+public:
+	static ThreadPool& shared();
+	int getWorkerCount() const;
+	void submit(std::function<void()> task);
+	void wait();
+
+};
@@ -1,11 +1,14 @@
 #pragma once
-#include <chrono>
+#include <atomic>
+#include <cstdint>
 
+//timestamps are drawn from one counter shared by everything timestamped, so they also order the changes of different
+//objects and an object rolling up the changes of others only has to keep the latest one
 class Timestamp
 {
 private:
-	using chrono = std::chrono::steady_clock;
-	chrono::time_point timestamp = chrono::now();
+	static inline std::atomic<uint64_t> counter{0};
+	uint64_t timestamp = ++counter;
 
 protected:
 	Timestamp() = default;
@@ -18,13 +21,13 @@ protected:
 protected:
 	void updateTimestamp()
 	{
-		timestamp = chrono::now();
+		timestamp = ++counter;
 	}
 
 public:
-	chrono::time_point const& getTimestamp() const
+	uint64_t getTimestamp() const
 	{
 		return timestamp;
 	}
 
-};
\ No newline at end of file
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+
+class Node;
+class ThreadPool;
+
+//flat depth first copy of a node tree, every parent is stored before its children
+//and every subtree occupies a contiguous range, so subtrees can be updated independently,
+//nodes are still updated one at a time, reading their parent's global transformation from a contiguous copy
+class TransformHierarchy
+{
+private:
+	static constexpr int parallelGrainSize = 4096;
+	std::vector<Node*> nodes;
+	std::vector<int> parents;
+	std::vector<int> subtreeEnds;
+	std::vector<glm::mat4> globalTransformations;
+
+public:
+	TransformHierarchy() = default;
+	TransformHierarchy(TransformHierarchy const&) = delete;
+	TransformHierarchy(TransformHierarchy&&) = default;
+	TransformHierarchy& operator=(TransformHierarchy const&) = delete;
+	TransformHierarchy& operator=(TransformHierarchy&&) = default;
+	~TransformHierarchy() = default;
+
+private:
+	void updateRange(int begin, int end);
+	void updateSubtree(int root, ThreadPool& threadPool);
+
+public:
+	void rebuild(Node* root);
+	void update();
+	void update(ThreadPool& threadPool);
+	int getSize() const;
+
+};
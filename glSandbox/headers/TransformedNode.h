@@ -1,6 +1,7 @@
 #pragma once
 #include "Node.h"
 #include "UIUtilities.h"
+#include "Profiler.h"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -16,8 +17,11 @@ public:
 	Translation() = default;
 	virtual ~Translation() = default;
 
+protected:
+	virtual void transformationChanged() = 0;
+
 public:
-	glm::vec3& getLocalTranslation()
+	glm::vec3 getLocalTranslation() const
 	{
 		return localTranslation;
 	}
@@ -25,6 +29,7 @@ public:
 	void setLocalTranslation(glm::vec3 localTranslation)
 	{
 		this->localTranslation = localTranslation;
+		transformationChanged();
 	}
 
 	glm::mat4 getLocalTranslationMatrix() const
@@ -35,6 +40,7 @@ public:
 	void translate(glm::vec3 amount)
 	{
 		localTranslation += amount;
+		transformationChanged();
 	}
 
 };
@@ -50,15 +56,20 @@ public:
 	Scale() = default;
 	virtual ~Scale() = default;
 
+protected:
+	virtual void transformationChanged() = 0;
+
 public:
 	void setLocalScale(glm::vec3 localScale)
 	{
 		this->localScale = localScale;
+		transformationChanged();
 	}
 
 	void setLocalScale(float localScale)
 	{
 		this->localScale = glm::vec3{localScale};
+		transformationChanged();
 	}
 
 	glm::vec3 getLocalScale() const
@@ -84,17 +95,22 @@ public:
 	Rotation() = default;
 	virtual ~Rotation() = default;
 
+protected:
+	virtual void transformationChanged() = 0;
+
 public:
 	void setLocalRotation(glm::quat localRotation)
 	{
 		localPitch = glm::degrees(glm::eulerAngles(localRotation)).x;
 		this->localRotation = localRotation;
+		transformationChanged();
 	}
 
 	void setLocalRotation(glm::vec3 localRotation)
 	{
 		localPitch = localRotation.x;
 		this->localRotation = glm::quat(glm::radians(localRotation));
+		transformationChanged();
 	}
 
 	glm::quat getLocalRotation() const
@@ -132,6 +148,7 @@ public:
 		localPitch += pitchAmount;
 		localRotation = glm::angleAxis(glm::radians(yawAmount), glm::vec3{0.0f, 1.0f, 0.0f})
 			* localRotation * glm::angleAxis(glm::radians(pitchAmount), glm::vec3{1.0f, 0.0f, 0.0f});
+		transformationChanged();
 	}
 
 };
@@ -164,32 +181,14 @@ private:
 	template<typename Base>
 	using isTransformUsed = is_one_of<Base, TransformTypes...>;
 
-public:
-	void setLocalTransformation(glm::mat4&& m) override
+protected:
+	void transformationChanged() override
 	{
-		auto[t, r, s] = decomposeTransformation(m);
-		if constexpr(isTransformUsed<Translation>::value)
-		{
-			this->setLocalTranslation(t);
-		}
-		if constexpr(isTransformUsed<Rotation>::value)
-		{
-			this->setLocalRotation(r);
-		}
-		if constexpr(isTransformUsed<Scale>::value)
-		{
-			this->setLocalScale(s);
-		}
+		localTransformationOutdated();
 	}
 
-	void setGlobalTransformation(glm::mat4&& m) override
-	{
-		setLocalTransformation(glm::mat4(1.0f));
-		m = m * glm::inverse(getGlobalTransformation());
-		setLocalTransformation(std::move(m));
-	}
-
-	glm::mat4 getLocalTransformation() const override
+private:
+	glm::mat4 calculateLocalTransformation() const
 	{
 		glm::mat4 transformation{1.0f};
 
@@ -203,7 +202,7 @@ public:
 		return transformation;
 	}
 
-	glm::mat4 getGlobalTransformation() const override
+	glm::mat4 calculateGlobalTransformation() const
 	{
 		if(parent == nullptr)
 			return getLocalTransformation();
@@ -229,6 +228,84 @@ public:
 		}
 	}
 
+public:
+	static constexpr NodeType type = NodeType::transformedNode;
+
+public:
+	NodeType getType() const override
+	{
+		return type;
+	}
+
+	void setLocalTransformation(glm::mat4&& m) override
+	{
+		auto[t, r, s] = decomposeTransformation(m);
+		if constexpr(isTransformUsed<Translation>::value)
+		{
+			this->setLocalTranslation(t);
+		}
+		if constexpr(isTransformUsed<Rotation>::value)
+		{
+			this->setLocalRotation(r);
+		}
+		if constexpr(isTransformUsed<Scale>::value)
+		{
+			this->setLocalScale(s);
+		}
+	}
+
+	void setGlobalTransformation(glm::mat4&& m) override
+	{
+		setLocalTransformation(glm::mat4(1.0f));
+		m = m * glm::inverse(getGlobalTransformation());
+		setLocalTransformation(std::move(m));
+	}
+
+	glm::mat4 getLocalTransformation() const override
+	{
+		if(transformationCache.localOutdated)
+		{
+			transformationCache.local = calculateLocalTransformation();
+			transformationCache.localOutdated = false;
+			profiler::counters::transformationUpdates.increment();
+		}
+		return transformationCache.local;
+	}
+
+	glm::mat4 getGlobalTransformation() const override
+	{
+		if(transformationCache.globalOutdated)
+		{
+			transformationCache.global = calculateGlobalTransformation();
+			transformationCache.globalOutdated = false;
+			profiler::counters::transformationUpdates.increment();
+		}
+		return transformationCache.global;
+	}
+
+	std::tuple<glm::vec3, glm::quat, glm::vec3> getLocalComponents() const override
+	{
+		glm::vec3 translation{0.0f};
+		glm::quat rotation{1.0f, 0.0f, 0.0f, 0.0f};
+		glm::vec3 scale{1.0f};
+
+		if constexpr(isTransformUsed<Translation>::value)
+			translation = this->getLocalTranslation();
+		if constexpr(isTransformUsed<Rotation>::value)
+			rotation = this->getLocalRotation();
+		if constexpr(isTransformUsed<Scale>::value)
+			scale = this->getLocalScale();
+
+		return {translation, rotation, scale};
+	}
+
+	bool inheritsAllComponents() const override
+	{
+		return isTransformUsed<Translation>::value &&
+			isTransformUsed<Rotation>::value &&
+			isTransformUsed<Scale>::value;
+	}
+
 	template<typename Dummy = void>
 	std::enable_if_t<isTransformUsed<Translation>::value && 
 		isTransformUsed<Rotation>::value, Dummy>
@@ -0,0 +1,61 @@
+#pragma once
+#include "Geometry.h"
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+//bounding volume hierarchy over the triangles of a single mesh, in mesh space
+class TriangleBVH
+{
+public:
+	struct Hit
+	{
+		int triangle = -1;
+		float distance = 0.0f;
+		glm::vec2 barycentric{0.0f};
+	};
+	static constexpr int maxLeafSize = 4;
+
+private:
+	//interior nodes keep their children next to each other, starting at first
+	struct Node
+	{
+		glm::vec3 min;
+		int first = 0;
+		glm::vec3 max;
+		int count = 0;
+
+		bool isLeaf() const
+		{
+			return count > 0;
+		}
+	};
+	//precomputed for the intersection test, stored in leaf order
+	struct Triangle
+	{
+		glm::vec3 v0;
+		glm::vec3 e1;
+		glm::vec3 e2;
+	};
+	std::vector<Node> nodes;
+	std::vector<Triangle> triangles;
+	std::vector<int> triangleIndices;
+
+public:
+	//indices describe a triangle list
+	TriangleBVH(std::vector<glm::vec3> const& positions, std::vector<uint32_t> const& indices);
+	TriangleBVH(TriangleBVH const&) = delete;
+	TriangleBVH(TriangleBVH&&) = default;
+	TriangleBVH& operator=(TriangleBVH const&) = delete;
+	TriangleBVH& operator=(TriangleBVH&&) = default;
+	~TriangleBVH() = default;
+
+public:
+	int getTriangleCount() const;
+	int getNodeCount() const;
+	std::size_t getMemoryUsage() const;
+	//closest hit no further than maxDistance, distances are in units of the ray direction
+	bool raycast(Ray const& ray, float maxDistance, Hit& hit) const;
+
+};
@@ -145,48 +145,24 @@ public:
 		: min{point[0], point[1], point[2]}, max{min}
 	{
 	}
+	//arvo's method, transforms the center and grows the extent by the absolute linear part,
+	//exact for the affine transformations of the scene graph
 	Bounds& operator*=(glm::mat4 const& rhs)
 	{
 		if(!_empty)
 		{
-			std::array<glm::vec4, 8> corners;
-			int idx = 0;
-			for(int x = 0; x <= 1; x++)
+			glm::vec3 const center = (min + max) * 0.5f;
+			glm::vec3 const extent = (max - min) * 0.5f;
+			glm::vec3 transformedCenter = rhs[3];
+			glm::vec3 transformedExtent{0.0f};
+			for(int i = 0; i < 3; i++)
 			{
-				for(int y = 0; y <= 1; y++)
-				{
-					for(int z = 0; z <= 1; z++)
-					{
-						corners[idx++] = glm::vec4{
-							x ? min.x : max.x,
-							y ? min.y : max.y,
-							z ? min.z : max.z,
-							1.0f};
-					}
-				}
+				glm::vec3 const column = rhs[i];
+				transformedCenter += column * center[i];
+				transformedExtent += glm::abs(column) * extent[i];
 			}
-			bool initMinMax = false;
-			for(auto& corner : corners)
-			{
-				glm::vec4 transformedCorner = rhs * corner;
-				if(!initMinMax)
-				{
-					min = transformedCorner;
-					max = transformedCorner;
-					initMinMax = true;
-				}
-				for(int i = 0; i < 3; i++)
-				{
-					if(std::abs(transformedCorner[i]) > 2.0f)
-					{
-						volatile int a = 2;
-					}
-					min[i] = std::min(min[i], transformedCorner[i]);
-					max[i] = std::max(max[i], transformedCorner[i]);
-				}
-			}
-
-			normalize();
+			min = transformedCenter - transformedExtent;
+			max = transformedCenter + transformedExtent;
 		}
 		return *this;
 	}
@@ -1,7 +1,6 @@
 #version 460 core
-#define MAX_DIR_LIGHTS 256
-#define MAX_POINT_LIGHTS 256
-#define MAX_SPOT_LIGHTS 256
+#define POINT_LIGHT 1
+#define SPOT_LIGHT 2
 
 struct Material
 {
@@ -20,37 +19,41 @@ struct Material
 	sampler2D opacityMap;
 };
 
-struct DirLight
-{
-	vec3 color;
-	float intensity;
-	vec3 direction;
-};
-struct PointLight
-{
-	vec3 color;
-	float intensity;
-	vec3 position;
-};
-struct SpotLight
+//positions and directions are in view space
+struct Light
 {
 	vec3 color;
 	float intensity;
 	vec3 position;
+	float range;
 	vec3 direction;
 	float innerCutoff;
+	vec3 worldPosition;
 	float outerCutoff;
+	int type;
+	int shadow;
+	int cascades;
 };
 
 uniform Material material;
 uniform vec3 ambientColor;
 uniform float ambientStrength;
+//directional lights come first, point and spot lights are reached through the cluster of the fragment
+layout(std430, binding = 1) readonly buffer Lights
+{
+	Light lights[];
+};
+layout(std430, binding = 2) readonly buffer Clusters
+{
+	uvec4 clusterCounts;
+	vec4 clusterParameters;//tile size in pixels, depth slice scale and bias
+	uvec2 clusters[];//offset and count into clusterLights
+};
+layout(std430, binding = 3) readonly buffer ClusterLights
+{
+	uint clusterLights[];
+};
 uniform int nDirLights;
-uniform int nPointLights;
-uniform int nSpotLights;
-uniform DirLight dirLights[MAX_DIR_LIGHTS];
-uniform PointLight pointLights[MAX_POINT_LIGHTS];
-uniform SpotLight spotLights[MAX_SPOT_LIGHTS];
 
 in VS_OUT
 {
@@ -65,9 +68,10 @@ vec3 viewDirection = normalize(-fs_in.position);
 vec3 diffuseColor;
 vec3 specularColor;
 vec3 normal = normalize(fs_in.normal);
-vec3 calcDirLight(DirLight light);
-vec3 calcPointLight(PointLight light);
-vec3 calcSpotLight(SpotLight light);
+uint getCluster();
+vec3 calcDirLight(Light light);
+vec3 calcPointLight(Light light);
+vec3 calcSpotLight(Light light);
 vec3 ambient();
 
 void main()
@@ -95,16 +99,36 @@ void main()
 	vec3 result = vec3(0,0,0);
 
 	for(int i = 0; i < nDirLights; i++)
-		result += calcDirLight(dirLights[i]);
-
-	for(int i = 0; i < nPointLights; i++)
-		result += calcPointLight(pointLights[i]);
+		result += calcDirLight(lights[i]);
 
-	for(int i = 0; i < nSpotLights; i++)
-		result += calcSpotLight(spotLights[i]);
+	uvec2 cluster = clusters[getCluster()];
+	for(uint i = cluster.x; i < cluster.x + cluster.y; i++)
+	{
+		Light light = lights[clusterLights[i]];
+		if(light.type == POINT_LIGHT)
+			result += calcPointLight(light);
+		else
+			result += calcSpotLight(light);
+	}
 
 	FragColor = vec4(ambient() + result , 1.0f);
 }
+uint getCluster()
+{
+	uvec3 cluster;
+	cluster.xy = uvec2(gl_FragCoord.xy / clusterParameters.xy);
+	cluster.z = uint(max(log(-fs_in.position.z) * clusterParameters.z - clusterParameters.w, 0.0f));
+	cluster = min(cluster, clusterCounts.xyz - 1);
+	return cluster.x + clusterCounts.x * (cluster.y + clusterCounts.y * cluster.z);
+}
+
+//inverse square falloff, windowed to reach zero at the range lights are clustered by
+float attenuation(float distance, float range)
+{
+	float window = clamp(1.0f - pow(distance / range, 4.0f), 0.0f, 1.0f);
+	return window * window / (distance * distance);
+}
+
 vec3 ambient()
 {
 	return ambientStrength * ambientColor * diffuseColor;	
@@ -124,29 +148,29 @@ vec3 specular(vec3 lightDirection)
 	return m * specularColor;
 }
 
-vec3 calcDirLight(DirLight light)
+vec3 calcDirLight(Light light)
 {
 	vec3 lightDirection = normalize(-light.direction);
 
     return light.color * light.intensity * (diffuse(lightDirection) + specular(lightDirection));
 }
 
-vec3 calcPointLight(PointLight light)
+vec3 calcPointLight(Light light)
 {
 	float distance = length(light.position - fs_in.position);
-	float attenuation = 1.0 / (distance * distance);
 	vec3 lightDirection = normalize(light.position - fs_in.position);
 
-	return attenuation * light.color * light.intensity * (diffuse(lightDirection) + specular(lightDirection));
+	return attenuation(distance, light.range) * light.color * light.intensity * (diffuse(lightDirection) + specular(lightDirection));
 }
 
-vec3 calcSpotLight(SpotLight light)
+vec3 calcSpotLight(Light light)
 {
+	float distance = length(light.position - fs_in.position);
 	vec3 lightDirection = normalize(light.position - fs_in.position);
 
 	float theta = dot(lightDirection, normalize(-light.direction));
 	float epsilon = light.innerCutoff - light.outerCutoff;
 	float intensity = clamp((theta - light.outerCutoff) / epsilon, 0.0f, 1.0f);
 
-	return intensity * light.color * light.intensity * (diffuse(lightDirection) + specular(lightDirection));
+	return intensity * attenuation(distance, light.range) * light.color * light.intensity * (diffuse(lightDirection) + specular(lightDirection));
 }
\ No newline at end of file
@@ -1,14 +1,26 @@
-#version 420 core
+#version 460 core
 layout(std140) uniform Matrices
 {
 	uniform mat4 projection;
 	uniform mat4 view;
 };
 uniform mat4 model;
+uniform bool instanced;
+//normal is the inverse transpose of view * model
+struct Instance
+{
+	mat4 model;
+	mat4 normal;
+};
+layout(std430, binding = 0) readonly buffer Instances
+{
+	Instance instances[];
+};
 
 layout (location = 0) in vec3 position;
 
 void main()
 {
-	gl_Position = projection * view * model * vec4(position, 1.0f);
+	mat4 modelMatrix = instanced ? instances[gl_BaseInstance + gl_InstanceID].model : model;
+	gl_Position = projection * view * modelMatrix * vec4(position, 1.0f);
 }
\ No newline at end of file
@@ -1,10 +1,21 @@
-#version 420 core
+#version 460 core
 layout(std140, binding = 0) uniform CameraMatrices
 {
 	uniform mat4 projection;
 	uniform mat4 view;
 };
 uniform mat4 model;
+uniform bool instanced;
+//normal is the inverse transpose of view * model
+struct Instance
+{
+	mat4 model;
+	mat4 normal;
+};
+layout(std430, binding = 0) readonly buffer Instances
+{
+	Instance instances[];
+};
 
 layout (location = 0) in vec3 position;
 layout (location = 3) in vec2 textureCoordinates;
@@ -16,10 +27,11 @@ out VS_OUT
 
 void main()
 {
+	mat4 modelMatrix = instanced ? instances[gl_BaseInstance + gl_InstanceID].model : model;
 	vs_out.textureCoordinates = textureCoordinates;
 	while(vs_out.textureCoordinates.x > 1.0f)
 		vs_out.textureCoordinates.x -= 1.0f;
 	while(vs_out.textureCoordinates.y > 1.0f)
 		vs_out.textureCoordinates.y -= 1.0f;
-	gl_Position = projection * view * model * vec4(position, 1.0f);
+	gl_Position = projection * view * modelMatrix * vec4(position, 1.0f);
 }
\ No newline at end of file
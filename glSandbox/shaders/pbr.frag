@@ -1,32 +1,21 @@
 #version 460 core
-#define MAX_DIR_LIGHTS 1
-#define MAX_POINT_LIGHTS 1
-#define MAX_SPOT_LIGHTS 1
+#define POINT_LIGHT 1
+#define SPOT_LIGHT 2
 
-struct DirLight
-{
-	vec3 color;
-	float intensity;
-	vec3 direction;
-	sampler2DShadow shadowMap;
-};
-struct PointLight
-{
-	vec3 color;
-	float intensity;
-	vec3 position;
-	vec3 worldPosition;
-	samplerCubeShadow shadowMap;
-};
-struct SpotLight
+//positions and directions are in view space, shadow indexes shadows or is -1, directional lights own cascades shadows from there on
+struct Light
 {
 	vec3 color;
 	float intensity;
 	vec3 position;
+	float range;
 	vec3 direction;
 	float innerCutoff;
+	vec3 worldPosition;
 	float outerCutoff;
-	sampler2DShadow shadowMap;
+	int type;
+	int shadow;
+	int cascades;
 };
 
 struct Material
@@ -56,12 +45,34 @@ uniform bool useIrradianceMap;
 uniform samplerCube irradianceMap;
 uniform vec3 ambientColor;
 uniform float ambientStrength;
+//directional lights come first, point and spot lights are reached through the cluster of the fragment
+layout(std430, binding = 1) readonly buffer Lights
+{
+	Light lights[];
+};
+layout(std430, binding = 2) readonly buffer Clusters
+{
+	uvec4 clusterCounts;
+	vec4 clusterParameters;//tile size in pixels, depth slice scale and bias
+	uvec2 clusters[];//offset and count into clusterLights
+};
+layout(std430, binding = 3) readonly buffer ClusterLights
+{
+	uint clusterLights[];
+};
+struct Shadow
+{
+	mat4 lightSpace;
+	vec4 rect;//offset and scale of the tile in the atlas, for point lights the cube array layer and far plane
+	float cascadeEnd;//view space depth up to which a cascade is used
+};
+layout(std430, binding = 5) readonly buffer Shadows
+{
+	Shadow shadows[];
+};
 uniform int nDirLights;
-uniform int nPointLights;
-uniform int nSpotLights;
-uniform DirLight dirLights[MAX_DIR_LIGHTS];
-uniform PointLight pointLights[MAX_POINT_LIGHTS];
-uniform SpotLight spotLights[MAX_SPOT_LIGHTS];
+uniform sampler2DShadow shadowAtlas;
+uniform samplerCubeArrayShadow pointShadowMaps;
 uniform bool shadowMappingEnabled;
 uniform float shadowMappingBiasMin;
 uniform float shadowMappingBiasMax;
@@ -70,7 +81,6 @@ uniform int shadowMappingPoissonVariant;
 uniform int shadowMappingSamples;
 uniform float shadowMappingRadius[2];
 uniform bool shadowMappingEarlyExit;
-uniform float shadowMappingOmniFarPlane;
 uniform float cameraFarPlane;
 
 in VS_OUT
@@ -81,8 +91,6 @@ in VS_OUT
 	vec3 worldNormal;
 	mat3 TBN;
 	vec2 textureCoordinates;
-	vec4 positionLightSpaceD[MAX_DIR_LIGHTS];
-	vec4 positionLightSpaceS[MAX_SPOT_LIGHTS];
 } fs_in;
 
 out vec4 FragColor;
@@ -101,9 +109,10 @@ float shadowSamplingRadius =
 	* (shadowMappingRadius[1] - shadowMappingRadius[0]);
 
 vec3 calculateAmbientLight();
-vec3 calculateDirLight(DirLight light, vec4 positionInLightSpace);
-vec3 calculatePointLight(PointLight light);
-vec3 calculateSpotLight(SpotLight light, vec4 positionInLightSpace);
+uint getCluster();
+vec3 calculateDirLight(Light light);
+vec3 calculatePointLight(Light light);
+vec3 calculateSpotLight(Light light);
 
 void main()
 {
@@ -140,11 +149,16 @@ void main()
 	vec3 result = calculateAmbientLight() * occlusion + emission;
 	F0 = mix(F0, baseColor, metalness);
 	for(int i = 0; i < nDirLights; i++)
-		result += calculateDirLight(dirLights[i], fs_in.positionLightSpaceD[i]);
-	for(int i = 0; i < nPointLights; i++)
-		result += calculatePointLight(pointLights[i]);
-	for(int i = 0; i < nSpotLights; i++)
-		result += calculateSpotLight(spotLights[i], fs_in.positionLightSpaceS[i]);
+		result += calculateDirLight(lights[i]);
+	uvec2 cluster = clusters[getCluster()];
+	for(uint i = cluster.x; i < cluster.x + cluster.y; i++)
+	{
+		Light light = lights[clusterLights[i]];
+		if(light.type == POINT_LIGHT)
+			result += calculatePointLight(light);
+		else
+			result += calculateSpotLight(light);
+	}
 		
 	//result /= result + vec3(1.0f);//tonemap
 	//result = pow(result, vec3(1.0f / 2.2f));//gamma
@@ -153,74 +167,68 @@ void main()
 
 vec3 BRDF(vec3 lightDirection);
 float calculateShadowBias(vec3 lightDirection);
-float calculateShadowFactorPCF(vec4 coords, sampler2DShadow shadowMap, float bias);
-float calculateShadowFactorPCF(vec3 coords, samplerCubeShadow shadowMap, float bias);
-float calculateShadowFactorPoisson(vec4 coords, sampler2DShadow shadowMap, float bias);
-float calculateShadowFactorPoisson(vec3 coords, samplerCubeShadow shadowMap, float bias);
+int selectCascade(Light light);
+float calculateShadowFactor(Shadow shadow, float bias);
+float calculateShadowFactor(vec3 coords, Shadow shadow, float bias);
 
 vec3 fresnelSchlickRoughness(float cosTheta)
 {
     return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(1.0 - cosTheta, 5.0);
 }  
 
+uint getCluster()
+{
+	uvec3 cluster;
+	cluster.xy = uvec2(gl_FragCoord.xy / clusterParameters.xy);
+	cluster.z = uint(max(log(-fs_in.position.z) * clusterParameters.z - clusterParameters.w, 0.0f));
+	cluster = min(cluster, clusterCounts.xyz - 1);
+	return cluster.x + clusterCounts.x * (cluster.y + clusterCounts.y * cluster.z);
+}
+
+//inverse square falloff, windowed to reach zero at the range lights are clustered by
+float calculateAttenuation(float distance, float range)
+{
+	float window = clamp(1.0f - pow(distance / range, 4.0f), 0.0f, 1.0f);
+	return window * window / (distance * distance);
+}
 
-vec3 calculateDirLight(DirLight light, vec4 positionInLightSpace)
+vec3 calculateDirLight(Light light)
 {
 	vec3 lightDirection = normalize(-light.direction);
 	float fragmentOrientationToLight = max(dot(normal, lightDirection), 0.0f);
 	float shadowFactor = 1.0f;
-	if(shadowMappingEnabled && fragmentOrientationToLight > 0.0f)
-	{
-		if(shadowMappingUsePoisson)
-			shadowFactor = calculateShadowFactorPoisson(positionInLightSpace, 
-			light.shadowMap, calculateShadowBias(lightDirection));
-		else
-			shadowFactor = calculateShadowFactorPCF(positionInLightSpace, 
-			light.shadowMap, calculateShadowBias(lightDirection));
-	}
+	int cascade = shadowMappingEnabled && fragmentOrientationToLight > 0.0f ? selectCascade(light) : -1;
+	if(cascade >= 0)
+		shadowFactor = calculateShadowFactor(shadows[cascade], calculateShadowBias(lightDirection));
 	vec3 radiance = light.color * light.intensity * shadowFactor;
 	return BRDF(lightDirection) * radiance * fragmentOrientationToLight;
 }
 
-vec3 calculatePointLight(PointLight light)
+vec3 calculatePointLight(Light light)
 {
 	float distance = length(fs_in.position - light.position);
-	float attenuation = 1.0 / (distance * distance);
+	float attenuation = calculateAttenuation(distance, light.range);
 	vec3 lightDirection = normalize(-fs_in.position + light.position);
 	float fragmentOrientationToLight = max(dot(normal, lightDirection), 0.0f);
 	float shadowFactor = 1.0f;
-	if(shadowMappingEnabled && fragmentOrientationToLight > 0.0f)
-	{
-		if(shadowMappingUsePoisson)
-			shadowFactor = calculateShadowFactorPoisson(fs_in.worldPosition - light.worldPosition,
-			light.shadowMap, calculateShadowBias(lightDirection));
-		else
-			shadowFactor = calculateShadowFactorPCF(fs_in.worldPosition - light.worldPosition,
-			light.shadowMap, calculateShadowBias(lightDirection));
-	}
+	if(shadowMappingEnabled && light.shadow >= 0 && fragmentOrientationToLight > 0.0f)
+		shadowFactor = calculateShadowFactor(fs_in.worldPosition - light.worldPosition, shadows[light.shadow], calculateShadowBias(lightDirection));
 	vec3 radiance = light.color * light.intensity * attenuation * shadowFactor;
 	return BRDF(lightDirection) * radiance * fragmentOrientationToLight;
 }
 
-vec3 calculateSpotLight(SpotLight light, vec4 positionInLightSpace)
+vec3 calculateSpotLight(Light light)
 {
 	vec3 lightDirection = normalize(light.position - fs_in.position);
 	float theta = dot(lightDirection, normalize(-light.direction));
 	float epsilon = light.innerCutoff - light.outerCutoff;
 	float distance = length(light.position - fs_in.position);
-	float attenuation = 1.0 / (distance * distance);
+	float attenuation = calculateAttenuation(distance, light.range);
 	attenuation *= clamp((theta - light.outerCutoff) / epsilon, 0.0f, 1.0f);
 	float fragmentOrientationToLight = max(dot(normal, lightDirection), 0.0f);
 	float shadowFactor = 1.0f;
-	if(shadowMappingEnabled && fragmentOrientationToLight > 0.0f)
-	{
-		if(shadowMappingUsePoisson)
-			shadowFactor = calculateShadowFactorPoisson(positionInLightSpace, 
-			light.shadowMap, calculateShadowBias(lightDirection));
-		else
-			shadowFactor = calculateShadowFactorPCF(positionInLightSpace, 
-			light.shadowMap, calculateShadowBias(lightDirection));
-	}
+	if(shadowMappingEnabled && light.shadow >= 0 && fragmentOrientationToLight > 0.0f)
+		shadowFactor = calculateShadowFactor(shadows[light.shadow], calculateShadowBias(lightDirection));
 	vec3 radiance = light.color * light.intensity * attenuation * shadowFactor;
 	return BRDF(lightDirection) * radiance * fragmentOrientationToLight;
 }
@@ -298,24 +306,42 @@ float calculateShadowBias(vec3 lightDirection)
 	return max(shadowMappingBiasMax * (1.0 - dot(normal, lightDirection)), shadowMappingBiasMin);
 }
 
-float sampleShadow(vec3 coords, sampler2DShadow shadowMap, float bias)
+//cascades cover consecutive slices of the camera frustum, fragments beyond the last one are lit
+int selectCascade(Light light)
+{
+	if(light.shadow < 0)
+		return -1;
+	float depth = -fs_in.position.z;
+	for(int cascade = light.shadow; cascade < light.shadow + light.cascades; cascade++)
+		if(depth <= shadows[cascade].cascadeEnd)
+			return cascade;
+	return -1;
+}
+
+//samples are clamped to the tile, so filtering never reads its neighbours,
+//outside of the tile is outside of the light's frustum, which is lit
+float sampleShadow(vec3 coords, vec4 rect, float bias)
 {
-	return texture(shadowMap, vec3(coords.xy, coords.z - bias));
+	if(any(lessThan(coords.xy, vec2(0.0f))) || any(greaterThan(coords.xy, vec2(1.0f))))
+		return 1.0f;
+	vec2 halfTexel = 0.5f / textureSize(shadowAtlas, 0);
+	vec2 position = clamp(rect.xy + coords.xy * rect.zw, rect.xy + halfTexel, rect.xy + rect.zw - halfTexel);
+	return texture(shadowAtlas, vec3(position, coords.z - bias));
 }
 
-float sampleShadow(vec4 coords, samplerCubeShadow shadowMap)
+float sampleShadow(vec4 coords, float layer)
 {
-	return texture(shadowMap, coords);
+	return texture(pointShadowMaps, vec4(coords.xyz, layer), coords.w);
 }
 
-float calculateShadowFactorPCF(vec4 coords, sampler2DShadow shadowMap, float bias)
+float calculateShadowFactorPCF(vec4 coords, vec4 rect, float bias)
 {
 	coords /= coords.w;
 	coords = coords * 0.5 + 0.5;
-	float shadow = sampleShadow(coords.xyz, shadowMap, bias);
+	float shadow = sampleShadow(coords.xyz, rect, bias);
 	if(shadowMappingSamples == 0)
 		return shadow;
-	vec2 texelSize = shadowSamplingRadius / textureSize(shadowMap, 0);
+	vec2 texelSize = shadowSamplingRadius / (rect.zw * textureSize(shadowAtlas, 0));
 	//early exit test
 	vec3 corners[4] = {
 		vec3(-texelSize * shadowMappingSamples, 0.0f),
@@ -324,7 +350,7 @@ float calculateShadowFactorPCF(vec4 coords, sampler2DShadow shadowMap, float bia
 		vec3(+texelSize * shadowMappingSamples, 0.0f)
 	};
 	for(int i = 0; i < 4; i++)
-		shadow += sampleShadow(coords.xyz + corners[i], shadowMap, bias);
+		shadow += sampleShadow(coords.xyz + corners[i], rect, bias);
 	if(shadowMappingEarlyExit && (shadow == 0.0f || shadow == 5.0f))
 		return shadow / 5;
 
@@ -340,7 +366,7 @@ float calculateShadowFactorPCF(vec4 coords, sampler2DShadow shadowMap, float bia
 			|| offset == corners[2]
 			|| offset == corners[3])
 				continue;
-			shadow += sampleShadow(coords.xyz + offset, shadowMap, bias);
+			shadow += sampleShadow(coords.xyz + offset, rect, bias);
 		}    
 	}
 	float sampleCount = shadowMappingSamples * 2;
@@ -349,7 +375,7 @@ float calculateShadowFactorPCF(vec4 coords, sampler2DShadow shadowMap, float bia
 	return shadow / sampleCount;
 }
 
-float calculateShadowFactorPCF(vec3 coords, samplerCubeShadow shadowMap, float bias)
+float calculateShadowFactorPCF(vec3 coords, float layer, float farPlane, float bias)
 {
 	vec3 aux = vec3(0.0f, 1.0f, 0.0f);//use as helper vector to find base vectors
 	if(dot(coords, aux) == 1.0f)
@@ -357,12 +383,12 @@ float calculateShadowFactorPCF(vec3 coords, samplerCubeShadow shadowMap, float b
 	vec3 xBase = cross(aux, coords);
 	vec3 yBase = cross(aux, xBase);
 	//now do normal pcf sampling using x, y as offset base
-	float currentDepth = length(coords) / shadowMappingOmniFarPlane - bias;
-	float shadow = sampleShadow(vec4(coords, currentDepth), shadowMap);
+	float currentDepth = length(coords) / farPlane - bias;
+	float shadow = sampleShadow(vec4(coords, currentDepth), layer);
 	if(shadowMappingSamples == 0)
 		return shadow;
 	
-	vec2 texelSize = shadowSamplingRadius / textureSize(shadowMap, 0);
+	vec2 texelSize = shadowSamplingRadius / textureSize(pointShadowMaps, 0).xy;
 	//early exit test
 	vec3 corners[4] = {
 		(-texelSize.x * xBase -texelSize.y * yBase) * shadowMappingSamples,
@@ -371,7 +397,7 @@ float calculateShadowFactorPCF(vec3 coords, samplerCubeShadow shadowMap, float b
 		(+texelSize.x * xBase +texelSize.y * yBase) * shadowMappingSamples
 	};
 	for(int i = 0; i < 4; i++)
-		shadow += sampleShadow(vec4(coords + corners[i], currentDepth), shadowMap);
+		shadow += sampleShadow(vec4(coords + corners[i], currentDepth), layer);
 	if(shadowMappingEarlyExit && (shadow == 0.0f || shadow == 5.0f))
 		return shadow / 5;
 
@@ -387,7 +413,7 @@ float calculateShadowFactorPCF(vec3 coords, samplerCubeShadow shadowMap, float b
 			|| offset == corners[2]
 			|| offset == corners[3])
 				continue;
-			shadow += sampleShadow(vec4(coords + offset, currentDepth), shadowMap);
+			shadow += sampleShadow(vec4(coords + offset, currentDepth), layer);
 		}    
 	}
 	float sampleCount = shadowMappingSamples * 2;
@@ -437,11 +463,11 @@ float rand(vec4 seed)
 	return fract(sin(dot_product) * 43758.5453);
 }
 
-float calculateShadowFactorPoisson(vec4 coords, sampler2DShadow shadowMap, float bias)
+float calculateShadowFactorPoisson(vec4 coords, vec4 rect, float bias)
 {
 	coords /= coords.w;
 	coords = coords * 0.5 + 0.5;
-	vec2 texelSize = shadowSamplingRadius / textureSize(shadowMap, 0);
+	vec2 texelSize = shadowSamplingRadius / (rect.zw * textureSize(shadowAtlas, 0));
 	float shadow = 0.0f;
 	for(int i = 0; i < shadowMappingSamples; i++)
 	{
@@ -463,25 +489,40 @@ float calculateShadowFactorPoisson(vec4 coords, sampler2DShadow shadowMap, float
 		{
 			offset = poissonDisk[i];
 		}
-		shadow += sampleShadow(coords.xyz + vec3(texelSize * offset, 0.0f), shadowMap, bias);
+		shadow += sampleShadow(coords.xyz + vec3(texelSize * offset, 0.0f), rect, bias);
 	}
 	return shadow / shadowMappingSamples;
 }
 
-float calculateShadowFactorPoisson(vec3 coords, samplerCubeShadow shadowMap, float bias)
+float calculateShadowFactorPoisson(vec3 coords, float layer, float farPlane, float bias)
 {
 	vec3 aux = vec3(0.0f, 1.0f, 0.0f);//use as helper vector to find base vectors
 	if(dot(coords, aux) == 1.0f)
 		aux = vec3(0.0f, 0.0f, 1.0f);
 	vec3 xBase = cross(aux, coords);
 	vec3 yBase = cross(aux, xBase);
-	vec2 texelSize = shadowSamplingRadius / textureSize(shadowMap, 0);
-	float currentDepth = length(coords) / shadowMappingOmniFarPlane - bias;
+	vec2 texelSize = shadowSamplingRadius / textureSize(pointShadowMaps, 0).xy;
+	float currentDepth = length(coords) / farPlane - bias;
 	float shadow = 0.0f;
 	for(int i = 0; i < shadowMappingSamples; i++)
 	{
 		vec3 offset = texelSize.x * poissonDisk[i].x * xBase + texelSize.y * poissonDisk[i].y * yBase;
-		shadow += sampleShadow(vec4(coords + offset, currentDepth), shadowMap);
+		shadow += sampleShadow(vec4(coords + offset, currentDepth), layer);
 	}
 	return shadow / shadowMappingSamples;
+}
+
+float calculateShadowFactor(Shadow shadow, float bias)
+{
+	vec4 coords = shadow.lightSpace * vec4(fs_in.worldPosition, 1.0f);
+	if(shadowMappingUsePoisson)
+		return calculateShadowFactorPoisson(coords, shadow.rect, bias);
+	return calculateShadowFactorPCF(coords, shadow.rect, bias);
+}
+
+float calculateShadowFactor(vec3 coords, Shadow shadow, float bias)
+{
+	if(shadowMappingUsePoisson)
+		return calculateShadowFactorPoisson(coords, shadow.rect.x, shadow.rect.y, bias);
+	return calculateShadowFactorPCF(coords, shadow.rect.x, shadow.rect.y, bias);
 }
\ No newline at end of file
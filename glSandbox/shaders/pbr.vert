@@ -1,7 +1,4 @@
 #version 460 core
-#define MAX_DIR_LIGHTS 1
-#define MAX_POINT_LIGHTS 1
-#define MAX_SPOT_LIGHTS 1
 layout(std140, binding = 0) uniform CameraMatrices
 {
 	uniform mat4 projection;
@@ -9,11 +6,17 @@ layout(std140, binding = 0) uniform CameraMatrices
 };
 
 uniform mat4 model;
-uniform int nDirLights;
-uniform int nPointLights;
-uniform int nSpotLights;
-uniform mat4 lightSpacesD[MAX_DIR_LIGHTS];
-uniform mat4 lightSpacesS[MAX_SPOT_LIGHTS];
+uniform bool instanced;
+//normal is the inverse transpose of view * model
+struct Instance
+{
+	mat4 model;
+	mat4 normal;
+};
+layout(std430, binding = 0) readonly buffer Instances
+{
+	Instance instances[];
+};
 
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
@@ -29,23 +32,18 @@ out VS_OUT
 	vec3 worldNormal;
 	mat3 TBN;
 	vec2 textureCoordinates;
-	vec4 positionLightSpaceD[MAX_DIR_LIGHTS];
-	vec4 positionLightSpaceS[MAX_SPOT_LIGHTS];
 } vs_out;
 
 void main()
 {
-	vs_out.worldPosition = vec3(model * vec4(position, 1.0f));
+	mat4 modelMatrix = instanced ? instances[gl_BaseInstance + gl_InstanceID].model : model;
+	vs_out.worldPosition = vec3(modelMatrix * vec4(position, 1.0f));
 	vs_out.position = vec3(view * vec4(vs_out.worldPosition, 1.0f));
-	for(int i = 0; i < nDirLights; i++)
-		vs_out.positionLightSpaceD[i] = lightSpacesD[i] * model * vec4(position, 1.0f);
-	for(int i = 0; i < nSpotLights; i++)
-		vs_out.positionLightSpaceS[i] = lightSpacesS[i] * model * vec4(position, 1.0f);
-	mat3 normalMatrix = mat3(transpose(inverse(view * model)));
+	mat3 normalMatrix = instanced ? mat3(instances[gl_BaseInstance + gl_InstanceID].normal) : mat3(transpose(inverse(view * modelMatrix)));
 	vec3 t = vec3(1.0f, 0.0f, 0.0f);//normalMatrix * tangent.xyz;
 	vec3 b = vec3(1.0f, 1.0f, 1.0f);//normalMatrix * cross(normal, tangent.xyz) * tangent.w;
 	vs_out.normal = normalMatrix * normal;
 	vs_out.TBN = mat3(t, b, vs_out.normal);
 	vs_out.textureCoordinates = textureCoordinates;
-	gl_Position = projection * view * model * vec4(position, 1.0f);
+	gl_Position = projection * view * modelMatrix * vec4(position, 1.0f);
 }
\ No newline at end of file
@@ -5,6 +5,17 @@ layout(std140, binding = 0) uniform CameraMatrices
 	uniform mat4 view;
 };
 uniform mat4 model;
+uniform bool instanced;
+//normal is the inverse transpose of view * model
+struct Instance
+{
+	mat4 model;
+	mat4 normal;
+};
+layout(std430, binding = 0) readonly buffer Instances
+{
+	Instance instances[];
+};
 
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec3 normal;
@@ -19,8 +30,10 @@ out VS_OUT
 
 void main()
 {
-	vs_out.position = vec3(view * model * vec4(position, 1.0f));
-	vs_out.normal = mat3(transpose(inverse(view * model))) * normal;
+	mat4 modelMatrix = instanced ? instances[gl_BaseInstance + gl_InstanceID].model : model;
+	vs_out.position = vec3(view * modelMatrix * vec4(position, 1.0f));
+	mat3 normalMatrix = instanced ? mat3(instances[gl_BaseInstance + gl_InstanceID].normal) : mat3(transpose(inverse(view * modelMatrix)));
+	vs_out.normal = normalMatrix * normal;
 	vs_out.textureCoordinates = textureCoordinates;
-	gl_Position = projection * view * model * vec4(position, 1.0f);
+	gl_Position = projection * view * modelMatrix * vec4(position, 1.0f);
 }
\ No newline at end of file
@@ -1,10 +1,17 @@
-#version 420 core
+#version 460 core
 uniform mat4 lightSpace;
 uniform mat4 model;
+uniform bool instanced;
+//depth only passes get the model matrices alone, they never need normals
+layout(std430, binding = 0) readonly buffer Instances
+{
+	mat4 models[];
+};
 
 layout(location = 0) in vec3 position;
 
 void main()
 {
-	gl_Position = lightSpace * model * vec4(position, 1.0f);
+	mat4 modelMatrix = instanced ? models[gl_BaseInstance + gl_InstanceID] : model;
+	gl_Position = lightSpace * modelMatrix * vec4(position, 1.0f);
 }
\ No newline at end of file
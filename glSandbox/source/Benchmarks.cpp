@@ -0,0 +1,521 @@
+#include "Benchmarks.h"
+#include "TransformedNode.h"
+#include "TransformHierarchy.h"
+#include "ThreadPool.h"
+#include "OcclusionCuller.h"
+#include "NodePool.h"
+#include "SceneManager.h"
+#include "TriangleBVH.h"
+#include "SIMD.h"
+#include "Util.h"
+
+#include <imgui.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include <memory>
+#include <string>
+
+namespace
+{
+	using chrono = std::chrono::steady_clock;
+
+	template<typename Callable>
+	float measure(int repetitions, Callable operation)
+	{
+		auto const start = chrono::now();
+		for(int i = 0; i < repetitions; i++)
+			operation(i);
+		return std::chrono::duration<float, std::milli>(chrono::now() - start).count() / repetitions;
+	}
+
+	//only the operation is timed, every repetition is prepared before the clock starts
+	template<typename Preparation, typename Callable>
+	float measure(int repetitions, Preparation prepare, Callable operation)
+	{
+		chrono::duration total{0};
+		for(int i = 0; i < repetitions; i++)
+		{
+			prepare(i);
+			auto const start = chrono::now();
+			operation(i);
+			total += chrono::now() - start;
+		}
+		return std::chrono::duration<float, std::milli>(total).count() / repetitions;
+	}
+
+	std::unique_ptr<Node> generateHierarchy(int nodeCount, int branchingFactor)
+	{
+		std::mt19937 generator{42};
+		std::uniform_real_distribution<float> distribution{-1.0f, 1.0f};
+		auto root = std::make_unique<TransformedNode>();
+		std::vector<Node*> nodes{root.get()};
+		for(int generated = 1, next = 0; generated < nodeCount; next++)
+		{
+			for(int i = 0; i < branchingFactor && generated < nodeCount; i++, generated++)
+			{
+				auto node = std::make_unique<TransformedNode>();
+				node->setLocalTranslation({distribution(generator), distribution(generator), distribution(generator)});
+				node->setLocalRotation(glm::vec3{distribution(generator), distribution(generator), distribution(generator)} * 180.0f);
+				node->setLocalScale(1.0f + distribution(generator) * 0.1f);
+				nodes.push_back(nodes[next]->addChild(std::move(node)));
+			}
+		}
+		return root;
+	}
+
+	struct TransformPropagation
+	{
+		int nodeCount = 1'000'000;
+		int branchingFactor = 8;
+		int repetitions = 10;
+		float serialTime = 0.0f;
+		std::vector<float> parallelTimes;
+
+		void run()
+		{
+			auto root = generateHierarchy(nodeCount, branchingFactor);
+			auto transformedRoot = static_cast<TransformedNode*>(root.get());
+			TransformHierarchy hierarchy;
+			hierarchy.rebuild(root.get());
+			hierarchy.update();
+
+			//rescaling the root makes every global transformation outdated, same as Scene::fitToIdealSize,
+			//the invalidation walks the whole tree on one thread, so it is kept out of the timings
+			auto outdateAll = [&](int i){
+				transformedRoot->setLocalScale(1.0f + i * 0.01f);
+			};
+			serialTime = measure(repetitions, outdateAll, [&](int){
+				hierarchy.update();
+			});
+			parallelTimes.clear();
+			int const maxThreads = std::max(1, int(std::thread::hardware_concurrency()));
+			for(int threads = 1; threads <= maxThreads; threads++)
+			{
+				ThreadPool threadPool{threads - 1};
+				parallelTimes.push_back(measure(repetitions, outdateAll, [&](int){
+					hierarchy.update(threadPool);
+				}));
+			}
+		}
+
+		void drawUI()
+		{
+			ImGui::InputInt("Nodes", &nodeCount);
+			ImGui::InputInt("Branching Factor", &branchingFactor);
+			ImGui::InputInt("Repetitions", &repetitions);
+			nodeCount = std::max(1, nodeCount);
+			branchingFactor = std::max(1, branchingFactor);
+			repetitions = std::max(1, repetitions);
+			if(ImGui::Button("Run"))
+				run();
+			if(parallelTimes.empty())
+				return;
+			ImGui::Text("Serial: %.2f ms", serialTime);
+			for(int i = 0; i < int(parallelTimes.size()); i++)
+				ImGui::Text("%i threads: %.2f ms (%.2fx)", i + 1, parallelTimes[i], serialTime / parallelTimes[i]);
+			ImGui::PlotHistogram("###Scaling", parallelTimes.data(), int(parallelTimes.size()), 0, nullptr, 0.0f, FLT_MAX, {ImGui::GetContentRegionAvailWidth(), 100});
+		}
+
+		void print() const
+		{
+			std::printf("Transform Propagation: %i nodes, branching factor %i\n", nodeCount, branchingFactor);
+			std::printf("  Serial: %.2f ms\n", serialTime);
+			for(int i = 0; i < int(parallelTimes.size()); i++)
+				std::printf("  %i threads: %.2f ms (%.2fx)\n", i + 1, parallelTimes[i], serialTime / parallelTimes[i]);
+		}
+	}transformPropagation;
+
+	struct OcclusionCulling
+	{
+		int occluderCount = 16;
+		int boxCount = 100'000;
+		int width = 256;
+		int height = 128;
+		int repetitions = 10;
+		float rasterizationTime = 0.0f;
+		float testTime = 0.0f;
+		int rasterizedTriangles = 0;
+		int occludedBoxes = -1;
+
+		void run()
+		{
+			std::mt19937 generator{42};
+			std::uniform_real_distribution<float> distribution{-1.0f, 1.0f};
+			glm::mat4 const viewProjection = glm::perspective(glm::radians(60.0f), float(width) / height, 0.1f, 200.0f) *
+				glm::lookAt(glm::vec3{0.0f}, glm::vec3{0.0f, 0.0f, -1.0f}, glm::vec3{0.0f, 1.0f, 0.0f});
+
+			//a row of walls, as unit cubes scaled into slabs, in front of a field of small boxes
+			std::vector<glm::vec3> const positions{
+				{-1, -1, -1}, {1, -1, -1}, {1, 1, -1}, {-1, 1, -1},
+				{-1, -1, 1}, {1, -1, 1}, {1, 1, 1}, {-1, 1, 1}};
+			std::vector<uint32_t> const indices{
+				0, 2, 1, 0, 3, 2, 4, 5, 6, 4, 6, 7, 0, 1, 5, 0, 5, 4,
+				3, 6, 2, 3, 7, 6, 0, 4, 7, 0, 7, 3, 1, 2, 6, 1, 6, 5};
+			std::vector<glm::mat4> walls;
+			for(int i = 0; i < occluderCount; i++)
+			{
+				glm::vec3 const position{distribution(generator) * 20.0f, distribution(generator) * 5.0f, -10.0f - (distribution(generator) + 1.0f) * 5.0f};
+				walls.push_back(glm::scale(glm::translate(glm::mat4{1.0f}, position), {4.0f, 4.0f, 0.2f}));
+			}
+			std::vector<std::pair<glm::vec3, glm::vec3>> boxes;
+			boxes.reserve(boxCount);
+			for(int i = 0; i < boxCount; i++)
+			{
+				glm::vec3 const center{distribution(generator) * 60.0f, distribution(generator) * 30.0f, -40.0f - (distribution(generator) + 1.0f) * 50.0f};
+				boxes.emplace_back(center - 0.5f, center + 0.5f);
+			}
+
+			OcclusionCuller culler{width, height};
+			rasterizationTime = measure(repetitions, [&](int){
+				culler.begin(viewProjection);
+				for(auto const& wall : walls)
+					culler.rasterize(positions, indices, wall);
+				culler.finish();
+			});
+			rasterizedTriangles = culler.getRasterizedTriangles();
+			testTime = measure(repetitions, [&](int){
+				occludedBoxes = 0;
+				for(auto const& [min, max] : boxes)
+					occludedBoxes += !culler.isVisible(min, max);
+			});
+		}
+
+		void drawUI()
+		{
+			ImGui::InputInt("Occluders", &occluderCount);
+			ImGui::InputInt("Boxes", &boxCount);
+			ImGui::InputInt("Width", &width);
+			ImGui::InputInt("Height", &height);
+			ImGui::InputInt("Repetitions", &repetitions);
+			occluderCount = std::max(0, occluderCount);
+			boxCount = std::max(1, boxCount);
+			width = std::max(4, width);
+			height = std::max(1, height);
+			repetitions = std::max(1, repetitions);
+			if(ImGui::Button("Run"))
+				run();
+			if(occludedBoxes == -1)
+				return;
+			ImGui::Text("Rasterization: %.3f ms (%i triangles)", rasterizationTime, rasterizedTriangles);
+			ImGui::Text("Tests: %.3f ms (%.1f ns per box)", testTime, testTime * 1e6f / boxCount);
+			ImGui::Text("Occluded: %i of %i boxes", occludedBoxes, boxCount);
+			if(occludedBoxes > 0)
+				ImGui::Text("Cost per saved draw: %.1f ns", (rasterizationTime + testTime) * 1e6f / occludedBoxes);
+		}
+
+		void print() const
+		{
+			std::printf("Occlusion Culling: %i occluders, %i boxes, %ix%i\n", occluderCount, boxCount, width, height);
+			std::printf("  Rasterization: %.3f ms (%i triangles)\n", rasterizationTime, rasterizedTriangles);
+			std::printf("  Tests: %.3f ms (%.1f ns per box)\n", testTime, testTime * 1e6f / boxCount);
+			std::printf("  Occluded: %i of %i boxes\n", occludedBoxes, boxCount);
+		}
+	}occlusionCulling;
+
+	struct NodeAllocation
+	{
+		int nodeCount = 200'000;
+		int branchingFactor = 3;
+		float buildTime = 0.0f;
+		float teardownTime = 0.0f;
+		int slabAllocations = 0;
+		int spilledChildren = 0;
+		int parents = -1;
+
+		void run()
+		{
+			int const slabsBefore = NodePool::getStats().slabAllocations;
+			std::unique_ptr<Node> root;
+			buildTime = measure(1, [&](int){
+				root = generateHierarchy(nodeCount, branchingFactor);
+			});
+			slabAllocations = NodePool::getStats().slabAllocations - slabsBefore;
+			parents = 0;
+			spilledChildren = 0;
+			root->recursive([&](Node* node){
+				parents += !node->getChildren().empty();
+				spilledChildren += node->getChildren().isSpilled();
+			});
+			teardownTime = measure(1, [&](int){
+				root.reset();
+				NodePool::trim();
+			});
+		}
+
+		void drawUI()
+		{
+			ImGui::InputInt("Nodes", &nodeCount);
+			ImGui::InputInt("Branching Factor", &branchingFactor);
+			nodeCount = std::max(1, nodeCount);
+			branchingFactor = std::max(1, branchingFactor);
+			if(ImGui::Button("Run"))
+				run();
+			if(parents != -1)
+			{
+				ImGui::Text("Build: %.2f ms, Teardown: %.2f ms", buildTime, teardownTime);
+				//one allocation per node and at least one per children vector without pooling
+				ImGui::Text("Heap Allocations: %i (unpooled: %i)", slabAllocations + spilledChildren, nodeCount + parents);
+				ImGui::Text("Slabs: %i, Spilled Children: %i", slabAllocations, spilledChildren);
+			}
+			NodePool::Stats const& stats = NodePool::getStats();
+			ImGui::Text("Pool: %i live nodes in %i slabs (%i KB)", stats.liveObjects, stats.slabs, int(stats.slabs * NodePool::slabSize / 1024));
+			auto const& lastImport = SceneManager::getLastImport();
+			if(!lastImport.file.empty())
+			{
+				ImGui::Text("Last Import: %s", lastImport.file.data());
+				ImGui::Text("%.1f ms, %i nodes", lastImport.milliseconds, lastImport.nodes);
+				ImGui::Text("Heap Allocations: %i (unpooled: %i)",
+					lastImport.slabAllocations + lastImport.unpooledNodes + lastImport.spilledChildren, lastImport.nodes + lastImport.parents);
+			}
+		}
+
+		void print() const
+		{
+			std::printf("Node Allocation: %i nodes, branching factor %i\n", nodeCount, branchingFactor);
+			std::printf("  Build: %.2f ms, Teardown: %.2f ms\n", buildTime, teardownTime);
+			std::printf("  Heap Allocations: %i (unpooled: %i)\n", slabAllocations + spilledChildren, nodeCount + parents);
+		}
+	}nodeAllocation;
+
+	struct RayPicking
+	{
+		//a displaced grid, with as many triangles as a large gltf scene
+		int resolution = 1024;
+		int rayCount = 100'000;
+		float buildTime = 0.0f;
+		float rayTime = 0.0f;
+		int triangleCount = 0;
+		int nodeCount = 0;
+		std::size_t memoryUsage = 0;
+		int hits = -1;
+
+		void run()
+		{
+			std::mt19937 generator{42};
+			std::uniform_real_distribution<float> distribution{-1.0f, 1.0f};
+			std::vector<glm::vec3> positions;
+			positions.reserve((resolution + 1) * (resolution + 1));
+			for(int y = 0; y <= resolution; y++)
+				for(int x = 0; x <= resolution; x++)
+					positions.emplace_back(float(x) / resolution * 2.0f - 1.0f, distribution(generator) * 0.01f, float(y) / resolution * 2.0f - 1.0f);
+			std::vector<uint32_t> indices;
+			indices.reserve(resolution * resolution * 6);
+			for(int y = 0; y < resolution; y++)
+			{
+				for(int x = 0; x < resolution; x++)
+				{
+					uint32_t const corner = y * (resolution + 1) + x;
+					indices.insert(indices.end(), {corner, corner + resolution + 1, corner + 1, corner + 1, corner + resolution + 1, corner + resolution + 2});
+				}
+			}
+
+			std::unique_ptr<TriangleBVH> bvh;
+			buildTime = measure(1, [&](int){
+				bvh = std::make_unique<TriangleBVH>(positions, indices);
+			});
+			triangleCount = bvh->getTriangleCount();
+			nodeCount = bvh->getNodeCount();
+			memoryUsage = bvh->getMemoryUsage();
+
+			//rays from above the grid towards random points on it, some of them missing
+			std::vector<Ray> rays;
+			rays.reserve(rayCount);
+			for(int i = 0; i < rayCount; i++)
+			{
+				glm::vec3 const origin{distribution(generator), 2.0f, distribution(generator)};
+				glm::vec3 const target{distribution(generator) * 1.2f, 0.0f, distribution(generator) * 1.2f};
+				rays.push_back({origin, glm::normalize(target - origin)});
+			}
+			rayTime = measure(1, [&](int){
+				hits = 0;
+				for(auto const& ray : rays)
+				{
+					TriangleBVH::Hit hit;
+					hits += bvh->raycast(ray, FLT_MAX, hit);
+				}
+			});
+		}
+
+		void drawUI()
+		{
+			ImGui::InputInt("Grid Resolution", &resolution);
+			ImGui::InputInt("Rays", &rayCount);
+			resolution = std::clamp(resolution, 1, 4096);
+			rayCount = std::max(1, rayCount);
+			if(ImGui::Button("Run"))
+				run();
+			if(hits == -1)
+				return;
+			ImGui::Text("Build: %.1f ms for %i triangles", buildTime, triangleCount);
+			ImGui::Text("%i nodes (%i KB)", nodeCount, int(memoryUsage / 1024));
+			ImGui::Text("Rays: %.3f ms (%.2f us per ray)", rayTime, rayTime * 1e3f / rayCount);
+			ImGui::Text("Hits: %i of %i rays", hits, rayCount);
+		}
+
+		void print() const
+		{
+			std::printf("Ray Picking: %i triangles, %i rays\n", triangleCount, rayCount);
+			std::printf("  Build: %.1f ms, %i nodes (%i KB)\n", buildTime, nodeCount, int(memoryUsage / 1024));
+			std::printf("  Rays: %.3f ms (%.2f us per ray)\n", rayTime, rayTime * 1e3f / rayCount);
+			std::printf("  Hits: %i of %i rays\n", hits, rayCount);
+		}
+	}rayPicking;
+
+	struct BoundsTransformation
+	{
+		int boxCount = 100'000;
+		int repetitions = 10;
+		float cornersTime = 0.0f;
+		float arvoTime = 0.0f;
+		float batchedTime = 0.0f;
+		float maxError = -1.0f;
+
+		static char const* getBatchedPath()
+		{
+			if(simd::hasAVX())
+				return "AVX";
+#ifdef SIMD_SSE
+			return "SSE";
+#else
+			return "scalar";
+#endif
+		}
+
+		//the previous implementation, every corner through a full matrix multiplication
+		static Bounds transformCorners(Bounds const& bounds, glm::mat4 const& transformation)
+		{
+			auto const[min, max] = bounds.getValues();
+			Bounds ret;
+			for(int corner = 0; corner < 8; corner++)
+			{
+				glm::vec4 const point{corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z, 1.0f};
+				ret += Bounds{glm::vec3{transformation * point}};
+			}
+			return ret;
+		}
+
+		void run()
+		{
+			std::mt19937 generator{42};
+			std::uniform_real_distribution<float> distribution{-1.0f, 1.0f};
+			std::vector<Bounds> boxes;
+			std::vector<glm::mat4> transformations;
+			simd::BoundsSoA batch;
+			boxes.reserve(boxCount);
+			transformations.reserve(boxCount);
+			batch.resize(boxCount);
+			for(int i = 0; i < boxCount; i++)
+			{
+				glm::vec3 const center{distribution(generator), distribution(generator), distribution(generator)};
+				glm::vec3 const extent = glm::abs(glm::vec3{distribution(generator), distribution(generator), distribution(generator)});
+				boxes.emplace_back(center - extent, center + extent);
+				batch.set(i, center - extent, center + extent);
+				glm::mat4 transformation = glm::translate(glm::mat4{1.0f}, glm::vec3{distribution(generator), distribution(generator), distribution(generator)} * 10.0f);
+				transformation = glm::rotate(transformation, distribution(generator) * 3.14f, glm::normalize(glm::vec3{distribution(generator), distribution(generator), 1.0f}));
+				transformations.push_back(glm::scale(transformation, glm::vec3{1.5f + distribution(generator)}));
+			}
+
+			std::vector<Bounds> corners(boxCount);
+			std::vector<Bounds> arvo(boxCount);
+			simd::BoundsSoA batched;
+			cornersTime = measure(repetitions, [&](int){
+				for(int i = 0; i < boxCount; i++)
+					corners[i] = transformCorners(boxes[i], transformations[i]);
+			});
+			arvoTime = measure(repetitions, [&](int){
+				for(int i = 0; i < boxCount; i++)
+					arvo[i] = boxes[i] * transformations[i];
+			});
+			batchedTime = measure(repetitions, [&](int){
+				simd::transformBounds(transformations.data(), batch, batched);
+			});
+			maxError = 0.0f;
+			for(int i = 0; i < boxCount; i++)
+			{
+				auto const[min, max] = corners[i].getValues();
+				auto const[arvoMin, arvoMax] = arvo[i].getValues();
+				maxError = std::max({maxError, glm::length(min - arvoMin), glm::length(max - arvoMax),
+					glm::length(min - batched.getMin(i)), glm::length(max - batched.getMax(i))});
+			}
+		}
+
+		void drawUI()
+		{
+			ImGui::InputInt("Boxes", &boxCount);
+			ImGui::InputInt("Repetitions", &repetitions);
+			boxCount = std::max(1, boxCount);
+			repetitions = std::max(1, repetitions);
+			if(ImGui::Button("Run"))
+				run();
+			if(maxError < 0.0f)
+				return;
+			ImGui::Text("Corners: %.3f ms (%.1f ns per box)", cornersTime, cornersTime * 1e6f / boxCount);
+			ImGui::Text("Center/Extent: %.3f ms (%.1f ns per box, %.2fx)", arvoTime, arvoTime * 1e6f / boxCount, cornersTime / arvoTime);
+			ImGui::Text("Batched: %.3f ms (%.1f ns per box, %.2fx)", batchedTime, batchedTime * 1e6f / boxCount, cornersTime / batchedTime);
+			ImGui::Text("Batched path: %s", getBatchedPath());
+			ImGui::Text("Max Error: %g", maxError);
+		}
+
+		void print() const
+		{
+			std::printf("Bounds Transformation: %i boxes\n", boxCount);
+			std::printf("  Corners: %.3f ms (%.1f ns per box)\n", cornersTime, cornersTime * 1e6f / boxCount);
+			std::printf("  Center/Extent: %.3f ms (%.1f ns per box, %.2fx)\n", arvoTime, arvoTime * 1e6f / boxCount, cornersTime / arvoTime);
+			std::printf("  Batched (%s): %.3f ms (%.1f ns per box, %.2fx)\n", getBatchedPath(), batchedTime, batchedTime * 1e6f / boxCount, cornersTime / batchedTime);
+			std::printf("  Max Error: %g\n", maxError);
+		}
+	}boundsTransformation;
+}
+
+void benchmarks::drawUI(bool* open)
+{
+	if(!*open)
+		return;
+	ImGui::Begin("Benchmarks", open, ImGuiWindowFlags_NoCollapse);
+	if(ImGui::CollapsingHeader("Transform Propagation"))
+	{
+		IDGuard idGuard{&transformPropagation};
+		transformPropagation.drawUI();
+	}
+	if(ImGui::CollapsingHeader("Occlusion Culling"))
+	{
+		IDGuard idGuard{&occlusionCulling};
+		occlusionCulling.drawUI();
+	}
+	if(ImGui::CollapsingHeader("Node Allocation"))
+	{
+		IDGuard idGuard{&nodeAllocation};
+		nodeAllocation.drawUI();
+	}
+	if(ImGui::CollapsingHeader("Ray Picking"))
+	{
+		IDGuard idGuard{&rayPicking};
+		rayPicking.drawUI();
+	}
+	if(ImGui::CollapsingHeader("Bounds Transformation"))
+	{
+		IDGuard idGuard{&boundsTransformation};
+		boundsTransformation.drawUI();
+	}
+	ImGui::End();
+}
+
+void benchmarks::runAll()
+{
+	transformPropagation.run();
+	transformPropagation.print();
+	occlusionCulling.run();
+	occlusionCulling.print();
+	nodeAllocation.run();
+	nodeAllocation.print();
+	rayPicking.run();
+	rayPicking.print();
+	boundsTransformation.run();
+	boundsTransformation.print();
+}
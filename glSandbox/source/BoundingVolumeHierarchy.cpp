@@ -0,0 +1,371 @@
+#include "BoundingVolumeHierarchy.h"
+#include "Prop.h"
+#include "Mesh.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+float BoundingVolumeHierarchy::area(glm::vec3 const& min, glm::vec3 const& max)
+{
+	glm::vec3 const d = max - min;
+	return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+float BoundingVolumeHierarchy::area(Volume const& volume)
+{
+	return area(volume.min, volume.max);
+}
+
+int BoundingVolumeHierarchy::allocate()
+{
+	if(freeVolumes.empty())
+	{
+		volumes.emplace_back();
+		return int(volumes.size()) - 1;
+	}
+	int const ret = freeVolumes.back();
+	freeVolumes.pop_back();
+	volumes[ret] = Volume{};
+	return ret;
+}
+
+void BoundingVolumeHierarchy::release(int volume)
+{
+	volumes[volume] = Volume{};
+	freeVolumes.push_back(volume);
+}
+
+void BoundingVolumeHierarchy::fitLeaf(int leaf)
+{
+	Volume& volume = volumes[leaf];
+	Bounds bounds = volume.prop->getOwnBounds();
+	if(bounds.empty())
+		bounds = Bounds{glm::vec3{volume.prop->getGlobalTransformation()[3]}};
+	std::tie(volume.min, volume.max) = bounds.getValues();
+}
+
+//leaves whose volume is unchanged are removed from the list
+void BoundingVolumeHierarchy::fitLeaves(std::vector<int>& leaves)
+{
+	int const count = int(leaves.size());
+	leafTransformations.resize(count);
+	leafBounds.resize(count);
+	for(int i = 0; i < count; i++)
+	{
+		Prop const* prop = volumes[leaves[i]].prop;
+		leafTransformations[i] = prop->getGlobalTransformation();
+		//empty bounds are stored as a point at the origin, which ends up at the translation like in fitLeaf
+		auto const[min, max] = prop->getMesh().getBounds().getValues();
+		leafBounds.set(i, min, max);
+	}
+	simd::transformBounds(leafTransformations.data(), leafBounds, leafBounds);
+	int changed = 0;
+	for(int i = 0; i < count; i++)
+	{
+		Volume& volume = volumes[leaves[i]];
+		glm::vec3 const min = leafBounds.getMin(i);
+		glm::vec3 const max = leafBounds.getMax(i);
+		if(min == volume.min && max == volume.max)
+			continue;
+		volume.min = min;
+		volume.max = max;
+		leaves[changed++] = leaves[i];
+	}
+	leaves.resize(changed);
+}
+
+void BoundingVolumeHierarchy::fitInternal(int volume)
+{
+	Volume& internal = volumes[volume];
+	Volume const& left = volumes[internal.left];
+	Volume const& right = volumes[internal.right];
+	internalArea -= area(internal);
+	internal.min = glm::min(left.min, right.min);
+	internal.max = glm::max(left.max, right.max);
+	internalArea += area(internal);
+}
+
+void BoundingVolumeHierarchy::refitAncestors(int volume)
+{
+	for(int current = volumes[volume].parent; current != -1; current = volumes[current].parent)
+	{
+		glm::vec3 const oldMin = volumes[current].min;
+		glm::vec3 const oldMax = volumes[current].max;
+		fitInternal(current);
+		//ancestors of an unchanged volume are unchanged as well
+		if(oldMin == volumes[current].min && oldMax == volumes[current].max)
+			break;
+	}
+}
+
+void BoundingVolumeHierarchy::insertLeaf(int leaf)
+{
+	if(root == -1)
+	{
+		root = leaf;
+		volumes[leaf].parent = -1;
+		return;
+	}
+
+	glm::vec3 const leafMin = volumes[leaf].min;
+	glm::vec3 const leafMax = volumes[leaf].max;
+	auto combinedArea = [&](int volume){
+		return area(glm::min(volumes[volume].min, leafMin), glm::max(volumes[volume].max, leafMax));
+	};
+
+	//descend towards the sibling which increases the total surface area the least
+	int sibling = root;
+	while(!volumes[sibling].isLeaf())
+	{
+		Volume const& current = volumes[sibling];
+		float const combined = combinedArea(sibling);
+		float const cost = 2.0f * combined;
+		float const inheritedCost = 2.0f * (combined - area(current));
+		auto descendCost = [&](int child){
+			float const childCost = combinedArea(child) + inheritedCost;
+			return volumes[child].isLeaf() ? childCost : childCost - area(volumes[child]);
+		};
+		float const leftCost = descendCost(current.left);
+		float const rightCost = descendCost(current.right);
+		if(cost < leftCost && cost < rightCost)
+			break;
+		sibling = leftCost < rightCost ? current.left : current.right;
+	}
+
+	int const oldParent = volumes[sibling].parent;
+	int const newParent = allocate();
+	volumes[newParent].parent = oldParent;
+	volumes[newParent].left = sibling;
+	volumes[newParent].right = leaf;
+	volumes[sibling].parent = newParent;
+	volumes[leaf].parent = newParent;
+	if(oldParent == -1)
+		root = newParent;
+	else if(volumes[oldParent].left == sibling)
+		volumes[oldParent].left = newParent;
+	else
+		volumes[oldParent].right = newParent;
+	fitInternal(newParent);
+	refitAncestors(newParent);
+}
+
+void BoundingVolumeHierarchy::removeLeaf(int leaf)
+{
+	if(leaf == root)
+	{
+		root = -1;
+		return;
+	}
+
+	int const parent = volumes[leaf].parent;
+	int const grandParent = volumes[parent].parent;
+	int const sibling = volumes[parent].left == leaf ? volumes[parent].right : volumes[parent].left;
+	internalArea -= area(volumes[parent]);
+	release(parent);
+	volumes[sibling].parent = grandParent;
+	if(grandParent == -1)
+	{
+		root = sibling;
+		return;
+	}
+	if(volumes[grandParent].left == parent)
+		volumes[grandParent].left = sibling;
+	else
+		volumes[grandParent].right = sibling;
+	fitInternal(grandParent);
+	refitAncestors(grandParent);
+}
+
+int BoundingVolumeHierarchy::build(std::vector<int>& leaves, int begin, int end)
+{
+	if(end - begin == 1)
+		return leaves[begin];
+
+	auto centroid = [&](int leaf){
+		return (volumes[leaf].min + volumes[leaf].max) * 0.5f;
+	};
+	glm::vec3 centroidMin = centroid(leaves[begin]);
+	glm::vec3 centroidMax = centroidMin;
+	for(int i = begin + 1; i < end; i++)
+	{
+		centroidMin = glm::min(centroidMin, centroid(leaves[i]));
+		centroidMax = glm::max(centroidMax, centroid(leaves[i]));
+	}
+	glm::vec3 const extent = centroidMax - centroidMin;
+	int axis = 0;
+	if(extent.y > extent[axis])
+		axis = 1;
+	if(extent.z > extent[axis])
+		axis = 2;
+
+	int mid = (begin + end) / 2;
+	if(extent[axis] > 0.0f)
+	{
+		struct Bin
+		{
+			int count = 0;
+			glm::vec3 min{std::numeric_limits<float>::max()};
+			glm::vec3 max{std::numeric_limits<float>::lowest()};
+		};
+		std::array<Bin, binCount> bins;
+		auto binIndex = [&](int leaf){
+			int const idx = int(binCount * (centroid(leaf)[axis] - centroidMin[axis]) / extent[axis]);
+			return std::min(idx, binCount - 1);
+		};
+		for(int i = begin; i < end; i++)
+		{
+			Bin& bin = bins[binIndex(leaves[i])];
+			bin.count++;
+			bin.min = glm::min(bin.min, volumes[leaves[i]].min);
+			bin.max = glm::max(bin.max, volumes[leaves[i]].max);
+		}
+
+		//sweep from the right to get the cost of every right partition, then from the left to pick the best split
+		std::array<float, binCount> rightCosts;
+		Bin accumulated;
+		for(int i = binCount - 1; i > 0; i--)
+		{
+			accumulated.count += bins[i].count;
+			accumulated.min = glm::min(accumulated.min, bins[i].min);
+			accumulated.max = glm::max(accumulated.max, bins[i].max);
+			rightCosts[i] = accumulated.count ? accumulated.count * area(accumulated.min, accumulated.max) : 0.0f;
+		}
+		accumulated = Bin{};
+		float bestCost = std::numeric_limits<float>::max();
+		int bestSplit = -1;
+		for(int i = 0; i < binCount - 1; i++)
+		{
+			accumulated.count += bins[i].count;
+			accumulated.min = glm::min(accumulated.min, bins[i].min);
+			accumulated.max = glm::max(accumulated.max, bins[i].max);
+			if(accumulated.count == 0 || accumulated.count == end - begin)
+				continue;
+			float const cost = accumulated.count * area(accumulated.min, accumulated.max) + rightCosts[i + 1];
+			if(cost < bestCost)
+			{
+				bestCost = cost;
+				bestSplit = i;
+			}
+		}
+		if(bestSplit != -1)
+		{
+			mid = int(std::partition(leaves.begin() + begin, leaves.begin() + end, [&](int leaf){
+				return binIndex(leaf) <= bestSplit;
+			}) - leaves.begin());
+		}
+	}
+	if(mid == begin || mid == end)
+		mid = (begin + end) / 2;
+
+	int const left = build(leaves, begin, mid);
+	int const right = build(leaves, mid, end);
+	int const ret = allocate();
+	volumes[ret].left = left;
+	volumes[ret].right = right;
+	volumes[left].parent = ret;
+	volumes[right].parent = ret;
+	fitInternal(ret);
+	return ret;
+}
+
+void BoundingVolumeHierarchy::insert(Prop* prop)
+{
+	int const leaf = allocate();
+	volumes[leaf].prop = prop;
+	prop->boundingVolume = leaf;
+	fitLeaf(leaf);
+	insertLeaf(leaf);
+	leafCount++;
+	//inserts and removes pick where leaves go by their current bounds, so the tree they leave is the new baseline
+	builtCost = getCost();
+}
+
+void BoundingVolumeHierarchy::remove(Prop* prop)
+{
+	int const leaf = prop->boundingVolume;
+	removeLeaf(leaf);
+	release(leaf);
+	prop->boundingVolume = -1;
+	leafCount--;
+	builtCost = getCost();
+}
+
+void BoundingVolumeHierarchy::outdated(Prop* prop)
+{
+	int const leaf = prop->boundingVolume;
+	if(leaf == -1 || volumes[leaf].outdated)
+		return;
+	volumes[leaf].outdated = true;
+	outdatedLeaves.push_back(leaf);
+}
+
+void BoundingVolumeHierarchy::refit()
+{
+	//the leaf might have been removed, and its slot reused, since it was marked
+	outdatedLeaves.erase(std::remove_if(outdatedLeaves.begin(), outdatedLeaves.end(), [&](int leaf){
+		bool const removed = !volumes[leaf].outdated;
+		volumes[leaf].outdated = false;
+		return removed;
+	}), outdatedLeaves.end());
+	fitLeaves(outdatedLeaves);
+	for(int leaf : outdatedLeaves)
+		refitAncestors(leaf);
+	outdatedLeaves.clear();
+	//a tree built while every leaf was empty has no baseline, any cost at all means it was built blind
+	float const cost = getCost();
+	if(leafCount > 2 && (builtCost > 0.0f ? cost > rebuildThreshold * builtCost : cost > 0.0f))
+		rebuild();
+}
+
+void BoundingVolumeHierarchy::rebuild()
+{
+	std::vector<Prop*> props;
+	props.reserve(leafCount);
+	for(auto const& volume : volumes)
+		if(volume.prop)
+			props.push_back(volume.prop);
+
+	volumes.clear();
+	freeVolumes.clear();
+	outdatedLeaves.clear();
+	internalArea = 0.0f;
+	root = -1;
+	std::vector<int> indices;
+	indices.reserve(props.size());
+	for(auto prop : props)
+	{
+		int const idx = allocate();
+		volumes[idx].prop = prop;
+		prop->boundingVolume = idx;
+		indices.push_back(idx);
+	}
+	std::vector<int> leaves = indices;
+	fitLeaves(leaves);
+	if(!indices.empty())
+	{
+		root = build(indices, 0, int(indices.size()));
+		volumes[root].parent = -1;
+	}
+	builtCost = getCost();
+}
+
+int BoundingVolumeHierarchy::getSize() const
+{
+	return leafCount;
+}
+
+float BoundingVolumeHierarchy::getCost() const
+{
+	if(root == -1)
+		return 0.0f;
+	float const rootArea = area(volumes[root]);
+	return rootArea > 0.0f ? internalArea / rootArea : 0.0f;
+}
+
+Bounds BoundingVolumeHierarchy::getBounds() const
+{
+	if(root == -1)
+		return {};
+	return {volumes[root].min, volumes[root].max};
+}
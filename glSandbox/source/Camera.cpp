@@ -1,6 +1,7 @@
 #include "Camera.h"
 #include "Globals.h"
 #include "Util.h"
+#include "RingBuffer.h"
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/euler_angles.hpp>
 #include <imgui.h>
@@ -12,30 +13,23 @@ Camera::Camera()
 	setLocalRotation(glm::vec3{-15.0f, 0.0f, 0.0f});
 }
 
-unsigned int Camera::ubo()
+std::string Camera::getNamePrefix() const
 {
-	static unsigned int ubo = [](){
-		unsigned int ubo;
-		glGenBuffers(1, &ubo);
-		glBindBuffer(GL_UNIFORM_BUFFER, ubo);
-		glBufferData(GL_UNIFORM_BUFFER, 128, nullptr, GL_STREAM_DRAW);
-		glBindBufferBase(GL_UNIFORM_BUFFER, 0, ubo);
-		return ubo;
-	}();
-
-	return ubo;
+	return "camera";
 }
 
-std::string Camera::getNamePrefix() const
+NodeType Camera::getType() const
 {
-	return "camera";
+	return type;
 }
 
-void Camera::use() const
+void Camera::use(RingBuffer& frameData) const
 {
-	glBindBuffer(GL_UNIFORM_BUFFER, ubo());
-	glBufferSubData(GL_UNIFORM_BUFFER, 0, 64, glm::value_ptr(getProjectionMatrix()));
-	glBufferSubData(GL_UNIFORM_BUFFER, 64, 64, glm::value_ptr(getViewMatrix()));
+	auto const matrices = frameData.allocateUniform(2 * sizeof(glm::mat4));
+	glm::mat4* data = static_cast<glm::mat4*>(matrices.data);
+	data[0] = getProjectionMatrix();
+	data[1] = getViewMatrix();
+	glBindBufferRange(GL_UNIFORM_BUFFER, 0, matrices.buffer, matrices.offset, matrices.size);
 }
 
 float Camera::getNearPlane() const
@@ -80,15 +74,18 @@ void Camera::drawUI()
 	ImGui::AlignTextToFramePadding();
 	ImGui::Text("Projection");
 	ImGui::SameLine();
-	ImGui::RadioButton("Perspective", reinterpret_cast<int*>(&projectionOrtho), 0);
+	bool changed = false;
+	changed |= ImGui::RadioButton("Perspective", reinterpret_cast<int*>(&projectionOrtho), 0);
 	ImGui::SameLine();
-	ImGui::RadioButton("Orthographic", reinterpret_cast<int*>(&projectionOrtho), 1);
+	changed |= ImGui::RadioButton("Orthographic", reinterpret_cast<int*>(&projectionOrtho), 1);
 	if(projectionOrtho)
-		ImGui::DragFloat("Scale", &orthoScale, 0.0001f);
+		changed |= ImGui::DragFloat("Scale", &orthoScale, 0.0001f);
 	else
-		ImGui::DragFloat("FOV", &fov, 0.1f);
-	ImGui::DragFloat("Near Plane", &nearPlane, 0.01f);
-	ImGui::DragFloat("Far Plane", &farPlane, 0.1f);
-	ImGui::Checkbox("Visualize Frustum", &visualizeFrustum);
+		changed |= ImGui::DragFloat("FOV", &fov, 0.1f);
+	changed |= ImGui::DragFloat("Near Plane", &nearPlane, 0.01f);
+	changed |= ImGui::DragFloat("Far Plane", &farPlane, 0.1f);
+	changed |= ImGui::Checkbox("Visualize Frustum", &visualizeFrustum);
+	if(changed)
+		updateTimestamp();
 	ImGui::EndChild();
 }
\ No newline at end of file
@@ -38,13 +38,14 @@ void Grid::generate() const
 	mesh = std::make_unique<Mesh>(bounds, GL_LINES, buildAttributes(std::move(vertices)), buildIndexBuffer(std::move(indices)));
 }
 
-void Grid::drawUI()
+bool Grid::drawUI()
 {
-	ImGui::BeginGroup();
+	int const previousResolution = resolution;
 	ImGui::InputInt("Resolution", &resolution, 1);
 	if(resolution < 1)
 		resolution = 1;
-	ImGui::EndGroup();
-	if(ImGui::IsItemActive() || ImGui::IsItemDeactivatedAfterChange())
-		parametersChanged = true;
+	if(resolution == previousResolution)
+		return false;
+	parametersChanged = true;
+	return true;
 }
@@ -0,0 +1,287 @@
+#include "LightClusters.h"
+#include "Scene.h"
+#include "Camera.h"
+#include "Lights.h"
+#include "ShaderManager.h"
+#include "ShadowAtlas.h"
+#include "ThreadPool.h"
+
+#include <glad/glad.h>
+#include <imgui.h>
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <type_traits>
+
+namespace
+{
+	enum LightType
+	{
+		directional,
+		point,
+		spot
+	};
+}
+
+LightClusters::LightClusters()
+{
+	glCreateBuffers(1, &lightBuffer);
+	glCreateBuffers(1, &clusterBuffer);
+	glCreateBuffers(1, &indexBuffer);
+	glCreateBuffers(1, &boundsBuffer);
+}
+
+LightClusters::~LightClusters()
+{
+	glDeleteBuffers(1, &lightBuffer);
+	glDeleteBuffers(1, &clusterBuffer);
+	glDeleteBuffers(1, &indexBuffer);
+	glDeleteBuffers(1, &boundsBuffer);
+}
+
+int LightClusters::getClusterCount() const
+{
+	return gridSize.x * gridSize.y * gridSize.z;
+}
+
+void LightClusters::updateBounds(glm::mat4 const& projection, float nearPlane, float farPlane)
+{
+	if(projection == boundsProjection && gridSize == boundsGridSize)
+		return;
+	boundsProjection = projection;
+	boundsGridSize = gridSize;
+
+	sliceDepths.resize(gridSize.z + 1);
+	for(int slice = 0; slice <= gridSize.z; slice++)
+		sliceDepths[slice] = nearPlane * std::pow(farPlane / nearPlane, float(slice) / gridSize.z);
+
+	//every tile corner is a line through the view volume, the cluster corners are where it crosses the slice depths
+	glm::mat4 const inverseProjection = glm::inverse(projection);
+	auto const unproject = [&](float x, float y, float z){
+		glm::vec4 const point = inverseProjection * glm::vec4{x, y, z, 1.0f};
+		return glm::vec3{point} / point.w;
+	};
+	auto const atDepth = [](glm::vec3 const& nearPoint, glm::vec3 const& farPoint, float depth){
+		float const t = (-depth - nearPoint.z) / (farPoint.z - nearPoint.z);
+		return nearPoint + (farPoint - nearPoint) * t;
+	};
+	bounds.resize(getClusterCount() * 2);
+	for(int y = 0; y < gridSize.y; y++)
+	{
+		for(int x = 0; x < gridSize.x; x++)
+		{
+			glm::vec3 nearCorners[4];
+			glm::vec3 farCorners[4];
+			for(int corner = 0; corner < 4; corner++)
+			{
+				float const ndcX = float(x + corner % 2) / gridSize.x * 2.0f - 1.0f;
+				float const ndcY = float(y + corner / 2) / gridSize.y * 2.0f - 1.0f;
+				nearCorners[corner] = unproject(ndcX, ndcY, -1.0f);
+				farCorners[corner] = unproject(ndcX, ndcY, 1.0f);
+			}
+			for(int slice = 0; slice < gridSize.z; slice++)
+			{
+				glm::vec3 min{FLT_MAX};
+				glm::vec3 max{-FLT_MAX};
+				for(int corner = 0; corner < 4; corner++)
+				{
+					for(float depth : {sliceDepths[slice], sliceDepths[slice + 1]})
+					{
+						glm::vec3 const point = atDepth(nearCorners[corner], farCorners[corner], depth);
+						min = glm::min(min, point);
+						max = glm::max(max, point);
+					}
+				}
+				int const cluster = x + gridSize.x * (y + gridSize.y * slice);
+				bounds[cluster * 2] = glm::vec4{min, 0.0f};
+				bounds[cluster * 2 + 1] = glm::vec4{max, 0.0f};
+			}
+		}
+	}
+	glNamedBufferData(boundsBuffer, bounds.size() * sizeof(glm::vec4), bounds.data(), GL_STATIC_DRAW);
+}
+
+void LightClusters::assignSlice(int slice)
+{
+	//only lights reaching the depth range of the slice are tested against its clusters
+	auto& candidates = sliceCandidates[slice];
+	candidates.clear();
+	float const sliceNear = -sliceDepths[slice];
+	float const sliceFar = -sliceDepths[slice + 1];
+	for(int i = directionalLights; i < int(lights.size()); i++)
+		if(lights[i].position.z - lights[i].range <= sliceNear && lights[i].position.z + lights[i].range >= sliceFar)
+			candidates.push_back(i);
+
+	auto& indices = sliceIndices[slice];
+	indices.clear();
+	int const first = gridSize.x * gridSize.y * slice;
+	for(int cluster = first; cluster < first + gridSize.x * gridSize.y; cluster++)
+	{
+		glm::vec3 const min = bounds[cluster * 2];
+		glm::vec3 const max = bounds[cluster * 2 + 1];
+		uint32_t const offset = uint32_t(indices.size());
+		for(int i : candidates)
+		{
+			glm::vec3 const distance = glm::clamp(lights[i].position, min, max) - lights[i].position;
+			if(glm::dot(distance, distance) <= lights[i].range * lights[i].range)
+				indices.push_back(uint32_t(i));
+		}
+		clusters[cluster] = {offset, uint32_t(indices.size()) - offset};
+	}
+}
+
+void LightClusters::assignOnCPU()
+{
+	int const clusterCount = getClusterCount();
+	clusters.resize(clusterCount);
+	sliceCandidates.resize(gridSize.z);
+	sliceIndices.resize(gridSize.z);
+	ThreadPool& threadPool = ThreadPool::shared();
+	for(int slice = 0; slice < gridSize.z; slice++)
+		threadPool.submit([this, slice](){
+			assignSlice(slice);
+		});
+	threadPool.wait();
+
+	//slices were filled independently, their ranges are offset by the slices before them
+	int total = 0;
+	for(int slice = 0; slice < gridSize.z; slice++)
+		total += int(sliceIndices[slice].size());
+	glNamedBufferData(indexBuffer, std::max(total, 1) * sizeof(uint32_t), nullptr, GL_STREAM_DRAW);
+	int offset = 0;
+	for(int slice = 0; slice < gridSize.z; slice++)
+	{
+		auto const& indices = sliceIndices[slice];
+		int const first = gridSize.x * gridSize.y * slice;
+		for(int cluster = first; cluster < first + gridSize.x * gridSize.y; cluster++)
+		{
+			clusters[cluster].x += offset;
+			stats.maxClusterLights = std::max(stats.maxClusterLights, int(clusters[cluster].y));
+		}
+		if(!indices.empty())
+			glNamedBufferSubData(indexBuffer, offset * sizeof(uint32_t), indices.size() * sizeof(uint32_t), indices.data());
+		offset += int(indices.size());
+	}
+	stats.assignedIndices = total;
+	glNamedBufferSubData(clusterBuffer, sizeof(Header), clusterCount * sizeof(glm::uvec2), clusters.data());
+}
+
+void LightClusters::assignOnGPU()
+{
+	//every cluster owns a fixed number of index slots, lights beyond that are dropped
+	int const clusterCount = getClusterCount();
+	glNamedBufferData(indexBuffer, clusterCount * maxComputeClusterLights * sizeof(uint32_t), nullptr, GL_STREAM_DRAW);
+	bind();
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, boundsBuffer);
+	Shader* shader = ShaderManager::clusterLights();
+	shader->use();
+	shader->set("firstLight", directionalLights);
+	shader->set("lightCount", int(lights.size()));
+	shader->set("maxClusterLights", maxComputeClusterLights);
+	glDispatchCompute((clusterCount + 63) / 64, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	stats.assignedIndices = -1;
+	stats.maxClusterLights = -1;
+}
+
+void LightClusters::update(Scene const& scene, Camera const& camera, int viewportWidth, int viewportHeight, ShadowAtlas const* shadows,
+	int firstCascade, bool flashHighlighted)
+{
+	auto const start = std::chrono::steady_clock::now();
+	glm::mat4 const viewMatrix = camera.getViewMatrix();
+	lights.clear();
+	auto const pack = [&](auto const& sceneLights, LightType type){
+		int const cascade = type == directional ? firstCascade : 0;
+		for(auto light : sceneLights)
+		{
+			bool const enabled = light->isEnabled();
+			int const shadow = shadows && enabled ? shadows->getShadow(light, cascade) : -1;
+			if(!enabled && !light->isHighlighted())
+				continue;
+			GPULight packed{};
+			packed.color = light->getColor();
+			packed.intensity = light->getIntensity(flashHighlighted && light->isHighlighted());
+			packed.type = type;
+			packed.shadow = shadow;
+			packed.cascades = shadow != -1 ? shadows->getCascades(light, cascade) : 0;
+			if constexpr(!std::is_same_v<std::decay_t<decltype(*light)>, DirectionalLight>)
+			{
+				packed.worldPosition = light->getPosition();
+				packed.position = glm::vec3{viewMatrix * glm::vec4{packed.worldPosition, 1.0f}};
+				packed.range = light->getRange(attenuationCutoff);
+			}
+			if constexpr(!std::is_same_v<std::decay_t<decltype(*light)>, PointLight>)
+				packed.direction = glm::vec3{viewMatrix * glm::vec4{light->getDirection(), 0.0f}};
+			if constexpr(std::is_same_v<std::decay_t<decltype(*light)>, SpotLight>)
+			{
+				packed.innerCutoff = glm::cos(glm::radians(light->getInnerCutoff()));
+				packed.outerCutoff = glm::cos(glm::radians(light->getOuterCutoff()));
+			}
+			lights.push_back(packed);
+		}
+	};
+	pack(scene.getAll<DirectionalLight>(), directional);
+	directionalLights = int(lights.size());
+	pack(scene.getAll<PointLight>(), point);
+	pack(scene.getAll<SpotLight>(), spot);
+	stats.clusteredLights = int(lights.size()) - directionalLights;
+	stats.maxClusterLights = 0;
+	glNamedBufferData(lightBuffer, std::max<std::size_t>(lights.size(), 1) * sizeof(GPULight), lights.data(), GL_STREAM_DRAW);
+
+	float const nearPlane = camera.getNearPlane();
+	float const farPlane = camera.getFarPlane();
+	updateBounds(camera.getProjectionMatrix(), nearPlane, farPlane);
+	//fragments find their slice as log(depth) * scale - bias
+	float const depthScale = gridSize.z / std::log(farPlane / nearPlane);
+	Header const header{
+		glm::uvec4{gridSize, 0},
+		glm::vec4{float(viewportWidth) / gridSize.x, float(viewportHeight) / gridSize.y, depthScale, std::log(nearPlane) * depthScale}
+	};
+	glNamedBufferData(clusterBuffer, sizeof(Header) + getClusterCount() * sizeof(glm::uvec2), nullptr, GL_STREAM_DRAW);
+	glNamedBufferSubData(clusterBuffer, 0, sizeof(Header), &header);
+	if(computeAssignment)
+		assignOnGPU();
+	else
+		assignOnCPU();
+	stats.assignmentTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void LightClusters::bind() const
+{
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, lightBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, clusterBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, indexBuffer);
+}
+
+int LightClusters::getDirectionalLightCount() const
+{
+	return directionalLights;
+}
+
+float LightClusters::getAttenuationCutoff() const
+{
+	return attenuationCutoff;
+}
+
+void LightClusters::drawUI()
+{
+	IDGuard idGuard{this};
+	ImGui::InputInt3("Grid", &gridSize.x);
+	gridSize = glm::clamp(gridSize, glm::ivec3{1}, glm::ivec3{64});
+	ImGui::DragFloat("Attenuation Cutoff", &attenuationCutoff, 0.0001f, 0.0001f, 1.0f, "%.4f");
+	ImGui::Checkbox("Assign On GPU", &computeAssignment);
+	if(computeAssignment)
+	{
+		ImGui::InputInt("Max Lights Per Cluster", &maxComputeClusterLights);
+		maxComputeClusterLights = std::clamp(maxComputeClusterLights, 1, 1024);
+	}
+	ImGui::Text("Clustered Lights: %i", stats.clusteredLights);
+	ImGui::Text("Clusters: %i", getClusterCount());
+	if(!computeAssignment)
+	{
+		ImGui::Text("Light Indices: %i", stats.assignedIndices);
+		ImGui::Text("Most Lights In A Cluster: %i", stats.maxClusterLights);
+	}
+	ImGui::Text("Assignment: %.3f ms", stats.assignmentTime);
+}
@@ -6,9 +6,17 @@
 #include <GLFW\glfw3.h>
 #include <glad/glad.h>
 
+Light::Uniforms::Uniforms(std::string const& prefix)
+	:color(prefix + "color"), intensity(prefix + "intensity"), direction(prefix + "direction"),
+	position(prefix + "position"), worldPosition(prefix + "worldPosition"),
+	innerCutoff(prefix + "innerCutoff"), outerCutoff(prefix + "outerCutoff")
+{
+}
+
 void Light::setColor(glm::vec3 color)
 {
 	this->color = color;
+	parametersOutdated();
 }
 
 glm::vec3 const& Light::getColor() const
@@ -19,6 +27,7 @@ glm::vec3 const& Light::getColor() const
 void Light::setIntensity(float intensity)
 {
 	this->intensity = intensity;
+	parametersOutdated();
 }
 
 float Light::getIntensity() const
@@ -26,19 +35,31 @@ float Light::getIntensity() const
 	return intensity;
 }
 
-void Light::use(std::string const& prefix, Shader& shader, bool flash) const
+float Light::getIntensity(bool flash) const
 {
-	shader.set(prefix + "color", getColor());
 	if(flash)
-		shader.set(prefix + "intensity", static_cast<float>(((std::sin(glfwGetTime()*10) + 1.0f) / 2.0f) * getIntensity()));
-	else
-		shader.set(prefix + "intensity", getIntensity());
+		return static_cast<float>(((std::sin(glfwGetTime()*10) + 1.0f) / 2.0f) * getIntensity());
+	return getIntensity();
+}
+
+float Light::getRange(float cutoff) const
+{
+	float const brightest = glm::max(color.r, glm::max(color.g, color.b));
+	return std::sqrt(glm::max(intensity * brightest, 0.0f) / cutoff);
+}
+
+void Light::use(Uniforms const& uniforms, Shader& shader, bool flash) const
+{
+	shader.set(uniforms.color, getColor());
+	shader.set(uniforms.intensity, getIntensity(flash));
 }
 
 void Light::drawUI()
 {
-	ImGui::ColorEdit3("Color", &Light::color.x, ImGuiColorEditFlags_NoInputs | ImGuiColorEditFlags_Float);
-	ImGui::DragFloat("Intensity", &intensity, 0.1f);
+	if(ImGui::ColorEdit3("Color", &Light::color.x, ImGuiColorEditFlags_NoInputs | ImGuiColorEditFlags_Float))
+		parametersOutdated();
+	if(ImGui::DragFloat("Intensity", &intensity, 0.1f))
+		parametersOutdated();
 }
 
 std::string DirectionalLight::getNamePrefix() const
@@ -46,13 +67,23 @@ std::string DirectionalLight::getNamePrefix() const
 	return "light(D)";
 }
 
-void DirectionalLight::use(std::string const& prefix, glm::mat4 const& viewMatrix, Shader& shader, bool flash) const
+void DirectionalLight::parametersOutdated()
 {
-	Light::use(prefix, shader, flash);
+	updateTimestamp();
+}
+
+NodeType DirectionalLight::getType() const
+{
+	return type;
+}
+
+void DirectionalLight::use(Uniforms const& uniforms, glm::mat4 const& viewMatrix, Shader& shader, bool flash) const
+{
+	Light::use(uniforms, shader, flash);
 	auto[t, r, s] = decomposeTransformation(getGlobalTransformation());
 	glm::vec3 direction = glm::mat3_cast(r) * glm::vec3{0.0f, 0.0f, -1.0f};
 	direction = glm::normalize(direction);
-	shader.set(prefix + "direction", glm::vec3(viewMatrix * glm::vec4(direction, 0.0f)));
+	shader.set(uniforms.direction, glm::vec3(viewMatrix * glm::vec4(direction, 0.0f)));
 }
 
 void DirectionalLight::drawUI()
@@ -66,11 +97,21 @@ std::string PointLight::getNamePrefix() const
 	return "light(P)";
 }
 
-void PointLight::use(std::string const& prefix, glm::mat4 const& viewMatrix, Shader& shader, bool flash) const
+void PointLight::parametersOutdated()
+{
+	updateTimestamp();
+}
+
+NodeType PointLight::getType() const
+{
+	return type;
+}
+
+void PointLight::use(Uniforms const& uniforms, glm::mat4 const& viewMatrix, Shader& shader, bool flash) const
 {
-	Light::use(prefix, shader, flash);
-	shader.set(prefix + "position", glm::vec3(viewMatrix * glm::vec4(getPosition(), 1.0f)));
-	shader.set(prefix + "worldPosition", getPosition());
+	Light::use(uniforms, shader, flash);
+	shader.set(uniforms.position, glm::vec3(viewMatrix * glm::vec4(getPosition(), 1.0f)));
+	shader.set(uniforms.worldPosition, getPosition());
 }
 
 void PointLight::drawUI()
@@ -84,10 +125,21 @@ std::string SpotLight::getNamePrefix() const
 	return "light(S)";
 }
 
+void SpotLight::parametersOutdated()
+{
+	updateTimestamp();
+}
+
+NodeType SpotLight::getType() const
+{
+	return type;
+}
+
 void SpotLight::setCutoff(float inner, float outer)
 {
 	this->innerCutoff = inner;
 	this->outerCutoff = outer;
+	parametersOutdated();
 }
 
 float SpotLight::getInnerCutoff() const
@@ -100,19 +152,21 @@ float SpotLight::getOuterCutoff() const
 	return outerCutoff;
 }
 
-void SpotLight::use(std::string const& prefix, glm::mat4 const& viewMatrix, Shader& shader, bool flash) const
+void SpotLight::use(Uniforms const& uniforms, glm::mat4 const& viewMatrix, Shader& shader, bool flash) const
 {
-	Light::use(prefix, shader, flash);
-	shader.set(prefix + "position", glm::vec3(viewMatrix * glm::vec4{getPosition(), 1.0f}));
-	shader.set(prefix + "direction", glm::vec3(viewMatrix * glm::vec4{getDirection(), 0.0f}));
-	shader.set(prefix + "innerCutoff", glm::cos(glm::radians(getInnerCutoff())));
-	shader.set(prefix + "outerCutoff", glm::cos(glm::radians(getOuterCutoff())));
+	Light::use(uniforms, shader, flash);
+	shader.set(uniforms.position, glm::vec3(viewMatrix * glm::vec4{getPosition(), 1.0f}));
+	shader.set(uniforms.direction, glm::vec3(viewMatrix * glm::vec4{getDirection(), 0.0f}));
+	shader.set(uniforms.innerCutoff, glm::cos(glm::radians(getInnerCutoff())));
+	shader.set(uniforms.outerCutoff, glm::cos(glm::radians(getOuterCutoff())));
 }
 
 void SpotLight::drawUI()
 {
 	Transformed<Translation, Rotation>::drawUI();
 	Light::drawUI();
-	ImGui::DragFloat("Inner Cutoff", &innerCutoff, 0.1f);
-	ImGui::DragFloat("Outer Cutoff", &outerCutoff, 0.1f);
+	if(ImGui::DragFloat("Inner Cutoff", &innerCutoff, 0.1f))
+		parametersOutdated();
+	if(ImGui::DragFloat("Outer Cutoff", &outerCutoff, 0.1f))
+		parametersOutdated();
 }
@@ -0,0 +1,83 @@
+#include "MappedFile.h"
+
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+MappedFile::MappedFile(std::string_view const filename)
+{
+	file = CreateFileA(std::string(filename).data(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if(file == INVALID_HANDLE_VALUE)
+	{
+		file = nullptr;
+		return;
+	}
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+		return;
+	mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if(!mapping)
+		return;
+	data = static_cast<uint8_t const*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if(data)
+		size = uint64_t(fileSize.QuadPart);
+}
+
+MappedFile::~MappedFile()
+{
+	if(data)
+		UnmapViewOfFile(data);
+	if(mapping)
+		CloseHandle(mapping);
+	if(file)
+		CloseHandle(file);
+}
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(std::string_view const filename)
+{
+	int const file = open(std::string(filename).data(), O_RDONLY);
+	if(file == -1)
+		return;
+	struct stat fileStat;
+	if(fstat(file, &fileStat) == 0 && fileStat.st_size > 0)
+	{
+		void* const view = mmap(nullptr, size_t(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+		if(view != MAP_FAILED)
+		{
+			data = static_cast<uint8_t const*>(view);
+			size = uint64_t(fileStat.st_size);
+		}
+	}
+	//the mapping stays valid after the descriptor is closed
+	close(file);
+}
+
+MappedFile::~MappedFile()
+{
+	if(data)
+		munmap(const_cast<uint8_t*>(data), size_t(size));
+}
+#endif
+
+bool MappedFile::isOpen() const
+{
+	return data != nullptr;
+}
+
+uint8_t const* MappedFile::getData() const
+{
+	return data;
+}
+
+uint64_t MappedFile::getSize() const
+{
+	return size;
+}
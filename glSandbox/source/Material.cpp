@@ -8,44 +8,63 @@ std::string Material::getNamePrefix() const
 	return "material";
 }
 
+void Material::updateTimestamp()
+{
+	Timestamp::updateTimestamp();
+	latestTimestamp = getTimestamp();
+}
+
+uint64_t Material::getLatestTimestamp()
+{
+	return latestTimestamp;
+}
+
 void Material::setNormalMap(Texture* map)
 {
 	normalMap = map;
+	updateTimestamp();
 }
 
 void Material::enableNormalMapping()
 {
 	normalMapping = true;
+	updateTimestamp();
 }
 
 void Material::disableNormalMapping()
 {
 	normalMapping = false;
+	updateTimestamp();
 }
 
 void Material::setOcclusionMap(Texture* map)
 {
 	occlusionMap = map;
+	updateTimestamp();
 }
 
 void Material::enableOcclusionMapping()
 {
 	occlusionMapping = true;
+	updateTimestamp();
 }
 
 void Material::disableOcclusionMapping()
 {
 	occlusionMapping = false;
+	updateTimestamp();
 }
 
 void Material::setEmissiveMap(Texture* map)
 {
 	emissiveMap = map;
+	updateTimestamp();
 }
 
 void Material::setEmissiveFactor(glm::vec3 factor)
 {
 	emissiveFactor = factor;
+	updateTimestamp();
 }
 
 
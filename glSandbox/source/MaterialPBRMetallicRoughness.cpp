@@ -6,26 +6,31 @@
 void MaterialPBRMetallicRoughness::setBaseColorMap(Texture* map)
 {
 	baseColorMap = map;
+	updateTimestamp();
 }
 
 void MaterialPBRMetallicRoughness::setBaseColorFactor(glm::vec4 factor)
 {
 	baseColorFactor = factor;
+	updateTimestamp();
 }
 
 void MaterialPBRMetallicRoughness::setMetallicRoughnessMap(Texture* map)
 {
 	metallicRoughnessMap = map;
+	updateTimestamp();
 }
 
 void MaterialPBRMetallicRoughness::setMetallicFactor(float factor)
 {
 	metallicFactor = factor;
+	updateTimestamp();
 }
 
 void MaterialPBRMetallicRoughness::setRoughnessFactor(float factor)
 {
 	roughnessFactor = factor;
+	updateTimestamp();
 }
 
 void MaterialPBRMetallicRoughness::use(Shader* shader, Material::Map visualizeMap) const
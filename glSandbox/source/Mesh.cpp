@@ -1,81 +1,174 @@
 #include "Mesh.h"
 #include "MeshRenderer.h"
+#include "TriangleBVH.h"
 #include "UIUtilities.h"
 
 #include <imgui.h>
+#include <cstring>
+#include <algorithm>
 
 Mesh::Mesh(Bounds bounds, GLenum drawMode, Attributes&& attributes, std::optional<IndexBuffer>&& indices)
 	: bounds(bounds), drawMode(drawMode), 
 	vertexCount((attributes.interleaved ? attributes.size : attributes.array[AttributeType::positions]->size) / attributes.array[AttributeType::positions]->stride),
-	indexCount(indices? indices->count : 0), indexDataType(indices? indices->dataType : 0), indexedDrawing(indices)
+	indexCount(indices? indices->count : 0), indexDataType(!indices ? 0 : indices->dataType == GL_UNSIGNED_BYTE ? GL_UNSIGNED_SHORT : indices->dataType), indexedDrawing(indices)
 {
+	static_assert(MeshArena::attributeSlots == AttributeType::N && MeshArena::positionSlot == AttributeType::positions);
 	for(int i = 0; i < AttributeType::N; i++)
 		availableAttributes[i] = attributes.array[i].has_value();
 
-	glGenVertexArrays(1, &VAO);
-	glBindVertexArray(VAO);
-
-	glGenBuffers(1, &VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-
-	if(attributes.interleaved)
+	//byte indices are widened, hardware handles them poorly and they would need pools of their own
+	std::vector<uint16_t> widenedIndices;
+	if(indices && indices->dataType == GL_UNSIGNED_BYTE)
 	{
-		glBufferData(GL_ARRAY_BUFFER, attributes.size, attributes.data, GL_STATIC_DRAW);
-
-		for(auto const& attribute : attributes.array)
-		{
-			if(!attribute)
-				continue;
-			glEnableVertexAttribArray(attribute->attributeType);
-			glVertexAttribPointer(attribute->attributeType, attribute->componentSize, attribute->dataType, GL_FALSE, attribute->stride, (void*) (attribute->offset));
-		}
+		widenedIndices.assign(indices->data, indices->data + indices->count);
+		indices->data = reinterpret_cast<uint8_t const*>(widenedIndices.data());
+		indices->size = widenedIndices.size() * sizeof(uint16_t);
+		indices->dataType = GL_UNSIGNED_SHORT;
 	}
-	else
-	{
-		size_t bufferSize = 0;
-		for(auto const& attribute : attributes.array)
-			bufferSize += attribute ? attribute->size : 0;
-		glBufferData(GL_ARRAY_BUFFER, bufferSize, nullptr, GL_STATIC_DRAW);
+	copyOccluderGeometry(attributes, indices);
 
-		size_t offset = 0;
-		for(auto const& attribute : attributes.array)
-		{
-			if(!attribute)
-				continue;
-			glBufferSubData(GL_ARRAY_BUFFER, offset, attribute->size, attribute->data);
-			glEnableVertexAttribArray(attribute->attributeType);
-			glVertexAttribPointer(attribute->attributeType, attribute->componentSize, attribute->dataType, GL_FALSE, attribute->stride, (void*) (offset));
-			offset += attribute->size;
-		}
-	}
+	MeshArena::Format format;
+	format.indexDataType = indexDataType;
+	for(auto const& attribute : attributes.array)
+		if(attribute)
+			format.attributes[attribute->attributeType] = {attribute->componentSize, attribute->dataType};
+	MeshArena& arena = MeshArena::shared();
+	int const pool = arena.getPool(format);
+	auto const& vertexLayout = arena.getVertexLayout(pool);
 
-	if(indices)
+	//every format has one interleaved layout, so vertices are repacked into it whatever layout they came in,
+	//positions are deinterleaved into a tightly packed stream for depth only passes as well
+	std::vector<uint8_t> vertices(uint64_t(vertexCount) * vertexLayout.stride);
+	std::vector<uint8_t> positions;
+	for(auto const& attribute : attributes.array)
 	{
-		glGenBuffers(1, &EBO);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices->size, indices->data, GL_STATIC_DRAW);
+		if(!attribute)
+			continue;
+		uint8_t const* source = attributes.interleaved ? attributes.data + attribute->offset : attribute->data;
+		uint32_t const offset = vertexLayout.offsets[attribute->attributeType];
+		uint32_t const size = vertexLayout.sizes[attribute->attributeType];
+		for(uint32_t vertex = 0; vertex < vertexCount; vertex++)
+			std::memcpy(&vertices[uint64_t(vertex) * vertexLayout.stride + offset], source + uint64_t(vertex) * attribute->stride, size);
+		if(attribute->attributeType != AttributeType::positions)
+			continue;
+		positions.resize(uint64_t(vertexCount) * size);
+		for(uint32_t vertex = 0; vertex < vertexCount; vertex++)
+			std::memcpy(&positions[uint64_t(vertex) * size], source + uint64_t(vertex) * attribute->stride, size);
 	}
+	arenaRange = arena.allocate(pool, vertices.data(), positions.data(), vertexCount, indices ? indices->data : nullptr, indexCount);
 
-	glBindVertexArray(0);
+	layout.interleaved = true;
+	layout.data = nullptr;
+	layout.size = uint64_t(vertexCount) * vertexLayout.stride;
+	for(auto const& attribute : attributes.array)
+	{
+		if(!attribute)
+			continue;
+		auto& packed = layout.array[attribute->attributeType];
+		packed = attribute;
+		packed->data = nullptr;
+		packed->size = layout.size;
+		packed->stride = vertexLayout.stride;
+		packed->offset = vertexLayout.offsets[attribute->attributeType];
+	}
 }
 
 Mesh::Mesh(Mesh&& other)
-	: bounds(other.bounds), drawMode(other.drawMode), vertexCount(other.vertexCount),
+	: arenaRange(other.arenaRange), drawMode(other.drawMode), vertexCount(other.vertexCount),
 	indexCount(other.indexCount), indexDataType(other.indexDataType), indexedDrawing(other.indexedDrawing),
-	VAO(other.VAO), VBO(other.VBO), EBO(other.EBO)
+	bounds(other.bounds), layout(other.layout), occluderGeometry(std::move(other.occluderGeometry)),
+	triangleBVH(std::move(other.triangleBVH))
 {
 	for(int i = 0; i < AttributeType::N; i++)
 		availableAttributes[i] = other.availableAttributes[i];
-	other.VAO = 0;
-	other.VBO = 0;
-	other.EBO = 0;
+	other.arenaRange = {};
 }
 
 Mesh::~Mesh()
 {
-	glDeleteVertexArrays(1, &VAO);
-	glDeleteBuffers(1, &VBO);
-	glDeleteBuffers(1, &EBO);
+	MeshArena::shared().release(arenaRange);
+}
+
+bool Mesh::hasTrianglePositions(Attributes const& attributes) const
+{
+	auto const& positions = attributes.array[AttributeType::positions];
+	return hasSurface() && positions && positions->dataType == GL_FLOAT && positions->componentSize == 3;
+}
+
+std::optional<Mesh::OccluderGeometry> Mesh::extractTriangles(uint8_t const* positionData, uint64_t positionDataSize, uint32_t stride, uint8_t const* indexData) const
+{
+	OccluderGeometry geometry;
+	geometry.positions.reserve(vertexCount);
+	for(uint64_t offset = 0; offset + sizeof(glm::vec3) <= positionDataSize && geometry.positions.size() < vertexCount; offset += stride)
+	{
+		glm::vec3 position;
+		std::memcpy(&position, positionData + offset, sizeof(glm::vec3));
+		geometry.positions.push_back(position);
+	}
+
+	uint32_t const elementCount = indexedDrawing ? indexCount : vertexCount;
+	std::vector<uint32_t> elements;
+	elements.reserve(elementCount);
+	for(uint32_t i = 0; i < elementCount; i++)
+	{
+		uint32_t index = i;
+		if(indexedDrawing)
+		{
+			switch(indexDataType)
+			{
+				case GL_UNSIGNED_BYTE:
+					index = indexData[i];
+					break;
+				case GL_UNSIGNED_SHORT:
+					index = reinterpret_cast<uint16_t const*>(indexData)[i];
+					break;
+				default:
+					index = reinterpret_cast<uint32_t const*>(indexData)[i];
+					break;
+			}
+		}
+		if(index >= geometry.positions.size())
+			return std::nullopt;
+		elements.push_back(index);
+	}
+
+	switch(drawMode)
+	{
+		case GL_TRIANGLES:
+			elements.resize(elements.size() / 3 * 3);
+			geometry.indices = std::move(elements);
+			break;
+		case GL_TRIANGLE_STRIP:
+			geometry.indices.reserve(elements.size() < 3 ? 0 : (elements.size() - 2) * 3);
+			for(std::size_t i = 2; i < elements.size(); i++)
+			{
+				//every other triangle is flipped to keep the winding consistent
+				bool const odd = i % 2;
+				geometry.indices.insert(geometry.indices.end(), {elements[i - 2], elements[odd ? i : i - 1], elements[odd ? i - 1 : i]});
+			}
+			break;
+		case GL_TRIANGLE_FAN:
+			geometry.indices.reserve(elements.size() < 3 ? 0 : (elements.size() - 2) * 3);
+			for(std::size_t i = 2; i < elements.size(); i++)
+				geometry.indices.insert(geometry.indices.end(), {elements[0], elements[i - 1], elements[i]});
+			break;
+	}
+	return geometry;
+}
+
+void Mesh::copyOccluderGeometry(Attributes const& attributes, std::optional<IndexBuffer> const& indices)
+{
+	if(!hasTrianglePositions(attributes))
+		return;
+	uint32_t const elementCount = indexedDrawing ? indexCount : vertexCount;
+	uint32_t const triangleCount = drawMode == GL_TRIANGLES ? elementCount / 3 : std::max(elementCount, 2u) - 2;
+	if(triangleCount > maxOccluderTriangles)
+		return;
+
+	auto const& positions = attributes.array[AttributeType::positions];
+	uint8_t const* positionData = attributes.interleaved ? attributes.data + positions->offset : positions->data;
+	uint64_t const positionDataSize = attributes.interleaved ? attributes.size - positions->offset : positions->size;
+	occluderGeometry = extractTriangles(positionData, positionDataSize, positions->stride, indices ? indices->data : nullptr);
 }
 
 std::string Mesh::getNamePrefix() const
@@ -98,14 +191,57 @@ Bounds const& Mesh::getBounds() const
 	return bounds;
 }
 
-void Mesh::use() const
+Mesh::OccluderGeometry const* Mesh::getOccluderGeometry() const
 {
-	glBindVertexArray(VAO);
+	return occluderGeometry ? &*occluderGeometry : nullptr;
+}
+
+TriangleBVH const* Mesh::getTriangleBVH() const
+{
+	if(triangleBVH || !hasTrianglePositions(layout))
+		return triangleBVH.get();
+	if(occluderGeometry)
+	{
+		triangleBVH = std::make_unique<TriangleBVH>(occluderGeometry->positions, occluderGeometry->indices);
+		return triangleBVH.get();
+	}
+
+	//larger meshes only live on the gpu, so their positions and indices are read back once, from the packed positions
+	MeshArena const& arena = MeshArena::shared();
+	uint64_t const positionDataSize = uint64_t(vertexCount) * sizeof(glm::vec3);
+	std::vector<uint8_t> positionData(positionDataSize);
+	glGetNamedBufferSubData(arena.getPositionBuffer(arenaRange.pool), arena.getPositionOffset(arenaRange), positionDataSize, positionData.data());
+	std::vector<uint8_t> indexData;
 	if(indexedDrawing)
-		glDrawElements(drawMode, indexCount, indexDataType, 0);
-	else
-		glDrawArrays(drawMode, 0, vertexCount);
-	glBindVertexArray(0);
+	{
+		int const indexSize = indexDataType == GL_UNSIGNED_SHORT ? 2 : 4;
+		indexData.resize(uint64_t(indexCount) * indexSize);
+		glGetNamedBufferSubData(arena.getIndexBuffer(arenaRange.pool), arena.getIndexOffset(arenaRange), indexData.size(), indexData.data());
+	}
+	auto const geometry = extractTriangles(positionData.data(), positionDataSize, sizeof(glm::vec3), indexData.data());
+	if(geometry)
+		triangleBVH = std::make_unique<TriangleBVH>(geometry->positions, geometry->indices);
+	return triangleBVH.get();
+}
+
+GLenum Mesh::getDrawMode() const
+{
+	return drawMode;
+}
+
+MeshArena::Range const& Mesh::getArenaRange() const
+{
+	return arenaRange;
+}
+
+void Mesh::use() const
+{
+	MeshArena::shared().draw(arenaRange, drawMode);
+}
+
+void Mesh::use(int instanceCount, int baseInstance, bool positionsOnly) const
+{
+	MeshArena::shared().draw(arenaRange, drawMode, instanceCount, baseInstance, positionsOnly);
 }
 
 void Mesh::drawUI()
@@ -113,13 +249,13 @@ void Mesh::drawUI()
 	IDGuard idGuard{this};
 
 	ImGui::BeginChild("###Mesh");
-	ImGui::Value("VAO", VAO);
+	ImGui::Value("Arena Pool", arenaRange.pool);
 	ImGui::SameLine();
-	ImGui::Value("VBO", VBO);
+	ImGui::Value("Base Vertex", arenaRange.baseVertex);
 	if(indexedDrawing)
 	{
 		ImGui::SameLine();
-		ImGui::Value("EBO", EBO);
+		ImGui::Value("First Index", arenaRange.firstIndex);
 	}
 	ImGui::Value("vertices", vertexCount);
 	if(indexedDrawing)
@@ -129,6 +265,10 @@ void Mesh::drawUI()
 		ImGui::SameLine();
 		ImGui::Text(glEnumToString(indexDataType).data());
 	}
+	if(occluderGeometry)
+		ImGui::Text("Occluder: %i triangles", int(occluderGeometry->indices.size() / 3));
+	if(triangleBVH)
+		ImGui::Text("Triangle BVH: %i nodes (%i KB)", triangleBVH->getNodeCount(), int(triangleBVH->getMemoryUsage() / 1024));
 	ImGui::Text("Draw Mode:");
 	ImGui::SameLine();
 	ImGui::Text(glEnumToString(drawMode).data());
@@ -0,0 +1,336 @@
+#include "MeshArena.h"
+#include "UIUtilities.h"
+
+#include <imgui.h>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace
+{
+	constexpr uint32_t minVertexCapacity = 1 << 16;
+	constexpr uint32_t minIndexCapacity = 1 << 18;
+
+	uint32_t getTypeSize(GLenum dataType)
+	{
+		switch(dataType)
+		{
+			case GL_BYTE:
+			case GL_UNSIGNED_BYTE:
+				return 1;
+			case GL_SHORT:
+			case GL_UNSIGNED_SHORT:
+			case GL_HALF_FLOAT:
+				return 2;
+			default:
+				return 4;
+		}
+	}
+}
+
+MeshArena::~MeshArena()
+{
+	for(auto& pool : pools)
+	{
+		glDeleteVertexArrays(1, &pool.VAO);
+		glDeleteBuffers(1, &pool.VBO);
+		glDeleteBuffers(1, &pool.EBO);
+		glDeleteVertexArrays(1, &pool.positionVAO);
+		glDeleteBuffers(1, &pool.positionVBO);
+	}
+}
+
+bool MeshArena::matches(Format const& lhs, Format const& rhs)
+{
+	if(lhs.indexDataType != rhs.indexDataType)
+		return false;
+	for(int i = 0; i < attributeSlots; i++)
+		if(lhs.attributes[i].componentSize != rhs.attributes[i].componentSize ||
+			(lhs.attributes[i].componentSize && lhs.attributes[i].dataType != rhs.attributes[i].dataType))
+			return false;
+	return true;
+}
+
+bool MeshArena::allocateRange(std::map<uint32_t, uint32_t>& freeRanges, uint32_t count, uint32_t& first)
+{
+	for(auto it = freeRanges.begin(); it != freeRanges.end(); ++it)
+	{
+		if(it->second < count)
+			continue;
+		first = it->first;
+		uint32_t const remaining = it->second - count;
+		freeRanges.erase(it);
+		if(remaining)
+			freeRanges.emplace(first + count, remaining);
+		return true;
+	}
+	return false;
+}
+
+void MeshArena::freeRange(std::map<uint32_t, uint32_t>& freeRanges, uint32_t first, uint32_t count)
+{
+	auto next = freeRanges.lower_bound(first);
+	if(next != freeRanges.begin())
+	{
+		auto previous = std::prev(next);
+		if(previous->first + previous->second == first)
+		{
+			first = previous->first;
+			count += previous->second;
+			freeRanges.erase(previous);
+		}
+	}
+	if(next != freeRanges.end() && first + count == next->first)
+	{
+		count += next->second;
+		freeRanges.erase(next);
+	}
+	freeRanges.emplace(first, count);
+}
+
+void MeshArena::growBuffer(unsigned int& buffer, GLsizeiptr oldSize, GLsizeiptr newSize)
+{
+	unsigned int grown;
+	glCreateBuffers(1, &grown);
+	glNamedBufferStorage(grown, newSize, nullptr, GL_DYNAMIC_STORAGE_BIT);
+	if(buffer)
+	{
+		glCopyNamedBufferSubData(buffer, grown, 0, 0, oldSize);
+		glDeleteBuffers(1, &buffer);
+	}
+	buffer = grown;
+}
+
+int MeshArena::createPool(Format const& format)
+{
+	Pool pool;
+	pool.format = format;
+	for(int i = 0; i < attributeSlots; i++)
+	{
+		auto const& attribute = format.attributes[i];
+		if(!attribute.componentSize)
+			continue;
+		pool.layout.offsets[i] = pool.layout.stride;
+		pool.layout.sizes[i] = attribute.componentSize * getTypeSize(attribute.dataType);
+		pool.layout.stride += (pool.layout.sizes[i] + 3) / 4 * 4;
+	}
+	pool.indexSize = format.indexDataType ? getTypeSize(format.indexDataType) : 0;
+
+	glCreateVertexArrays(1, &pool.VAO);
+	for(int i = 0; i < attributeSlots; i++)
+	{
+		auto const& attribute = format.attributes[i];
+		if(!attribute.componentSize)
+			continue;
+		glEnableVertexArrayAttrib(pool.VAO, i);
+		glVertexArrayAttribFormat(pool.VAO, i, attribute.componentSize, attribute.dataType, GL_FALSE, pool.layout.offsets[i]);
+		glVertexArrayAttribBinding(pool.VAO, i, 0);
+	}
+	auto const& positions = format.attributes[positionSlot];
+	if(positions.componentSize)
+	{
+		pool.positionSize = pool.layout.sizes[positionSlot];
+		glCreateVertexArrays(1, &pool.positionVAO);
+		glEnableVertexArrayAttrib(pool.positionVAO, positionSlot);
+		glVertexArrayAttribFormat(pool.positionVAO, positionSlot, positions.componentSize, positions.dataType, GL_FALSE, 0);
+		glVertexArrayAttribBinding(pool.positionVAO, positionSlot, 0);
+	}
+	pools.push_back(std::move(pool));
+	return int(pools.size()) - 1;
+}
+
+uint32_t MeshArena::allocateVertices(Pool& pool, uint32_t count)
+{
+	uint32_t first;
+	if(allocateRange(pool.freeVertices, count, first))
+		return first;
+	uint32_t const capacity = std::max({pool.vertexCapacity * 2, pool.vertexCapacity + count, minVertexCapacity});
+	growBuffer(pool.VBO, GLsizeiptr(pool.vertexCapacity) * pool.layout.stride, GLsizeiptr(capacity) * pool.layout.stride);
+	glVertexArrayVertexBuffer(pool.VAO, 0, pool.VBO, 0, pool.layout.stride);
+	if(pool.positionSize)
+	{
+		growBuffer(pool.positionVBO, GLsizeiptr(pool.vertexCapacity) * pool.positionSize, GLsizeiptr(capacity) * pool.positionSize);
+		glVertexArrayVertexBuffer(pool.positionVAO, 0, pool.positionVBO, 0, pool.positionSize);
+	}
+	freeRange(pool.freeVertices, pool.vertexCapacity, capacity - pool.vertexCapacity);
+	pool.vertexCapacity = capacity;
+	stats.growths++;
+	allocateRange(pool.freeVertices, count, first);
+	return first;
+}
+
+uint32_t MeshArena::allocateIndices(Pool& pool, uint32_t count)
+{
+	uint32_t first;
+	if(allocateRange(pool.freeIndices, count, first))
+		return first;
+	uint32_t const capacity = std::max({pool.indexCapacity * 2, pool.indexCapacity + count, minIndexCapacity});
+	growBuffer(pool.EBO, GLsizeiptr(pool.indexCapacity) * pool.indexSize, GLsizeiptr(capacity) * pool.indexSize);
+	glVertexArrayElementBuffer(pool.VAO, pool.EBO);
+	if(pool.positionVAO)
+		glVertexArrayElementBuffer(pool.positionVAO, pool.EBO);
+	freeRange(pool.freeIndices, pool.indexCapacity, capacity - pool.indexCapacity);
+	pool.indexCapacity = capacity;
+	stats.growths++;
+	allocateRange(pool.freeIndices, count, first);
+	return first;
+}
+
+MeshArena& MeshArena::shared()
+{
+	static MeshArena* arena = new MeshArena;
+	return *arena;
+}
+
+int MeshArena::getPool(Format const& format)
+{
+	for(int i = 0; i < int(pools.size()); i++)
+		if(matches(pools[i].format, format))
+			return i;
+	return createPool(format);
+}
+
+MeshArena::VertexLayout const& MeshArena::getVertexLayout(int pool) const
+{
+	return pools[pool].layout;
+}
+
+GLenum MeshArena::getIndexDataType(int pool) const
+{
+	return pools[pool].format.indexDataType;
+}
+
+MeshArena::Range MeshArena::allocate(int poolIndex, void const* vertices, void const* positions, uint32_t vertexCount, void const* indices, uint32_t indexCount)
+{
+	Pool& pool = pools[poolIndex];
+	Range range;
+	range.pool = poolIndex;
+	range.vertexCount = vertexCount;
+	range.indexCount = pool.indexSize ? indexCount : 0;
+	if(range.vertexCount)
+	{
+		range.baseVertex = allocateVertices(pool, range.vertexCount);
+		glNamedBufferSubData(pool.VBO, GLintptr(range.baseVertex) * pool.layout.stride, GLsizeiptr(range.vertexCount) * pool.layout.stride, vertices);
+		if(pool.positionSize)
+			glNamedBufferSubData(pool.positionVBO, GLintptr(range.baseVertex) * pool.positionSize, GLsizeiptr(range.vertexCount) * pool.positionSize, positions);
+	}
+	if(range.indexCount)
+	{
+		range.firstIndex = allocateIndices(pool, range.indexCount);
+		glNamedBufferSubData(pool.EBO, GLintptr(range.firstIndex) * pool.indexSize, GLsizeiptr(range.indexCount) * pool.indexSize, indices);
+	}
+	pool.meshes++;
+	return range;
+}
+
+void MeshArena::release(Range const& range)
+{
+	if(range.pool == -1)
+		return;
+	Pool& pool = pools[range.pool];
+	//draws already submitted keep reading the old contents, the driver orders later uploads after them
+	if(range.vertexCount)
+		freeRange(pool.freeVertices, range.baseVertex, range.vertexCount);
+	if(range.indexCount)
+		freeRange(pool.freeIndices, range.firstIndex, range.indexCount);
+	pool.meshes--;
+}
+
+unsigned int MeshArena::getVertexBuffer(int pool) const
+{
+	return pools[pool].VBO;
+}
+
+unsigned int MeshArena::getPositionBuffer(int pool) const
+{
+	return pools[pool].positionVBO;
+}
+
+GLintptr MeshArena::getPositionOffset(Range const& range) const
+{
+	return GLintptr(range.baseVertex) * pools[range.pool].positionSize;
+}
+
+unsigned int MeshArena::getIndexBuffer(int pool) const
+{
+	return pools[pool].EBO;
+}
+
+GLintptr MeshArena::getVertexOffset(Range const& range) const
+{
+	return GLintptr(range.baseVertex) * pools[range.pool].layout.stride;
+}
+
+GLintptr MeshArena::getIndexOffset(Range const& range) const
+{
+	return GLintptr(range.firstIndex) * pools[range.pool].indexSize;
+}
+
+void MeshArena::bind(int pool, bool positionsOnly)
+{
+	unsigned int const vertexArray = positionsOnly && pools[pool].positionVAO ? pools[pool].positionVAO : pools[pool].VAO;
+	if(vertexArray == boundVertexArray)
+		return;
+	boundVertexArray = vertexArray;
+	glBindVertexArray(vertexArray);
+}
+
+void MeshArena::draw(Range const& range, GLenum drawMode, int instanceCount, int baseInstance, bool positionsOnly)
+{
+	bind(range.pool, positionsOnly);
+	GLenum const indexDataType = pools[range.pool].format.indexDataType;
+	if(indexDataType)
+		glDrawElementsInstancedBaseVertexBaseInstance(drawMode, range.indexCount, indexDataType, (void*) (getIndexOffset(range)),
+			instanceCount, range.baseVertex, baseInstance);
+	else
+		glDrawArraysInstancedBaseInstance(drawMode, range.baseVertex, range.vertexCount, instanceCount, baseInstance);
+}
+
+void MeshArena::writeCommand(std::byte* command, Range const& range, int instanceCount, int baseInstance) const
+{
+	if(pools[range.pool].format.indexDataType)
+	{
+		DrawElementsCommand const elements{range.indexCount, uint32_t(instanceCount), range.firstIndex, int32_t(range.baseVertex), uint32_t(baseInstance)};
+		std::memcpy(command, &elements, sizeof(elements));
+	}
+	else
+	{
+		DrawArraysCommand const arrays{range.vertexCount, uint32_t(instanceCount), range.baseVertex, uint32_t(baseInstance)};
+		std::memcpy(command, &arrays, sizeof(arrays));
+	}
+}
+
+void MeshArena::multiDraw(int pool, GLenum drawMode, GLintptr commands, int drawCount, bool positionsOnly)
+{
+	bind(pool, positionsOnly);
+	GLenum const indexDataType = pools[pool].format.indexDataType;
+	if(indexDataType)
+		glMultiDrawElementsIndirect(drawMode, indexDataType, (void*) (commands), drawCount, commandStride);
+	else
+		glMultiDrawArraysIndirect(drawMode, (void*) (commands), drawCount, commandStride);
+}
+
+void MeshArena::drawUI()
+{
+	IDGuard idGuard{this};
+	ImGui::Text("Pools: %i", int(pools.size()));
+	ImGui::Text("Growths: %i", stats.growths);
+	for(int i = 0; i < int(pools.size()); i++)
+	{
+		Pool const& pool = pools[i];
+		uint32_t freeVertices = 0;
+		for(auto const& range : pool.freeVertices)
+			freeVertices += range.second;
+		uint32_t freeIndices = 0;
+		for(auto const& range : pool.freeIndices)
+			freeIndices += range.second;
+		ImGui::Text("Pool %i: %i meshes, stride %i", i, pool.meshes, int(pool.layout.stride));
+		ImGui::Text("\tVertices: %i / %i (%.2f MB)", int(pool.vertexCapacity - freeVertices), int(pool.vertexCapacity),
+			float(pool.vertexCapacity) * pool.layout.stride / (1024.0f * 1024.0f));
+		if(pool.indexSize)
+			ImGui::Text("\tIndices: %i / %i (%.2f MB)", int(pool.indexCapacity - freeIndices), int(pool.indexCapacity),
+				float(pool.indexCapacity) * pool.indexSize / (1024.0f * 1024.0f));
+		if(pool.positionSize)
+			ImGui::Text("\tPositions: %.2f MB", float(pool.vertexCapacity) * pool.positionSize / (1024.0f * 1024.0f));
+	}
+}
@@ -1,5 +1,6 @@
 #include "Node.h"
 #include "Scene.h"
+#include "NodePool.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <imgui.h>
@@ -7,7 +8,9 @@
 Node::Node(Node&& other)
 	:parent(other.parent), scene(other.scene)
 {
-	addChildren(std::move(other.children));
+	for(auto& child : other.children)
+		addChild(std::move(child));
+	other.children.clear();
 }
 
 Node::Node(std::vector<std::unique_ptr<Node>>&& nodes)
@@ -15,15 +18,51 @@ Node::Node(std::vector<std::unique_ptr<Node>>&& nodes)
 	addChildren(std::move(nodes));
 }
 
+Node::~Node()
+{
+	//flatten the subtree first, so tearing down deep hierarchies doesn't recurse once per level
+	if(children.empty())
+		return;
+	std::vector<std::unique_ptr<Node>> pending;
+	for(auto& child : children)
+		pending.push_back(std::move(child));
+	children.clear();
+	while(!pending.empty())
+	{
+		std::unique_ptr<Node> node = std::move(pending.back());
+		pending.pop_back();
+		for(auto& child : node->children)
+			pending.push_back(std::move(child));
+		node->children.clear();
+	}
+}
+
+void* Node::operator new(std::size_t size)
+{
+	return NodePool::allocate(size);
+}
+
+void Node::operator delete(void* pointer, std::size_t size)
+{
+	NodePool::deallocate(pointer, size);
+}
+
 void Node::invalidateSceneCache()
 {
+	updateTimestamp();
 	if(scene)
 		scene->cacheOutdated();
 }
 
 void Node::setScene(Scene * scene)
 {
+	if(this->scene == scene)
+		return;
+	if(this->scene && registryIndex != -1)
+		this->scene->unregisterNode(this);
 	this->scene = scene;
+	if(scene && parent)
+		scene->registerNode(this);
 	for(auto const& child : children)
 		child->setScene(scene);
 }
@@ -37,9 +76,13 @@ std::unique_ptr<Node> Node::releaseChild(Node * node)
 		{
 			std::unique_ptr<Node> ret = std::move(*it);
 			children.erase(it);
+			ret->parent = nullptr;
+			ret->globalTransformationOutdated();
 
 			for(auto& grandchild : ret->children)
 				addChild(std::move(grandchild));
+			ret->children.clear();
+			ret->setScene(nullptr);
 
 			return ret;
 		}
@@ -52,11 +95,51 @@ std::string Node::getNamePrefix() const
 	return "node";
 }
 
-std::vector<std::unique_ptr<Node>> const& Node::getChildren() const
+void Node::localTransformationOutdated()
+{
+	transformationCache.localOutdated = true;
+	globalTransformationOutdated();
+}
+
+void Node::globalTransformationOutdated()
+{
+	transformationVersion = ++latestTransformationVersion;
+	updateTimestamp();
+	//an outdated node never has up to date descendants, so there is nothing left to propagate
+	if(transformationCache.globalOutdated)
+		return;
+	transformationCache.globalOutdated = true;
+	if(scene)
+	{
+		scene->transformationsOutdated();
+		scene->boundsOutdated(this);
+	}
+	for(auto const& child : children)
+		child->globalTransformationOutdated();
+}
+
+void Node::updateTimestamp()
+{
+	Timestamp::updateTimestamp();
+	if(scene)
+		scene->updateTimestamp();
+}
+
+Node::Children const& Node::getChildren() const
 {
 	return children;
 }
 
+uint64_t Node::getTransformationVersion() const
+{
+	return transformationVersion;
+}
+
+uint64_t Node::getLatestTransformationVersion()
+{
+	return latestTransformationVersion;
+}
+
 Scene* Node::getScene() const
 {
 	return scene;
@@ -74,22 +157,33 @@ bool Node::isHighlighted() const
 
 void Node::setHighlighted(bool b)
 {
+	if(highlighted == b)
+		return;
 	highlighted = b;
+	updateTimestamp();
 }
+
 void Node::enable()
 {
 	enabled = true;
+	updateTimestamp();
+	if(scene)
+		scene->enabledOutdated(this);
 }
 
 void Node::disable()
 {
 	enabled = false;
+	updateTimestamp();
+	if(scene)
+		scene->enabledOutdated(this);
 }
 
 Node* Node::addChild(std::unique_ptr<Node>&& node, bool retainGlobalTransformation)
 {
 	auto desiredGlobalTransformation = node->getGlobalTransformation();
 	node->parent = this;
+	node->globalTransformationOutdated();
 	node->setScene(scene);
 	auto ret = node.get();
 	children.push_back(std::move(node));
@@ -117,7 +211,18 @@ std::unique_ptr<Node> Node::release()
 std::vector<std::unique_ptr<Node>> Node::releaseChildren()
 {
 	invalidateSceneCache();
-	return std::move(children);
+	for(auto const& child : children)
+	{
+		child->setScene(nullptr);
+		child->parent = nullptr;
+		child->globalTransformationOutdated();
+	}
+	std::vector<std::unique_ptr<Node>> ret;
+	ret.reserve(children.size());
+	for(auto& child : children)
+		ret.push_back(std::move(child));
+	children.clear();
+	return ret;
 }
 
 Bounds Node::getBounds() const
@@ -0,0 +1,145 @@
+#include "NodePool.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace
+{
+	struct Slab
+	{
+		int liveObjects = 0;
+	};
+	//keeps the first block of every slab aligned
+	constexpr std::size_t slabHeaderSize = 64;
+	constexpr int sizeClassCount = int(NodePool::maxPooledSize / NodePool::granularity);
+
+	struct SizeClass
+	{
+		void* freeList = nullptr;
+		char* bump = nullptr;
+		char* bumpEnd = nullptr;
+		std::vector<Slab*> slabs;
+	};
+
+	struct State
+	{
+		std::array<SizeClass, sizeClassCount> sizeClasses;
+		NodePool::Stats stats;
+	};
+
+	//never destroyed, nodes owned by static managers outlive it otherwise
+	State& getState()
+	{
+		static State* state = new State;
+		return *state;
+	}
+
+	Slab* getSlab(void* pointer)
+	{
+		return reinterpret_cast<Slab*>(reinterpret_cast<std::uintptr_t>(pointer) & ~std::uintptr_t(NodePool::slabSize - 1));
+	}
+
+	std::size_t getSizeClass(std::size_t size)
+	{
+		return (size + NodePool::granularity - 1) / NodePool::granularity - 1;
+	}
+}
+
+void* NodePool::allocate(std::size_t size)
+{
+	State& state = getState();
+	if(size > maxPooledSize)
+	{
+		state.stats.unpooledAllocations++;
+		return ::operator new(size);
+	}
+	std::size_t const sizeClass = getSizeClass(size);
+	std::size_t const blockSize = (sizeClass + 1) * granularity;
+	SizeClass& pool = state.sizeClasses[sizeClass];
+	void* ret;
+	if(pool.freeList)
+	{
+		ret = pool.freeList;
+		pool.freeList = *static_cast<void**>(ret);
+	}
+	else
+	{
+		if(pool.bump + blockSize > pool.bumpEnd)
+		{
+			Slab* slab = new(::operator new(slabSize, std::align_val_t{slabSize})) Slab;
+			pool.slabs.push_back(slab);
+			pool.bump = reinterpret_cast<char*>(slab) + slabHeaderSize;
+			pool.bumpEnd = reinterpret_cast<char*>(slab) + slabSize;
+			state.stats.slabs++;
+			state.stats.slabAllocations++;
+		}
+		ret = pool.bump;
+		pool.bump += blockSize;
+	}
+	getSlab(ret)->liveObjects++;
+	state.stats.liveObjects++;
+	return ret;
+}
+
+void NodePool::deallocate(void* pointer, std::size_t size)
+{
+	if(!pointer)
+		return;
+	if(size > maxPooledSize)
+	{
+		::operator delete(pointer);
+		return;
+	}
+	State& state = getState();
+	SizeClass& pool = state.sizeClasses[getSizeClass(size)];
+	getSlab(pointer)->liveObjects--;
+	*static_cast<void**>(pointer) = pool.freeList;
+	pool.freeList = pointer;
+	state.stats.liveObjects--;
+}
+
+void NodePool::trim()
+{
+	State& state = getState();
+	for(auto& pool : state.sizeClasses)
+	{
+		auto const isEmpty = [](Slab* slab){
+			return slab->liveObjects == 0;
+		};
+		if(std::none_of(pool.slabs.begin(), pool.slabs.end(), isEmpty))
+			continue;
+
+		//unlink the free blocks of empty slabs, keeping the order of the rest
+		void** link = &pool.freeList;
+		while(*link)
+		{
+			if(isEmpty(getSlab(*link)))
+				*link = *static_cast<void**>(*link);
+			else
+				link = static_cast<void**>(*link);
+		}
+		if(pool.bump && isEmpty(getSlab(pool.bumpEnd - 1)))
+		{
+			pool.bump = nullptr;
+			pool.bumpEnd = nullptr;
+		}
+		auto const emptySlabs = std::partition(pool.slabs.begin(), pool.slabs.end(), [&](Slab* slab){
+			return !isEmpty(slab);
+		});
+		for(auto it = emptySlabs; it != pool.slabs.end(); it++)
+		{
+			(*it)->~Slab();
+			::operator delete(*it, std::align_val_t{slabSize});
+			state.stats.slabs--;
+		}
+		pool.slabs.erase(emptySlabs, pool.slabs.end());
+	}
+}
+
+NodePool::Stats const& NodePool::getStats()
+{
+	return getState().stats;
+}
@@ -0,0 +1,293 @@
+#include "OcclusionCuller.h"
+#include "SIMD.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+OcclusionCuller::OcclusionCuller(int width, int height)
+{
+	resize(width, height);
+}
+
+void OcclusionCuller::rasterizeTriangle(glm::vec4 const& c0, glm::vec4 const& c1, glm::vec4 const& c2)
+{
+	auto toScreen = [&](glm::vec4 const& clip){
+		glm::vec3 const ndc = glm::vec3{clip} / clip.w;
+		return glm::vec3{(ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height, ndc.z * 0.5f + 0.5f};
+	};
+	rasterizeTriangle(toScreen(c0), toScreen(c1), toScreen(c2));
+}
+
+void OcclusionCuller::rasterizeTriangle(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2)
+{
+	float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+	if(std::abs(area) < 1e-6f)
+		return;
+	//both windings occlude, make the edge functions positive inside
+	if(area < 0.0f)
+	{
+		std::swap(v1, v2);
+		area = -area;
+	}
+
+	//pixels whose centers lie inside the bounding rectangle
+	int minX = std::max(0, int(std::ceil(std::min({v0.x, v1.x, v2.x}) - 0.5f)));
+	int const maxX = std::min(width - 1, int(std::floor(std::max({v0.x, v1.x, v2.x}) - 0.5f)));
+	int const minY = std::max(0, int(std::ceil(std::min({v0.y, v1.y, v2.y}) - 0.5f)));
+	int const maxY = std::min(height - 1, int(std::floor(std::max({v0.y, v1.y, v2.y}) - 0.5f)));
+	if(minX > maxX || minY > maxY)
+		return;
+	//rows are processed 4 pixels at a time, width is a multiple of 4
+	minX &= ~3;
+	rasterizedTriangles++;
+
+	//a * x + b * y + c
+	struct Edge
+	{
+		float a, b, c;
+		float at(float x, float y) const
+		{
+			return a * x + b * y + c;
+		}
+	};
+	auto edge = [](glm::vec3 const& from, glm::vec3 const& to){
+		float const a = from.y - to.y;
+		float const b = to.x - from.x;
+		return Edge{a, b, -(a * from.x + b * from.y)};
+	};
+	Edge const e12 = edge(v1, v2);
+	Edge const e20 = edge(v2, v0);
+	Edge const e01 = edge(v0, v1);
+	//depth is affine in screen space, interpolated with the barycentric weights
+	Edge const depth{
+		(e12.a * v0.z + e20.a * v1.z + e01.a * v2.z) / area,
+		(e12.b * v0.z + e20.b * v1.z + e01.b * v2.z) / area,
+		(e12.c * v0.z + e20.c * v1.z + e01.c * v2.z) / area};
+
+	std::vector<float>& buffer = pyramid[0];
+#ifdef SIMD_SSE
+	__m128 const offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	__m128 const zero = _mm_setzero_ps();
+	auto row = [&](Edge const& function, float y){
+		return _mm_add_ps(_mm_mul_ps(_mm_set1_ps(function.a), _mm_add_ps(_mm_set1_ps(float(minX)), offsets)), _mm_set1_ps(function.b * y + function.c));
+	};
+	__m128 const step12 = _mm_set1_ps(4.0f * e12.a);
+	__m128 const step20 = _mm_set1_ps(4.0f * e20.a);
+	__m128 const step01 = _mm_set1_ps(4.0f * e01.a);
+	__m128 const stepDepth = _mm_set1_ps(4.0f * depth.a);
+	for(int y = minY; y <= maxY; y++)
+	{
+		float const centerY = y + 0.5f;
+		__m128 w0 = row(e12, centerY);
+		__m128 w1 = row(e20, centerY);
+		__m128 w2 = row(e01, centerY);
+		__m128 z = row(depth, centerY);
+		float* pixels = &buffer[y * width];
+		for(int x = minX; x <= maxX; x += 4)
+		{
+			__m128 const inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(w0, zero), _mm_cmpge_ps(w1, zero)), _mm_cmpge_ps(w2, zero));
+			if(_mm_movemask_ps(inside))
+			{
+				__m128 const old = _mm_loadu_ps(pixels + x);
+				__m128 const nearest = _mm_min_ps(old, z);
+				_mm_storeu_ps(pixels + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, old)));
+			}
+			w0 = _mm_add_ps(w0, step12);
+			w1 = _mm_add_ps(w1, step20);
+			w2 = _mm_add_ps(w2, step01);
+			z = _mm_add_ps(z, stepDepth);
+		}
+	}
+#else
+	for(int y = minY; y <= maxY; y++)
+	{
+		float const centerY = y + 0.5f;
+		float* pixels = &buffer[y * width];
+		for(int x = minX; x <= maxX; x++)
+		{
+			float const centerX = x + 0.5f;
+			if(e12.at(centerX, centerY) >= 0.0f && e20.at(centerX, centerY) >= 0.0f && e01.at(centerX, centerY) >= 0.0f)
+				pixels[x] = std::min(pixels[x], depth.at(centerX, centerY));
+		}
+	}
+#endif
+}
+
+void OcclusionCuller::erode()
+{
+	std::vector<float>& buffer = pyramid[0];
+	scratch.resize(buffer.size());
+	for(int y = 0; y < height; y++)
+	{
+		float const* pixels = &buffer[y * width];
+		float* eroded = &scratch[y * width];
+		for(int x = 0; x < width; x++)
+			eroded[x] = std::max({pixels[std::max(x - 1, 0)], pixels[x], pixels[std::min(x + 1, width - 1)]});
+	}
+	for(int y = 0; y < height; y++)
+	{
+		float const* above = &scratch[std::max(y - 1, 0) * width];
+		float const* pixels = &scratch[y * width];
+		float const* below = &scratch[std::min(y + 1, height - 1) * width];
+		float* eroded = &buffer[y * width];
+		for(int x = 0; x < width; x++)
+			eroded[x] = std::max({above[x], pixels[x], below[x]});
+	}
+}
+
+void OcclusionCuller::resize(int width, int height)
+{
+	this->width = std::max(4, (width + 3) & ~3);
+	this->height = std::max(1, height);
+	pyramid.clear();
+	levelSizes.clear();
+	glm::ivec2 size{this->width, this->height};
+	while(true)
+	{
+		levelSizes.push_back(size);
+		pyramid.emplace_back(size.x * size.y, 1.0f);
+		if(size.x == 1 && size.y == 1)
+			break;
+		size = glm::max(glm::ivec2{1}, (size + 1) / 2);
+	}
+}
+
+int OcclusionCuller::getWidth() const
+{
+	return width;
+}
+
+int OcclusionCuller::getHeight() const
+{
+	return height;
+}
+
+void OcclusionCuller::begin(glm::mat4 const& viewProjection)
+{
+	this->viewProjection = viewProjection;
+	std::fill(pyramid[0].begin(), pyramid[0].end(), 1.0f);
+	rasterizedTriangles = 0;
+}
+
+void OcclusionCuller::rasterize(std::vector<glm::vec3> const& positions, std::vector<uint32_t> const& indices, glm::mat4 const& model)
+{
+	glm::mat4 const transformation = viewProjection * model;
+	clipPositions.resize(positions.size());
+	for(int i = 0; i < int(positions.size()); i++)
+		clipPositions[i] = transformation * glm::vec4{positions[i], 1.0f};
+
+	for(int i = 0; i + 2 < int(indices.size()); i += 3)
+	{
+		std::array<glm::vec4, 3> const triangle{clipPositions[indices[i]], clipPositions[indices[i + 1]], clipPositions[indices[i + 2]]};
+		//distance to the near plane in clip space
+		std::array<float, 3> distances;
+		int inFront = 0;
+		for(int j = 0; j < 3; j++)
+		{
+			distances[j] = triangle[j].z + triangle[j].w;
+			inFront += distances[j] >= 0.0f;
+		}
+		if(inFront == 3)
+		{
+			rasterizeTriangle(triangle[0], triangle[1], triangle[2]);
+			continue;
+		}
+		if(inFront == 0)
+			continue;
+
+		//clip against the near plane, leaves a triangle or a quad
+		std::array<glm::vec4, 4> clipped;
+		int clippedCount = 0;
+		for(int j = 0; j < 3; j++)
+		{
+			int const next = (j + 1) % 3;
+			if(distances[j] >= 0.0f)
+				clipped[clippedCount++] = triangle[j];
+			if((distances[j] >= 0.0f) != (distances[next] >= 0.0f))
+			{
+				float const t = distances[j] / (distances[j] - distances[next]);
+				clipped[clippedCount++] = glm::mix(triangle[j], triangle[next], t);
+			}
+		}
+		for(int j = 1; j + 1 < clippedCount; j++)
+			rasterizeTriangle(clipped[0], clipped[j], clipped[j + 1]);
+	}
+}
+
+void OcclusionCuller::finish()
+{
+	//occluders are rasterized at pixel centers, so a texel on a silhouette may only be partly covered, and is only
+	//as near as the occluder at its center, eroding by a texel keeps props just behind the silhouettes visible
+	erode();
+	for(int level = 1; level < int(pyramid.size()); level++)
+	{
+		glm::ivec2 const size = levelSizes[level];
+		glm::ivec2 const previousSize = levelSizes[level - 1];
+		std::vector<float> const& previous = pyramid[level - 1];
+		std::vector<float>& current = pyramid[level];
+		for(int y = 0; y < size.y; y++)
+		{
+			int const y0 = 2 * y;
+			int const y1 = std::min(y0 + 1, previousSize.y - 1);
+			for(int x = 0; x < size.x; x++)
+			{
+				int const x0 = 2 * x;
+				int const x1 = std::min(x0 + 1, previousSize.x - 1);
+				current[y * size.x + x] = std::max(
+					std::max(previous[y0 * previousSize.x + x0], previous[y0 * previousSize.x + x1]),
+					std::max(previous[y1 * previousSize.x + x0], previous[y1 * previousSize.x + x1]));
+			}
+		}
+	}
+}
+
+bool OcclusionCuller::isVisible(glm::vec3 const& min, glm::vec3 const& max) const
+{
+	glm::vec2 screenMin{std::numeric_limits<float>::max()};
+	glm::vec2 screenMax{std::numeric_limits<float>::lowest()};
+	float nearest = std::numeric_limits<float>::max();
+	for(int i = 0; i < 8; i++)
+	{
+		glm::vec4 const corner{i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z, 1.0f};
+		glm::vec4 const clip = viewProjection * corner;
+		//boxes crossing the near plane can't be projected, and are too close to be hidden anyway
+		if(clip.w <= 0.0f || clip.z < -clip.w)
+			return true;
+		glm::vec3 const ndc = glm::vec3{clip} / clip.w;
+		glm::vec2 const screen = (glm::vec2{ndc} * 0.5f + 0.5f) * glm::vec2{float(width), float(height)};
+		screenMin = glm::min(screenMin, screen);
+		screenMax = glm::max(screenMax, screen);
+		nearest = std::min(nearest, ndc.z * 0.5f + 0.5f);
+	}
+	int const x0 = std::max(0, int(std::floor(screenMin.x)));
+	int const x1 = std::min(width - 1, int(std::floor(screenMax.x)));
+	int const y0 = std::max(0, int(std::floor(screenMin.y)));
+	int const y1 = std::min(height - 1, int(std::floor(screenMax.y)));
+	//off screen, left to frustum culling
+	if(x0 > x1 || y0 > y1)
+		return true;
+
+	//the coarsest level where the rectangle covers at most 2x2 texels
+	int level = 0;
+	while((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)
+		level++;
+	std::vector<float> const& depths = pyramid[level];
+	int const levelWidth = levelSizes[level].x;
+	for(int y = y0 >> level; y <= y1 >> level; y++)
+		for(int x = x0 >> level; x <= x1 >> level; x++)
+			if(nearest <= depths[y * levelWidth + x])
+				return true;
+	return false;
+}
+
+std::vector<float> const& OcclusionCuller::getDepthBuffer() const
+{
+	return pyramid[0];
+}
+
+int OcclusionCuller::getRasterizedTriangles() const
+{
+	return rasterizedTriangles;
+}
@@ -57,8 +57,9 @@ void PostProcessingStep::draw(unsigned int sourceColorbuffer, unsigned int targe
 	{
 		currentShader->set("offset", convolutionOffset);
 		currentShader->set("divisor", convolutionDivisor);
+		static Shader::UniformArray<Shader::Uniform<float>> const kernel{"kernel[", "]"};
 		for(int i = 0; i < 9; i++)
-			currentShader->set("kernel[" + std::to_string(i) + "]", convolutionKernel[i]);
+			currentShader->set(kernel[i], convolutionKernel[i]);
 	}
 	else if(currentShader == ShaderManager::chromaticAberration())
 	{
@@ -13,6 +13,33 @@ std::array<float, frameSamples> frametimePlot;
 unsigned int currentFrameIndex = 0;
 float const longestFrame = 100.0f;
 
+static std::vector<profiler::Counter*>& getAllCounters()
+{
+	static std::vector<profiler::Counter*> counters;
+	return counters;
+}
+
+profiler::Counter::Counter(std::string name)
+	:name(std::move(name))
+{
+	getAllCounters().push_back(this);
+}
+
+std::string const& profiler::Counter::getName() const
+{
+	return name;
+}
+
+int profiler::Counter::get() const
+{
+	return lastFrame;
+}
+
+void profiler::Counter::nextFrame()
+{
+	lastFrame = current.exchange(0, std::memory_order_relaxed);
+}
+
 void profiler::recordFrame()
 {
 	static auto lastFrame = std::chrono::system_clock::now();
@@ -23,6 +50,8 @@ void profiler::recordFrame()
 	//longestFrame = std::max(longestFrame, frametime);
 	fps = 1000.0f / frametime;
 	lastFrame = currentFrame;
+	for(auto counter : getAllCounters())
+		counter->nextFrame();
 }
 
 void profiler::drawUI(bool* open)
@@ -34,6 +63,8 @@ void profiler::drawUI(bool* open)
 	ImGui::Text("Frametime: %.1f ms (%.1f) - (%.1f)", frametime, 0.0f, longestFrame);
 	ImGui::PlotLines("###Frametimes", frametimePlot.data(), frameSamples, currentFrameIndex, nullptr, 0.0f, longestFrame, {ImGui::GetContentRegionAvailWidth(), plotHeight});
 	ImGui::Text("FPS: %.1f", fps);
+	for(auto counter : getAllCounters())
+		ImGui::Text("%s: %i", counter->getName().data(), counter->get());
 
 	struct GLContext
 	{
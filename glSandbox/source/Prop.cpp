@@ -1,4 +1,5 @@
 #include "Prop.h"
+#include "Scene.h"
 #include "MeshManager.h"
 #include "Grid.h"
 #include "SierpinskiTriangle.h"
@@ -22,6 +23,11 @@ std::string Prop::getNamePrefix() const
 	return "prop";
 }
 
+NodeType Prop::getType() const
+{
+	return type;
+}
+
 Mesh& Prop::getMesh() const
 {
 	if(staticMesh)
@@ -36,10 +42,14 @@ Material* Prop::getMaterial() const
 	return material;
 }
 
+Bounds Prop::getOwnBounds() const
+{
+	return getMesh().getBounds() * getGlobalTransformation();
+}
+
 Bounds Prop::getBounds() const
 {
-	Bounds childBounds = Node::getBounds();
-	return getMesh().getBounds() * getGlobalTransformation() + childBounds;
+	return getOwnBounds() + Node::getBounds();
 }
 
 template <typename PM>
@@ -68,6 +78,7 @@ void addProceduralMeshItem(std::unique_ptr<ProceduralMesh>& proceduralMesh, Mesh
 void Prop::drawUI()
 {
 	Transformed<Translation, Rotation, Scale>::drawUI();
+	Mesh const* previousMesh = &getMesh();
 	ImGui::BeginChild("###Prop", {ImGui::GetTextLineHeightWithSpacing() * 22, 0});
 	ImGui::AlignTextToFramePadding();
 	ImGui::Text("Mesh");
@@ -101,10 +112,19 @@ void Prop::drawUI()
 		addProceduralMeshItem<SierpinskiCarpet>(proceduralMesh, staticMesh);
 		ImGui::EndCombo();
 	}
-	if(proceduralMesh)
-		proceduralMesh->drawUI();
+	//procedural meshes only report parameter changes, they are regenerated when the mesh is next accessed
+	bool const meshChanged = (proceduralMesh && proceduralMesh->drawUI()) || &getMesh() != previousMesh;
 	assert(material);
+	Material const* previousMaterial = material;
 	material = chooseFromCombo(material, MaterialManager::getAll());
+	if(getScene() && meshChanged)
+		getScene()->boundsOutdated(this);
+	if(meshChanged || material != previousMaterial)
+	{
+		updateTimestamp();
+		if(getScene())
+			getScene()->renderStateOutdated(this);
+	}
 
 	ImGui::EndChild();
 }
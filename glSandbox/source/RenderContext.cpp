@@ -0,0 +1,588 @@
+#include "RenderContext.h"
+#include "Scene.h"
+#include "Camera.h"
+#include "Lights.h"
+#include "Prop.h"
+#include "Mesh.h"
+#include "ShaderManager.h"
+#include "Profiler.h"
+#include "Geometry.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <imgui.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+	namespace uniforms
+	{
+		Shader::UniformArray<Shader::Uniform<glm::mat4>> const lightSpaces{"lightSpaces[", "]"};
+		Shader::Uniform<glm::mat4> const lightSpace{"lightSpace"};
+		Shader::Uniform<int> const cubeLayer{"cubeLayer"};
+	}
+
+	//splitmix64 finalizer, spreads small changes of the input over the whole signature
+	uint64_t mixSignature(uint64_t value)
+	{
+		value += 0x9e3779b97f4a7c15;
+		value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9;
+		value = (value ^ (value >> 27)) * 0x94d049bb133111eb;
+		return value ^ (value >> 31);
+	}
+
+	uint64_t getMatrixSignature(glm::mat4 const& matrix)
+	{
+		uint64_t signature = 0;
+		for(int column = 0; column < 4; column++)
+		{
+			for(int row = 0; row < 4; row++)
+			{
+				uint32_t bits;
+				std::memcpy(&bits, &matrix[column][row], sizeof(bits));
+				signature = mixSignature(signature ^ bits);
+			}
+		}
+		return signature;
+	}
+
+	uint64_t getCasterSignature(std::vector<Prop*> const& casters)
+	{
+		//summed, so the bounding volume hierarchy may return the casters in any order
+		uint64_t signature = mixSignature(casters.size());
+		for(auto prop : casters)
+			signature += mixSignature(reinterpret_cast<std::uintptr_t>(prop) ^ mixSignature(prop->getTransformationVersion() ^
+				mixSignature(reinterpret_cast<std::uintptr_t>(&prop->getMesh()))));
+		return signature;
+	}
+}
+
+RenderContext::RenderContext(Scene const& scene)
+	:scene(scene)
+{
+}
+
+void RenderContext::resizeShadowMaps()
+{
+	shadows.atlas.resize(1 << shadows.atlasResolution, 1 << shadows.pointResolution, shadows.pointCapacity);
+}
+
+int RenderContext::getView(Camera const& camera)
+{
+	for(int i = 0; i < int(views.size()); i++)
+		if(views[i].camera == &camera)
+			return i;
+	views.push_back({&camera});
+	return int(views.size()) - 1;
+}
+
+float RenderContext::getViewDistance(glm::vec3 const& position) const
+{
+	float distance = std::numeric_limits<float>::max();
+	for(auto const& view : views)
+		distance = std::min(distance, glm::length(position - view.camera->getPosition()));
+	return distance;
+}
+
+void RenderContext::allocateShadowMaps()
+{
+	int const tileSize = 1 << shadows.resolution;
+	//spot light tiles halve with every doubling of their distance to the closest view beyond the full resolution distance
+	auto const spotTileSize = [&](SpotLight const* light){
+		float const distance = getViewDistance(light->getPosition()) / shadows.fullResolutionDistance;
+		return tileSize >> std::clamp(int(std::log2(std::max(distance, 1.0f))), 0, 3);
+	};
+	shadows.atlas.beginUpdate();
+	for(auto light : scene.getAll<DirectionalLight>())
+		if(light->isEnabled())
+			for(int view = 0; view < int(views.size()); view++)
+				shadows.atlas.requestCascades(light, tileSize, shadows.cascades, view * ShadowAtlas::maxCascades);
+	for(auto& view : views)
+		view.allocated = true;
+	for(auto light : scene.getAll<SpotLight>())
+		if(light->isEnabled())
+			shadows.atlas.request(light, spotTileSize(light));
+	for(auto light : scene.getAll<PointLight>())
+		if(light->isEnabled())
+			shadows.atlas.requestCube(light, shadows.pointLightFarPlane);
+	shadows.atlas.endUpdate();
+}
+
+std::array<float, ShadowAtlas::maxCascades + 1> RenderContext::getCascadeSplits(Camera const& camera) const
+{
+	float const nearPlane = camera.getNearPlane();
+	float const farPlane = std::clamp(shadows.cascadeDistance, nearPlane, camera.getFarPlane());
+	std::array<float, ShadowAtlas::maxCascades + 1> splits{};
+	for(int i = 0; i <= shadows.cascades; i++)
+	{
+		float const fraction = float(i) / shadows.cascades;
+		float const logarithmic = nearPlane * std::pow(farPlane / nearPlane, fraction);
+		float const uniform = nearPlane + (farPlane - nearPlane) * fraction;
+		splits[i] = glm::mix(uniform, logarithmic, shadows.cascadeSplitBlend);
+	}
+	return splits;
+}
+
+glm::mat4 RenderContext::getCascadeLightSpace(Camera const& camera, glm::vec3 lightDirection, float nearSplit, float farSplit, int tileSize) const
+{
+	//corners of the slice lie on the edges of the camera frustum, depth is linear along them
+	glm::mat4 const inverseViewProjection = glm::inverse(camera.getProjectionMatrix() * camera.getViewMatrix());
+	float const nearPlane = camera.getNearPlane();
+	float const farPlane = camera.getFarPlane();
+	std::array<glm::vec3, 8> corners;
+	for(int i = 0; i < 4; i++)
+	{
+		glm::vec2 const ndc{i % 2 ? 1.0f : -1.0f, i / 2 ? 1.0f : -1.0f};
+		glm::vec4 const near = inverseViewProjection * glm::vec4{ndc, -1.0f, 1.0f};
+		glm::vec4 const far = inverseViewProjection * glm::vec4{ndc, 1.0f, 1.0f};
+		glm::vec3 const edgeStart = glm::vec3{near} / near.w;
+		glm::vec3 const edge = glm::vec3{far} / far.w - edgeStart;
+		corners[i] = edgeStart + edge * ((nearSplit - nearPlane) / (farPlane - nearPlane));
+		corners[i + 4] = edgeStart + edge * ((farSplit - nearPlane) / (farPlane - nearPlane));
+	}
+	//a bounding sphere keeps the size of the projection constant while the camera turns
+	glm::vec3 center{0.0f};
+	for(auto const& corner : corners)
+		center += corner / 8.0f;
+	float radius = 0.0f;
+	for(auto const& corner : corners)
+		radius = std::max(radius, glm::length(corner - center));
+	radius = std::ceil(radius * 16.0f) / 16.0f;
+
+	//the view only depends on the direction, so snapping the center to whole texels in it keeps shadow edges from
+	//shimmering while the camera moves
+	glm::vec3 const up = std::abs(lightDirection.y) > 0.99f ? glm::vec3{0.0f, 0.0f, 1.0f} : glm::vec3{0.0f, 1.0f, 0.0f};
+	glm::mat4 const lightView = glm::lookAt(glm::vec3{0.0f}, lightDirection, up);
+	glm::vec3 lightCenter = glm::vec3{lightView * glm::vec4{center, 1.0f}};
+	float const texelSize = 2.0f * radius / tileSize;
+	lightCenter.x = std::floor(lightCenter.x / texelSize) * texelSize;
+	lightCenter.y = std::floor(lightCenter.y / texelSize) * texelSize;
+	//depth reaches back to every prop of the scene, so casters outside of the slice still cast into it
+	float nearDepth = -lightCenter.z - radius;
+	float farDepth = -lightCenter.z + radius;
+	Bounds const sceneBounds = scene.getBoundingVolumes().getBounds();
+	if(!sceneBounds.empty())
+	{
+		auto const[min, max] = sceneBounds.getValues();
+		for(int i = 0; i < 8; i++)
+		{
+			glm::vec3 const corner{i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z};
+			nearDepth = std::min(nearDepth, -(lightView * glm::vec4{corner, 1.0f}).z);
+		}
+	}
+	glm::mat4 const lightProjection = glm::ortho(lightCenter.x - radius, lightCenter.x + radius,
+		lightCenter.y - radius, lightCenter.y + radius, nearDepth, farDepth);
+	return lightProjection * lightView;
+}
+
+template<typename Volume>
+std::vector<Prop*> const& RenderContext::cullCasters(Volume const& volume)
+{
+	if(!shadows.cullCasters)
+		return scene.getAllEnabled<Prop>();
+	shadows.casters.clear();
+	scene.getBoundingVolumes().query(volume, [&](Prop* prop){
+		if(prop->isEnabled())
+			shadows.casters.push_back(prop);
+	});
+	return shadows.casters;
+}
+
+bool RenderContext::overBudget() const
+{
+	if(shadows.drawBudget > 0 && shadows.drawnCasters >= shadows.drawBudget)
+		return true;
+	return shadows.timeBudget > 0.0f &&
+		std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - current.start).count() >= shadows.timeBudget;
+}
+
+bool RenderContext::renderCasters(Node const* light, uint64_t lightSignature, std::vector<Prop*> const& casters,
+	std::function<void(std::vector<Prop*> const&, int)> const& draw, bool always, int cascade)
+{
+	auto& atlas = shadows.atlas;
+	//cascades of a light add up to one entry
+	if(!shadows.casterCounts.empty() && shadows.casterCounts.back().first == light)
+		shadows.casterCounts.back().second += int(casters.size());
+	else
+		shadows.casterCounts.emplace_back(light, int(casters.size()));
+	profiler::counters::shadowCasters.increment(int(casters.size()));
+	shadows.staticCasters.clear();
+	shadows.dynamicCasters.clear();
+	for(auto prop : casters)
+	{
+		if(shadows.staticLayer && prop->getTransformationVersion() <= current.movedSince)
+			shadows.staticCasters.push_back(prop);
+		else
+			shadows.dynamicCasters.push_back(prop);
+	}
+	auto const update = atlas.getUpdate(light, lightSignature ^ current.settings,
+		getCasterSignature(shadows.staticCasters), getCasterSignature(shadows.dynamicCasters), cascade);
+	if(!update.dynamicFaces)
+		return false;
+	always = always || update.fresh;
+	if(!always && overBudget())
+	{
+		atlas.defer(light, cascade);
+		return false;
+	}
+	int const allFaces = atlas.getLayer(light) != -1 ? 0b111111 : 1;
+	int faces = update.dynamicFaces;
+	if(!always)
+		faces &= -faces;
+	auto renderFaces = [&](int face, int faceMask){
+		if(!shadows.staticLayer)
+		{
+			atlas.renderTo(light, ShadowAtlas::Layer::all, cascade, face);
+			draw(shadows.dynamicCasters, faceMask);
+			shadows.drawnCasters += int(shadows.dynamicCasters.size());
+			return;
+		}
+		if(update.staticFaces & faceMask)
+		{
+			atlas.renderTo(light, ShadowAtlas::Layer::staticCasters, cascade, face);
+			draw(shadows.staticCasters, faceMask);
+			shadows.drawnCasters += int(shadows.staticCasters.size());
+		}
+		atlas.renderTo(light, ShadowAtlas::Layer::dynamicCasters, cascade, face);
+		draw(shadows.dynamicCasters, faceMask);
+		shadows.drawnCasters += int(shadows.dynamicCasters.size());
+	};
+	if(faces == allFaces)
+	{
+		renderFaces(-1, allFaces);
+	}
+	else
+	{
+		for(int face = 0; face < 6; face++)
+			if(faces & 1 << face)
+				renderFaces(face, 1 << face);
+	}
+	return true;
+}
+
+void RenderContext::renderCascades(Camera const& camera, int firstCascade, DepthRenderer const& renderDepth)
+{
+	auto& atlas = shadows.atlas;
+	auto const drawUnidirectional = [&](std::vector<Prop*> const& casters, int){
+		renderDepth(ShaderManager::shadowMappingUnidirectional(), casters);
+	};
+	//cascades follow the camera, so directional lights are always updated
+	auto const cascadeSplits = getCascadeSplits(camera);
+	for(auto light : scene.getAll<DirectionalLight>())
+	{
+		for(int cascade = 0; cascade < atlas.getCascades(light, firstCascade); cascade++)
+		{
+			int const slot = firstCascade + cascade;
+			glm::mat4 const lightSpace = getCascadeLightSpace(camera, light->getDirection(), cascadeSplits[cascade],
+				cascadeSplits[cascade + 1], atlas.getTile(light, slot).size);
+			ShaderManager::shadowMappingUnidirectional()->use();
+			ShaderManager::shadowMappingUnidirectional()->set(uniforms::lightSpace, lightSpace);
+			if(renderCasters(light, getMatrixSignature(lightSpace), cullCasters(Frustum{lightSpace}), drawUnidirectional, true, slot))
+				atlas.setLightSpace(light, lightSpace, cascadeSplits[cascade + 1], slot);
+		}
+	}
+}
+
+void RenderContext::renderSpotLight(SpotLight* light, bool always, DepthRenderer const& renderDepth)
+{
+	float const nearPlane = shadows.spotLightNearPlane;
+	float const farPlane = shadows.spotLightFarPlane;
+	glm::mat4 lightProjection = glm::perspective(glm::radians(light->getOuterCutoff() * 2), 1.0f, nearPlane, farPlane);
+	glm::vec3 eye = light->getPosition();
+	glm::vec3 center = eye + light->getDirection();
+	glm::mat4 lightView = glm::lookAt(eye, center, glm::vec3{0.0f, 1.0f, 0.0f});
+	glm::mat4 lightSpace = lightProjection * lightView;
+	ShaderManager::shadowMappingUnidirectional()->use();
+	ShaderManager::shadowMappingUnidirectional()->set(uniforms::lightSpace, lightSpace);
+	auto const drawUnidirectional = [&](std::vector<Prop*> const& casters, int){
+		renderDepth(ShaderManager::shadowMappingUnidirectional(), casters);
+	};
+	if(renderCasters(light, getMatrixSignature(lightSpace), cullCasters(Frustum{lightSpace}), drawUnidirectional, always))
+		shadows.atlas.setLightSpace(light, lightSpace);
+}
+
+void RenderContext::renderPointLight(PointLight* light, bool always, DepthRenderer const& renderDepth)
+{
+	float const nearPlane = shadows.pointLightNearPlane;
+	float const farPlane = shadows.pointLightFarPlane;
+	glm::mat4 lightProjection = glm::perspective(glm::radians(90.0f), 1.0f, nearPlane, farPlane);
+	glm::vec3 eye = light->getPosition();
+	std::array<glm::mat4, 6> lightSpaceMatrices = {
+		lightProjection * glm::lookAt(eye, eye + glm::vec3{+1.0f, 0.0f, 0.0f}, glm::vec3{0.0f, -1.0f, 0.0f}),
+		lightProjection * glm::lookAt(eye, eye + glm::vec3{-1.0f, 0.0f, 0.0f}, glm::vec3{0.0f, -1.0f, 0.0f}),
+		lightProjection * glm::lookAt(eye, eye + glm::vec3{0.0f, +1.0f, 0.0f}, glm::vec3{0.0f, 0.0f, +1.0f}),
+		lightProjection * glm::lookAt(eye, eye + glm::vec3{0.0f, -1.0f, 0.0f}, glm::vec3{0.0f, 0.0f, -1.0f}),
+		lightProjection * glm::lookAt(eye, eye + glm::vec3{0.0f, 0.0f, +1.0f}, glm::vec3{0.0f, -1.0f, 0.0f}),
+		lightProjection * glm::lookAt(eye, eye + glm::vec3{0.0f, 0.0f, -1.0f}, glm::vec3{0.0f, -1.0f, 0.0f})
+	};
+	ShaderManager::shadowMappingOmnidirectional()->use();
+	ShaderManager::shadowMappingOmnidirectional()->set("lightPos", eye);
+	ShaderManager::shadowMappingOmnidirectional()->set("farPlane", farPlane);
+	ShaderManager::shadowMappingOmnidirectional()->set(uniforms::cubeLayer, shadows.atlas.getLayer(light));
+	for(int i = 0; i < 6; i++)
+		ShaderManager::shadowMappingOmnidirectional()->set(uniforms::lightSpaces[i], lightSpaceMatrices[i]);
+	std::array<Frustum, 6> const faces = {
+		lightSpaceMatrices[0], lightSpaceMatrices[1], lightSpaceMatrices[2],
+		lightSpaceMatrices[3], lightSpaceMatrices[4], lightSpaceMatrices[5]};
+	auto getFaceMask = [&](Prop const* prop){
+		auto const[min, max] = prop->getOwnBounds().getValues();
+		int faceMask = 0;
+		for(int face = 0; face < 6; face++)
+			if(faces[face].intersects(min, max))
+				faceMask |= 1 << face;
+		return faceMask;
+	};
+	//every caster is only emitted to the drawn cube faces whose frustum it intersects
+	auto drawOmnidirectional = [&](std::vector<Prop*> const& casters, int drawnFaces){
+		for(auto& bucket : shadows.castersByFaceMask)
+			bucket.clear();
+		if(shadows.cullCasters)
+		{
+			for(auto prop : casters)
+				shadows.castersByFaceMask[getFaceMask(prop) & drawnFaces].push_back(prop);
+		}
+		else
+		{
+			shadows.castersByFaceMask[drawnFaces] = casters;
+		}
+		for(int faceMask = 1; faceMask < 64; faceMask++)
+		{
+			if(shadows.castersByFaceMask[faceMask].empty())
+				continue;
+			ShaderManager::shadowMappingOmnidirectional()->use();
+			ShaderManager::shadowMappingOmnidirectional()->set("faceMask", faceMask);
+			renderDepth(ShaderManager::shadowMappingOmnidirectional(), shadows.castersByFaceMask[faceMask]);
+		}
+	};
+	auto const* casters = &scene.getAllEnabled<Prop>();
+	if(shadows.cullCasters)
+	{
+		//casters outside of every face are dropped up front, so they don't invalidate the cached cube
+		cullCasters(Sphere{eye, farPlane});
+		shadows.casters.erase(std::remove_if(shadows.casters.begin(), shadows.casters.end(), [&](Prop const* prop){
+			return getFaceMask(prop) == 0;
+		}), shadows.casters.end());
+		casters = &shadows.casters;
+	}
+	//the first face covers both the position and the planes of the light
+	renderCasters(light, getMatrixSignature(lightSpaceMatrices[0]), *casters, drawOmnidirectional, always);
+}
+
+void RenderContext::renderLocalLights(float attenuationCutoff, DepthRenderer const& renderDepth)
+{
+	auto& atlas = shadows.atlas;
+	//influence is roughly the share of the closest view the light's range covers, lights out of every view only matter
+	//for the shadows they cast into them
+	std::vector<Frustum> frusta;
+	for(auto const& view : views)
+		frusta.emplace_back(view.camera->getProjectionMatrix() * view.camera->getViewMatrix());
+	auto getInfluence = [&](auto const* light){
+		glm::vec3 const position = light->getPosition();
+		float const range = light->getRange(attenuationCutoff);
+		float influence = 0.0f;
+		for(int i = 0; i < int(views.size()); i++)
+		{
+			float viewInfluence = range / std::max(glm::length(position - views[i].camera->getPosition()), 1.0f);
+			if(!frusta[i].intersects(position - glm::vec3{range}, position + glm::vec3{range}))
+				viewInfluence *= 0.1f;
+			influence = std::max(influence, viewInfluence);
+		}
+		return influence;
+	};
+	shadows.schedule.clear();
+	for(auto light : scene.getAll<SpotLight>())
+		if(atlas.getShadow(light) != -1)
+			shadows.schedule.emplace_back(getInfluence(light), light);
+	for(auto light : scene.getAll<PointLight>())
+		if(atlas.getShadow(light) != -1)
+			shadows.schedule.emplace_back(getInfluence(light), light);
+	auto const byPriority = [](auto const& lhs, auto const& rhs){
+		return lhs.first > rhs.first;
+	};
+	std::sort(shadows.schedule.begin(), shadows.schedule.end(), byPriority);
+	//the rest take turns, every frame a light waits raises its priority
+	int const alwaysUpdated = std::min(std::max(shadows.alwaysUpdated, 0), int(shadows.schedule.size()));
+	for(auto it = shadows.schedule.begin() + alwaysUpdated; it != shadows.schedule.end(); ++it)
+		it->first *= 1.0f + atlas.getDeferredFrames(it->second);
+	std::sort(shadows.schedule.begin() + alwaysUpdated, shadows.schedule.end(), byPriority);
+	for(int i = 0; i < int(shadows.schedule.size()); i++)
+	{
+		Node* light = shadows.schedule[i].second;
+		if(light->getType() == NodeType::spotLight)
+			renderSpotLight(static_cast<SpotLight*>(light), i < alwaysUpdated, renderDepth);
+		else
+			renderPointLight(static_cast<PointLight*>(light), i < alwaysUpdated, renderDepth);
+	}
+}
+
+int RenderContext::updateShadows(uint64_t frame, Camera const& camera, float attenuationCutoff, DepthRenderer const& renderDepth)
+{
+	if(shadows.faceCulling)
+	{
+		glEnable(GL_CULL_FACE);
+		glCullFace(shadows.faceCullingMode);
+		glFrontFace(GL_CCW);
+	}
+	else
+	{
+		glDisable(GL_CULL_FACE);
+	}
+	if(frame != current.frame)
+	{
+		current.frame = frame;
+		//views that weren't drawn last frame, or whose camera left the scene, give up their cascades
+		auto const& cameras = scene.getAll<Camera>();
+		views.erase(std::remove_if(views.begin(), views.end(), [&](View const& view){
+			return !view.drawn || std::find(cameras.begin(), cameras.end(), view.camera) == cameras.end();
+		}), views.end());
+		for(auto& view : views)
+			view.drawn = false;
+		getView(camera);
+
+		if(!shadows.caching)
+			shadows.atlas.invalidate();
+		//props with a newer version than the oldest frame remembered moved lately, and are kept out of the static layers
+		shadows.versionHistory.push_back(Node::getLatestTransformationVersion());
+		while(int(shadows.versionHistory.size()) > std::max(shadows.dynamicFrames, 1))
+			shadows.versionHistory.pop_front();
+		current.movedSince = shadows.versionHistory.front();
+		current.settings = mixSignature(uint64_t(shadows.faceCulling) | uint64_t(shadows.faceCullingMode) << 1 |
+			uint64_t(shadows.staticLayer) << 32);
+		//only the stale faces of layers whose light or casters changed are drawn, once the budget of the frame is spent
+		//shadow maps that may wait are left stale for later frames, amortized cubes are drawn one face per frame
+		current.start = std::chrono::steady_clock::now();
+		shadows.drawnCasters = 0;
+		shadows.casterCounts.clear();
+		allocateShadowMaps();
+		renderLocalLights(attenuationCutoff, renderDepth);
+	}
+	int const view = getView(camera);
+	int const firstCascade = view * ShadowAtlas::maxCascades;
+	//views showing up after the shadow maps of the frame were allocated get their cascades on their own
+	if(!views[view].allocated)
+	{
+		for(auto light : scene.getAll<DirectionalLight>())
+			if(light->isEnabled())
+				shadows.atlas.requestCascades(light, 1 << shadows.resolution, shadows.cascades, firstCascade);
+		views[view].allocated = true;
+	}
+	if(!views[view].drawn)
+	{
+		renderCascades(camera, firstCascade, renderDepth);
+		views[view].drawn = true;
+	}
+	return firstCascade;
+}
+
+ShadowAtlas& RenderContext::getShadowAtlas()
+{
+	return shadows.atlas;
+}
+
+void RenderContext::drawUI()
+{
+	IDGuard idGuard{this};
+	ImGui::Text("Shadow Map Generation, Shared By %i Views", int(views.size()));
+	ImGui::Checkbox("Face Culling", &shadows.faceCulling);
+	if(shadows.faceCulling)
+	{
+		ImGui::SameLine();
+		chooseGLEnumFromCombo(shadows.faceCullingMode, {
+			GL_FRONT_AND_BACK, GL_FRONT, GL_BACK
+		});
+	}
+	ImGui::AlignTextToFramePadding();
+	ImGui::Text("Tile Resolution Exponent");
+	ImGui::SameLine();
+	ImGui::InputInt("###Resolution", &shadows.resolution, 1);
+	shadows.resolution = std::clamp(shadows.resolution, 1, shadows.atlasResolution);
+	ImGui::AlignTextToFramePadding();
+	ImGui::Text("Full Resolution Distance");
+	ImGui::SameLine();
+	ImGui::InputFloat("###fullResolutionDistance", &shadows.fullResolutionDistance, 1.0f, 5.0f);
+	shadows.fullResolutionDistance = std::max(shadows.fullResolutionDistance, 0.01f);
+	//resizing drops every tile, so it only happens once editing is done
+	ImGui::AlignTextToFramePadding();
+	ImGui::Text("Atlas Resolution Exponent");
+	ImGui::SameLine();
+	ImGui::InputInt("###AtlasResolution", &shadows.atlasResolution, 1);
+	shadows.atlasResolution = std::clamp(shadows.atlasResolution, 1, 14);
+	if(ImGui::IsItemDeactivatedAfterChange())
+		resizeShadowMaps();
+	ImGui::AlignTextToFramePadding();
+	ImGui::Text("Point Light Resolution Exponent");
+	ImGui::SameLine();
+	ImGui::InputInt("###PointResolution", &shadows.pointResolution, 1);
+	shadows.pointResolution = std::clamp(shadows.pointResolution, 1, 13);
+	if(ImGui::IsItemDeactivatedAfterChange())
+		resizeShadowMaps();
+	ImGui::AlignTextToFramePadding();
+	ImGui::Text("Point Light Shadows");
+	ImGui::SameLine();
+	ImGui::InputInt("###PointCapacity", &shadows.pointCapacity, 1);
+	shadows.pointCapacity = std::clamp(shadows.pointCapacity, 1, 64);
+	if(ImGui::IsItemDeactivatedAfterChange())
+		resizeShadowMaps();
+	ImGui::AlignTextToFramePadding();
+	ImGui::Text("Directional Light Cascades");
+	ImGui::SameLine();
+	ImGui::InputInt("###Cascades", &shadows.cascades, 1);
+	shadows.cascades = std::clamp(shadows.cascades, 1, ShadowAtlas::maxCascades);
+	ImGui::AlignTextToFramePadding();
+	ImGui::Text("Cascade Distance");
+	ImGui::SameLine();
+	ImGui::InputFloat("###CascadeDistance", &shadows.cascadeDistance, 1.0f, 10.0f);
+	shadows.cascadeDistance = std::max(shadows.cascadeDistance, 1.0f);
+	ImGui::AlignTextToFramePadding();
+	ImGui::Text("Logarithmic Cascade Splits");
+	ImGui::SameLine();
+	ImGui::SliderFloat("###CascadeSplitBlend", &shadows.cascadeSplitBlend, 0.0f, 1.0f);
+	ImGui::AlignTextToFramePadding();
+	ImGui::Text("Spotlight Near Plane");
+	ImGui::SameLine();
+	ImGui::InputFloat("###spotlightnearplane", &shadows.spotLightNearPlane, 0.01f, 1.0f);
+	ImGui::AlignTextToFramePadding();
+	ImGui::Text("Spotlight Far Plane");
+	ImGui::SameLine();
+	ImGui::InputFloat("###spotlightfarplane", &shadows.spotLightFarPlane, 1.0f, 5.0f);
+	ImGui::AlignTextToFramePadding();
+	ImGui::Text("Pointlight Near Plane");
+	ImGui::SameLine();
+	ImGui::InputFloat("###pointlightnearplane", &shadows.pointLightNearPlane, 0.01f, 1.0f);
+	ImGui::AlignTextToFramePadding();
+	ImGui::Text("Pointlight Far Plane");
+	ImGui::SameLine();
+	ImGui::InputFloat("###pointlightfarplane", &shadows.pointLightFarPlane, 1.0f, 5.0f);
+	ImGui::Checkbox("Cull Shadow Casters", &shadows.cullCasters);
+	ImGui::Checkbox("Cache Shadow Maps", &shadows.caching);
+	ImGui::AlignTextToFramePadding();
+	ImGui::Text("Lights Updated Every Frame");
+	ImGui::SameLine();
+	ImGui::InputInt("###AlwaysUpdated", &shadows.alwaysUpdated, 1);
+	shadows.alwaysUpdated = std::max(shadows.alwaysUpdated, 0);
+	ImGui::AlignTextToFramePadding();
+	ImGui::Text("Caster Draw Budget");
+	ImGui::SameLine();
+	ImGui::InputInt("###DrawBudget", &shadows.drawBudget, 100, 1000);
+	shadows.drawBudget = std::max(shadows.drawBudget, 0);
+	ImGui::AlignTextToFramePadding();
+	ImGui::Text("Time Budget (ms)");
+	ImGui::SameLine();
+	ImGui::InputFloat("###TimeBudget", &shadows.timeBudget, 0.1f, 1.0f, "%.2f");
+	shadows.timeBudget = std::max(shadows.timeBudget, 0.0f);
+	ImGui::Text("Casters Drawn: %i", shadows.drawnCasters);
+	ImGui::Checkbox("Static Shadow Layers", &shadows.staticLayer);
+	ImGui::AlignTextToFramePadding();
+	ImGui::Text("Frames Casters Stay Dynamic");
+	ImGui::SameLine();
+	ImGui::InputInt("###DynamicFrames", &shadows.dynamicFrames, 1, 10);
+	shadows.dynamicFrames = std::clamp(shadows.dynamicFrames, 1, 1000);
+	for(auto const&[light, casters] : shadows.casterCounts)
+		ImGui::BulletText("%s: %i casters", light->getName().data(), casters);
+	if(ImGui::TreeNode("Shadow Atlas"))
+	{
+		shadows.atlas.drawUI();
+		ImGui::TreePop();
+	}
+}
@@ -0,0 +1,211 @@
+#include "RenderQueue.h"
+#include "Prop.h"
+#include "Mesh.h"
+
+#include <algorithm>
+#include <array>
+#include <tuple>
+
+namespace
+{
+	constexpr int meshShift = RenderQueue::depthBits;
+	constexpr int materialShift = meshShift + RenderQueue::meshBits;
+	constexpr int shaderShift = materialShift + RenderQueue::materialBits;
+	constexpr int passShift = shaderShift + RenderQueue::shaderBits;
+
+	constexpr uint64_t getMask(int bits)
+	{
+		return (uint64_t(1) << bits) - 1;
+	}
+}
+
+uint64_t RenderQueue::getShaderID(std::unordered_map<void const*, uint64_t>& ids, void const* object)
+{
+	//every key of one sort shares its shader, so wrapping around only mixes up ids that are never compared
+	auto const[it, inserted] = ids.try_emplace(object, ids.size() & getMask(shaderBits));
+	return it->second;
+}
+
+uint64_t RenderQueue::acquireID(IDs& ids, void const* object)
+{
+	auto const[it, inserted] = ids.references.try_emplace(object, IDs::Reference{0, 0});
+	if(inserted)
+	{
+		if(ids.released.empty())
+		{
+			it->second.id = ids.next++;
+		}
+		else
+		{
+			it->second.id = ids.released.back();
+			ids.released.pop_back();
+		}
+	}
+	it->second.count++;
+	return it->second.id;
+}
+
+void RenderQueue::releaseID(IDs& ids, void const* object)
+{
+	auto const it = ids.references.find(object);
+	if(--it->second.count > 0)
+		return;
+	ids.released.push_back(it->second.id);
+	ids.references.erase(it);
+}
+
+void RenderQueue::updateState(Item& item)
+{
+	Mesh const& mesh = item.prop->getMesh();
+	void const* const material = item.prop->getMaterial();
+	uint64_t const materialID = acquireID(materialIDs, material);
+	uint64_t const meshID = acquireID(meshIDs, &mesh);
+	uint64_t const pool = uint64_t(mesh.getArenaRange().pool);
+	releaseState(item);
+	item.material = material;
+	item.mesh = &mesh;
+	item.overflowing = materialID > getMask(materialBits) || meshID > getMask(meshBits - poolBits) || pool > getMask(poolBits);
+	if(item.overflowing)
+		overflowingItems++;
+	uint64_t const meshField = (pool & getMask(poolBits)) << (meshBits - poolBits) | (meshID & getMask(meshBits - poolBits));
+	item.state = (materialID & getMask(materialBits)) << materialShift | meshField << meshShift;
+}
+
+void RenderQueue::releaseState(Item& item)
+{
+	if(!item.mesh)
+		return;
+	releaseID(materialIDs, item.material);
+	releaseID(meshIDs, item.mesh);
+	if(item.overflowing)
+		overflowingItems--;
+	item.material = nullptr;
+	item.mesh = nullptr;
+	item.overflowing = false;
+}
+
+void RenderQueue::radixSort() const
+{
+	//least significant byte first, bytes every key shares are skipped
+	int const count = int(entries.size());
+	std::array<std::array<int, 256>, 8> histograms{};
+	for(auto const& entry : entries)
+		for(int digit = 0; digit < 8; digit++)
+			histograms[digit][(entry.key >> (digit * 8)) & 0xFF]++;
+	scratch.resize(count);
+	for(int digit = 0; digit < 8; digit++)
+	{
+		auto& histogram = histograms[digit];
+		if(histogram[(entries.front().key >> (digit * 8)) & 0xFF] == count)
+			continue;
+		int offset = 0;
+		for(auto& bucket : histogram)
+		{
+			int const size = bucket;
+			bucket = offset;
+			offset += size;
+		}
+		for(auto const& entry : entries)
+			scratch[histogram[(entry.key >> (digit * 8)) & 0xFF]++] = entry;
+		entries.swap(scratch);
+	}
+}
+
+void RenderQueue::comparisonSort(bool useMaterials) const
+{
+	//the same order the keys would give, with the objects themselves standing in for their ids
+	auto state = [&](Entry const& entry){
+		Item const& item = items[entry.item];
+		return std::make_tuple(useMaterials ? item.material : nullptr, item.mesh->getArenaRange().pool, item.mesh);
+	};
+	std::sort(entries.begin(), entries.end(), [&](Entry const& lhs, Entry const& rhs){
+		auto const lhsState = state(lhs);
+		auto const rhsState = state(rhs);
+		if(lhsState != rhsState)
+			return lhsState < rhsState;
+		return lhs.key < rhs.key;
+	});
+}
+
+void RenderQueue::insert(Prop* prop)
+{
+	int item;
+	if(freeItems.empty())
+	{
+		item = int(items.size());
+		items.emplace_back();
+	}
+	else
+	{
+		item = freeItems.back();
+		freeItems.pop_back();
+	}
+	items[item] = Item{};
+	items[item].prop = prop;
+	updateState(items[item]);
+	prop->renderQueueItem = item;
+}
+
+void RenderQueue::remove(Prop* prop)
+{
+	int const item = prop->renderQueueItem;
+	releaseState(items[item]);
+	items[item] = Item{};
+	freeItems.push_back(item);
+	prop->renderQueueItem = -1;
+}
+
+void RenderQueue::outdated(Prop* prop)
+{
+	int const item = prop->renderQueueItem;
+	if(item == -1 || items[item].outdated)
+		return;
+	items[item].outdated = true;
+	outdatedItems.push_back(item);
+}
+
+void RenderQueue::update()
+{
+	for(int item : outdatedItems)
+	{
+		//the item might have been removed, and its slot reused, since it was marked
+		if(!items[item].outdated)
+			continue;
+		items[item].outdated = false;
+		updateState(items[item]);
+	}
+	outdatedItems.clear();
+}
+
+int RenderQueue::getSize() const
+{
+	return int(items.size() - freeItems.size());
+}
+
+void RenderQueue::sort(std::vector<Prop*> const& props, Pass pass, Shader const* shader, bool useMaterials,
+	glm::vec3 const& eye, float range, std::vector<Prop*>& out) const
+{
+	out.clear();
+	if(props.empty())
+		return;
+	uint64_t const shaderID = getShaderID(shaderIDs, shader);
+	uint64_t const common = uint64_t(pass) << passShift | shaderID << shaderShift;
+	uint64_t const stateMask = useMaterials ? ~getMask(meshShift) : getMask(materialShift) & ~getMask(meshShift);
+	float const depthScale = range > 0.0f ? getMask(depthBits) / range : 0.0f;
+	entries.clear();
+	entries.reserve(props.size());
+	for(auto prop : props)
+	{
+		int const item = prop->renderQueueItem;
+		glm::vec3 const position = prop->getGlobalTransformation()[3];
+		float const depth = std::min(glm::length(position - eye) * depthScale, float(getMask(depthBits)));
+		entries.push_back({common | (items[item].state & stateMask) | uint64_t(depth), item});
+	}
+	if(overflowingItems > 0)
+		comparisonSort(useMaterials);
+	else
+		radixSort();
+	out.reserve(entries.size());
+	for(auto const& entry : entries)
+		out.push_back(items[entry.item].prop);
+}
@@ -5,6 +5,38 @@
 #include "SceneManager.h"
 #include "TextureManager.h"
 #include "MeshManager.h"
+#include "MeshArena.h"
+#include "Profiler.h"
+#include "Geometry.h"
+#include "RenderContext.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+namespace
+{
+	//uniforms set every frame are held as handles, so a steady frame neither formats names nor queries locations
+	namespace uniforms
+	{
+		Shader::UniformArray<Light::Uniforms> const dirLights{"dirLights[", "]."};
+		Shader::UniformArray<Light::Uniforms> const pointLights{"pointLights[", "]."};
+		Shader::UniformArray<Light::Uniforms> const spotLights{"spotLights[", "]."};
+		Shader::Uniform<int> const nDirLights{"nDirLights"};
+		Shader::Uniform<int> const nPointLights{"nPointLights"};
+		Shader::Uniform<int> const nSpotLights{"nSpotLights"};
+		Shader::Uniform<glm::mat4> const model{"model"};
+		Shader::Uniform<int> const instanced{"instanced"};
+	}
+
+	//matches Instance in the vertex shaders, normal is the inverse transpose of view * model
+	struct Instance
+	{
+		glm::mat4 model;
+		glm::mat4 normal;
+	};
+}
 
 Renderer::Renderer(Camera* camera)
 {
@@ -42,14 +74,42 @@ Renderer::~Renderer()
 
 	glDeleteFramebuffers(1, &multisampledFramebuffer);
 	glDeleteFramebuffers(1, &simpleFramebuffer);
+
+}
+
+uint64_t Renderer::getDependencyTimestamp() const
+{
+	uint64_t timestamp = std::max({camera->getTimestamp(), Material::getLatestTimestamp(), Texture::getLatestTimestamp(),
+		Shader::getLatestTimestamp()});
+	if(scene)
+		timestamp = std::max(timestamp, scene->getTimestamp());
+	return timestamp;
 }
 
 bool Renderer::skipFrame() const
 {
 	if(!camera)
 		return true;
-	if(explicitRendering)
+	if(skipUnchangedFrames)
 	{
+		uint64_t const timestamp = getDependencyTimestamp();
+		if(timestamp != renderedTimestamp)
+		{
+			renderedTimestamp = timestamp;
+			_shouldRender = true;
+		}
+		//flashing highlights and shadow updates left for later frames change the image without changing the scene
+		if(highlighting.enabled && scene)
+		{
+			auto const anyHighlighted = [](auto const& lights){
+				return std::any_of(lights.begin(), lights.end(), [](auto light){ return light->isHighlighted(); });
+			};
+			if(anyHighlighted(scene->getAll<DirectionalLight>()) || anyHighlighted(scene->getAll<PointLight>()) ||
+				anyHighlighted(scene->getAll<SpotLight>()))
+				_shouldRender = true;
+		}
+		if(shading.lighting.shadows.enabled && scene && scene->getRenderContext().getShadowAtlas().hasDeferred())
+			_shouldRender = true;
 		if(_shouldRender)
 		{
 			_shouldRender = false;
@@ -125,7 +185,7 @@ void Renderer::clearBuffers() const
 
 void Renderer::renderAuxiliaryGeometry() const
 {
-	camera->use();
+	camera->use(frameData);
 	glDisable(GL_CULL_FACE);
 	ShaderManager::unlit()->use();
 	for(auto const& _camera : scene->getAll<Camera>())
@@ -192,85 +252,13 @@ void Renderer::renderLights() const
 	drawLights(scene->getAll<SpotLight>());
 }
 
-void Renderer::updateShadowMaps() const
+int Renderer::renderShadowMaps() const
 {
-	const int resolution = 1 << shading.lighting.shadows.resolution;
-	auto allocateShadowMap = [&]() -> Texture{
-		Texture ret{GL_DEPTH_COMPONENT, resolution, resolution,
-			GL_DEPTH_COMPONENT, GL_FLOAT};
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, shading.lighting.shadows.depthComparison);
-		static float const borderColor[] = {1.0f, 1.0f, 1.0f, 1.0f};
-		glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-		return std::move(ret);
-	};
-	auto resetMaps = [&](auto& lights, auto& shadowMaps){
-		shadowMaps.clear();
-		shadowMaps.reserve(lights.size());
-		for(auto& light : lights)
-			shadowMaps.emplace_back(allocateShadowMap());
-
-	};
-	resetMaps(scene->getAll<DirectionalLight>(), shading.lighting.shadows.shadowMapsD);
-	resetMaps(scene->getAll<SpotLight>(), shading.lighting.shadows.shadowMapsS);
-	auto& pointLights = scene->getAll<PointLight>();
-	auto& shadowMapsP = shading.lighting.shadows.shadowMapsP;
-	shadowMapsP.clear();
-	shadowMapsP.reserve(pointLights.size());
-	for(auto& light : pointLights)
-	{
-		shadowMapsP.emplace_back(GL_DEPTH_COMPONENT, resolution, resolution,
-			GL_DEPTH_COMPONENT, GL_FLOAT);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_FUNC, shading.lighting.shadows.depthComparison);
-	}
-}
-
-void Renderer::renderShadowMaps() const
-{
-	auto lightsD = scene->getAll<DirectionalLight>();
-	auto lightsS = scene->getAll<SpotLight>();
-	auto lightsP = scene->getAll<PointLight>();
-	auto& shadowMapsD = shading.lighting.shadows.shadowMapsD;
-	auto& shadowMapsS = shading.lighting.shadows.shadowMapsS;
-	auto& shadowMapsP = shading.lighting.shadows.shadowMapsP;
-	if(lightsD.size() != shadowMapsD.size() || 
-		lightsS.size() != shadowMapsS.size() ||
-		lightsP.size() != shadowMapsP.size())
-	{
-		updateShadowMaps();
-	}
-
-	static unsigned int shadowMappingFBO = [](){
-		unsigned int fbo;
-		glGenFramebuffers(1, &fbo);
-		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-		glDrawBuffer(GL_NONE);
-		glReadBuffer(GL_NONE);
-		return fbo;
-	}();
-	const int resolution = 1 << shading.lighting.shadows.resolution;
-	glViewport(0, 0, resolution, resolution);
-	glBindFramebuffer(GL_FRAMEBUFFER, shadowMappingFBO);
-	if(shading.lighting.shadows.faceCulling)
-	{
-		glEnable(GL_CULL_FACE);
-		glCullFace(shading.lighting.shadows.faceCullingMode);
-		glFrontFace(GL_CCW);
-	}
-	else
-	{
-		glDisable(GL_CULL_FACE);
-	}
-	int enabledDirectionalLights = 0;
-
 	if(shading.current == ShaderManager::pbr())
 	{
-		shading.current->set("dirLights[0].shadowMap", 16);
-		shading.current->set("pointLights[0].shadowMap", 17);
-		shading.current->set("spotLights[0].shadowMap", 18);
+		//unused shadow samplers of different types can't share a unit
+		shading.current->set("shadowAtlas", 16);
+		shading.current->set("pointShadowMaps", 17);
 		shading.current->set("material.normalMap", 19);
 		shading.current->set("material.occlusionMap", 20);
 		shading.current->set("material.emissiveMap", 21);
@@ -280,88 +268,20 @@ void Renderer::renderShadowMaps() const
 
 	}
 
-	for(int i = 0; i < lightsD.size(); i++)
-	{
-		if(!lightsD[i]->isEnabled())
-			continue;
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadowMapsD[i].getID(), 0);
-		glClear(GL_DEPTH_BUFFER_BIT);
-
-		float const projSize = shading.lighting.shadows.directionalLightProjectionSize;
-		glm::mat4 lightProjection = glm::ortho(-projSize, projSize, -projSize, projSize, 0.01f, 100.0f);
-		glm::vec3 lightDirection = lightsD[i]->getDirection();
-		glm::vec3 eye = -lightDirection * projSize;
-		glm::vec3 center = eye + lightDirection;
-		glm::mat4 lightView = glm::lookAt(eye, center, glm::vec3{0.0f, 1.0f, 0.0f});
-		glm::mat4 lightSpace = lightProjection * lightView;
-		ShaderManager::shadowMappingUnidirectional()->use();
-		ShaderManager::shadowMappingUnidirectional()->set("lightSpace", lightSpace);
-		renderProps(ShaderManager::shadowMappingUnidirectional());
-		shading.current->use();
-		shading.current->set("lightSpacesD[" + std::to_string(enabledDirectionalLights) + "]", lightSpace);
-		shading.current->set("dirLights[" + std::to_string(enabledDirectionalLights++) + "].shadowMap", 10 + i);
-		shadowMapsD[i].use(10 + i);
-	}
-	int enabledSpotLights = 0;
-	for(int i = 0; i < lightsS.size(); i++)
-	{
-		if(!lightsS[i]->isEnabled())
-			continue;
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadowMapsS[i].getID(), 0);
-		glClear(GL_DEPTH_BUFFER_BIT);
-		float const nearPlane = shading.lighting.shadows.spotLightNearPlane;
-		float const farPlane = shading.lighting.shadows.spotLightFarPlane;
-		glm::mat4 lightProjection = glm::perspective(glm::radians(lightsS[i]->getOuterCutoff() * 2), 1.0f, nearPlane, farPlane);
-		glm::vec3 eye = lightsS[i]->getPosition();
-		glm::vec3 center = eye + lightsS[i]->getDirection();
-		glm::mat4 lightView = glm::lookAt(eye, center, glm::vec3{0.0f, 1.0f, 0.0f});
-		glm::mat4 lightSpace = lightProjection * lightView;
-		ShaderManager::shadowMappingUnidirectional()->use();
-		ShaderManager::shadowMappingUnidirectional()->set("lightSpace", lightSpace);
-		renderProps(ShaderManager::shadowMappingUnidirectional());
-		shading.current->use();
-		shading.current->set("lightSpacesS[" + std::to_string(enabledSpotLights) + "]", lightSpace);
-		shading.current->set("spotLights[" + std::to_string(enabledSpotLights++) + "].shadowMap", 
-			10 + i + enabledDirectionalLights);
-		shadowMapsS[i].use(10 + i + enabledDirectionalLights);
-	}
-
-	int enabledPointLights = 0;
-	for(int i = 0; i < lightsP.size(); i++)
-	{
-		if(!lightsP[i]->isEnabled())
-			continue;
-		glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadowMapsP[i].getID(), 0);
-		glClear(GL_DEPTH_BUFFER_BIT);
-		float const nearPlane = shading.lighting.shadows.pointLightNearPlane;
-		float const farPlane = shading.lighting.shadows.pointLightFarPlane;
-		glm::mat4 lightProjection = glm::perspective(glm::radians(90.0f), 1.0f, nearPlane, farPlane);
-		glm::vec3 eye = lightsP[i]->getPosition();
-		std::array<glm::mat4, 6> lightSpaceMatrices = {
-			lightProjection * glm::lookAt(eye, eye + glm::vec3{+1.0f, 0.0f, 0.0f}, glm::vec3{0.0f, -1.0f, 0.0f}),
-			lightProjection * glm::lookAt(eye, eye + glm::vec3{-1.0f, 0.0f, 0.0f}, glm::vec3{0.0f, -1.0f, 0.0f}),
-			lightProjection * glm::lookAt(eye, eye + glm::vec3{0.0f, +1.0f, 0.0f}, glm::vec3{0.0f, 0.0f, +1.0f}),
-			lightProjection * glm::lookAt(eye, eye + glm::vec3{0.0f, -1.0f, 0.0f}, glm::vec3{0.0f, 0.0f, -1.0f}),
-			lightProjection * glm::lookAt(eye, eye + glm::vec3{0.0f, 0.0f, +1.0f}, glm::vec3{0.0f, -1.0f, 0.0f}),
-			lightProjection * glm::lookAt(eye, eye + glm::vec3{0.0f, 0.0f, -1.0f}, glm::vec3{0.0f, -1.0f, 0.0f})
-		};
-		ShaderManager::shadowMappingOmnidirectional()->use();
-		ShaderManager::shadowMappingOmnidirectional()->set("lightPos", eye);
-		ShaderManager::shadowMappingOmnidirectional()->set("farPlane", farPlane);
-		for(int i = 0; i < 6; i++)
-			ShaderManager::shadowMappingOmnidirectional()->set(
-			"lightSpaces[" + std::to_string(i) + "]", lightSpaceMatrices[i]);
-		renderProps(ShaderManager::shadowMappingOmnidirectional());
-		shading.current->use();
-		shading.current->set("shadowMappingOmniFarPlane", farPlane);
-		shading.current->set("pointLights[" + std::to_string(enabledPointLights++) + "].shadowMap",
-			10 + i + enabledDirectionalLights + enabledSpotLights);
-		shadowMapsP[i].use(10 + i + enabledDirectionalLights + enabledSpotLights);
-	}
+	RenderContext& context = scene->getRenderContext();
+	int const firstCascade = context.updateShadows(info::frame, *camera, shading.lighting.clusters.getAttenuationCutoff(),
+		[&](Shader* shader, std::vector<Prop*> const& props){
+		renderDepth(shader, props);
+	});
+	ShadowAtlas& atlas = context.getShadowAtlas();
+	atlas.setDepthComparison(shading.lighting.shadows.depthComparison);
+	atlas.use(16, 17);
+	shading.current->use();
 
 	glViewport(0, 0, viewport.width, viewport.height);
 	configureFramebuffers();
 	configureFaceCulling();
+	return firstCascade;
 }
 
 void Renderer::configureShaders() const
@@ -381,21 +301,34 @@ void Renderer::configureShaders() const
 
 		shading.current->set("ambientColor", scene->getBackground());
 		shading.current->set("ambientStrength", shading.lighting.ambientStrength);
-		auto useLights = [&](auto const& lights, std::string const& prefix1, std::string const& prefix2){
+		auto useLights = [&](auto const& lights, Shader::UniformArray<Light::Uniforms> const& elements, Shader::Uniform<int> const& count){
 			int enabledLights = 0;
-			for(int i = 0; i < lights.size(); i++)
+			for(int i = 0; i < int(lights.size()); i++)
 			{
 				if(!lights[i]->isEnabled() && !lights[i]->isHighlighted())
 					continue;
-				std::string prefix = prefix1 + "[" + std::to_string(enabledLights) + "].";
-				lights[i]->use(prefix, viewMatrix, *(shading.current), highlighting.enabled && lights[i]->isHighlighted());
+				lights[i]->use(elements[enabledLights], viewMatrix, *(shading.current), highlighting.enabled && lights[i]->isHighlighted());
 				enabledLights++;
 			}
-			shading.current->set(prefix2, enabledLights);
+			shading.current->set(count, enabledLights);
 		};
-		useLights(scene->getAll<DirectionalLight>(), "dirLights", "nDirLights");
-		useLights(scene->getAll<PointLight>(), "pointLights", "nPointLights");
-		useLights(scene->getAll<SpotLight>(), "spotLights", "nSpotLights");
+		//shadow maps are drawn before the lights are packed, so lights know where their shadows are
+		int const firstCascade = shading.lighting.shadows.enabled ? renderShadowMaps() : 0;
+		if(shading.current->supportsClusteredLighting())
+		{
+			auto& clusters = shading.lighting.clusters;
+			clusters.update(*scene, *camera, viewport.width, viewport.height,
+				shading.lighting.shadows.enabled ? &scene->getRenderContext().getShadowAtlas() : nullptr, firstCascade, highlighting.enabled);
+			clusters.bind();
+			shading.current->use();
+			shading.current->set(uniforms::nDirLights, clusters.getDirectionalLightCount());
+		}
+		else
+		{
+			useLights(scene->getAll<DirectionalLight>(), uniforms::dirLights, uniforms::nDirLights);
+			useLights(scene->getAll<PointLight>(), uniforms::pointLights, uniforms::nPointLights);
+			useLights(scene->getAll<SpotLight>(), uniforms::spotLights, uniforms::nSpotLights);
+		}
 
 		shading.current->set("shadowMappingEnabled", shading.lighting.shadows.enabled);
 		if(shading.lighting.shadows.enabled)
@@ -417,7 +350,6 @@ void Renderer::configureShaders() const
 				shading.current->set("shadowMappingRadius[1]", shading.lighting.shadows.pcfRadius[1]);
 				shading.current->set("shadowMappingEarlyExit", shading.lighting.shadows.pcfEarlyExit);
 			}
-			renderShadowMaps();
 		}
 	}
 	else if(shading.current == ShaderManager::refraction())
@@ -452,10 +384,8 @@ void Renderer::configureShaders() const
 			ShaderManager::debugNormalsShowLines()->set("viewSpace", shading.debugging.normals.viewSpace);
 			ShaderManager::debugNormalsShowLines()->set("faceNormals", shading.debugging.normals.faceNormals);
 			ShaderManager::debugNormalsShowLines()->set("explodeMagnitude", shading.debugging.normals.explodeMagnitude);
-			for(auto const& prop : scene->getAll<Prop>())
+			for(auto const& prop : scene->getAllEnabled<Prop>())
 			{
-				if(!prop->isEnabled())
-					continue;
 				ShaderManager::debugNormalsShowLines()->set("model", prop->getGlobalTransformation());
 				prop->getMesh().use();
 			}
@@ -476,26 +406,22 @@ void Renderer::renderHighlightedProps() const
 		glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
 		glStencilFunc(GL_ALWAYS, 1, 0xFF);
 	}
-	auto drawProps = [&](){
-		for(auto const& prop : scene->getAll<Prop>())
-		{
-			if(!prop->isHighlighted())
-				continue;
-			ShaderManager::unlit()->set("model", prop->getGlobalTransformation());
-			prop->getMesh().use();
-		}
-	};
+	auto& highlightedProps = instancing.drawn;
+	highlightedProps.clear();
+	for(auto const& prop : scene->getAll<Prop>())
+		if(prop->isHighlighted())
+			highlightedProps.push_back(prop);
 	ShaderManager::unlit()->use();
 	if(geometry.prop.mode != geometry.lines)
 	{
 		ShaderManager::unlit()->set("material.color", highlighting.color);
-		drawProps();
+		drawProps(ShaderManager::unlit(), highlightedProps, RenderQueue::Pass::highlight, false);
 	}
 	if(geometry.prop.mode != geometry.triangles)
 	{
 		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 		ShaderManager::unlit()->set("material.color", glm::vec3{1.0f - highlighting.color});
-		drawProps();
+		drawProps(ShaderManager::unlit(), highlightedProps, RenderQueue::Pass::highlight, false);
 		configurePolygonMode();
 	}
 	if(highlighting.overlay)
@@ -505,28 +431,105 @@ void Renderer::renderHighlightedProps() const
 	}
 }
 
-void Renderer::renderProps(Shader* shader) const
+void Renderer::cullProps() const
 {
+	auto const& enabledProps = scene->getAllEnabled<Prop>();
+	glm::mat4 const viewProjection = camera->getProjectionMatrix() * camera->getViewMatrix();
+	culling.visibleProps.clear();
+	if(culling.frustum)
+	{
+		Frustum const frustum{viewProjection};
+		scene->getBoundingVolumes().query(frustum, [&](Prop* prop){
+			if(prop->isEnabled())
+				culling.visibleProps.push_back(prop);
+		});
+	}
+	else
+	{
+		culling.visibleProps = enabledProps;
+	}
+	culling.culledProps = int(enabledProps.size() - culling.visibleProps.size());
+	culling.occludedProps = 0;
+	if(culling.occlusion)
+		cullOccludedProps(viewProjection);
+	profiler::counters::visibleProps.increment(int(culling.visibleProps.size()));
+	profiler::counters::culledProps.increment(culling.culledProps);
+	profiler::counters::occludedProps.increment(culling.occludedProps);
+}
+
+void Renderer::cullOccludedProps(glm::mat4 const& viewProjection) const
+{
+	auto const start = std::chrono::steady_clock::now();
+	glm::vec3 const cameraPosition = camera->getGlobalTransformation()[3];
+
+	//props with cpu geometry covering the largest solid angle make the best occluders
+	culling.occluders.clear();
+	for(auto prop : culling.visibleProps)
+	{
+		if(!prop->getMesh().getOccluderGeometry())
+			continue;
+		auto[min, max] = prop->getOwnBounds().getValues();
+		glm::vec3 const center = (min + max) * 0.5f;
+		glm::vec3 const extent = (max - min) * 0.5f;
+		float const distance = std::max(glm::dot(center - cameraPosition, center - cameraPosition), 1e-4f);
+		float const size = glm::dot(extent, extent) / distance;
+		if(size >= culling.minOccluderSize)
+			culling.occluders.emplace_back(size, prop);
+	}
+	int const occluderCount = std::min(culling.maxOccluders, int(culling.occluders.size()));
+	std::partial_sort(culling.occluders.begin(), culling.occluders.begin() + occluderCount, culling.occluders.end(),
+		[](auto const& lhs, auto const& rhs){
+		return lhs.first > rhs.first;
+	});
+	culling.occluders.resize(occluderCount);
+
+	culling.occlusionCuller.begin(viewProjection);
+	for(auto[size, occluder] : culling.occluders)
+	{
+		auto const geometry = occluder->getMesh().getOccluderGeometry();
+		culling.occlusionCuller.rasterize(geometry->positions, geometry->indices, occluder->getGlobalTransformation());
+	}
+	culling.occlusionCuller.finish();
+
+	auto const isOccluder = [&](Prop* prop){
+		return std::any_of(culling.occluders.begin(), culling.occluders.end(), [&](auto const& occluder){
+			return occluder.second == prop;
+		});
+	};
+	auto const occluded = std::remove_if(culling.visibleProps.begin(), culling.visibleProps.end(), [&](Prop* prop){
+		if(isOccluder(prop))
+			return false;
+		auto[min, max] = prop->getOwnBounds().getValues();
+		return !culling.occlusionCuller.isVisible(min, max);
+	});
+	culling.occludedProps = int(culling.visibleProps.end() - occluded);
+	culling.visibleProps.erase(occluded, culling.visibleProps.end());
+	culling.occlusionTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Renderer::renderProps(Shader* shader, std::vector<Prop*> const& props) const
+{
+	//highlighted props are drawn by renderHighlightedProps
+	std::vector<Prop*> const* drawn = &props;
+	if(highlighting.enabled)
+	{
+		instancing.drawn.clear();
+		for(auto prop : props)
+			if(!prop->isHighlighted())
+				instancing.drawn.push_back(prop);
+		drawn = &instancing.drawn;
+	}
 	shader->use();
 	if(geometry.prop.mode != geometry.lines)
 	{
-		for(auto const& prop : scene->getAll<Prop>())
+		if(shader == ShaderManager::unlit())
 		{
-			if((!highlighting.enabled || !prop->isHighlighted()) && prop->isEnabled())
-			{
-				shader->set("model", prop->getGlobalTransformation());
-				if(shader == ShaderManager::unlit())
-				{
-					shader->set("material.r", shading.debugging.unlitShowRedChannel);
-					shader->set("material.g", shading.debugging.unlitShowGreenChannel);
-					shader->set("material.b", shading.debugging.unlitShowBlueChannel);
-					shader->set("material.a", shading.debugging.unlitShowAlphaChannel);
-				}
-				prop->getMaterial()->use(shader, shading.debugging.unlitMap);
-				//shader->validate();
-				prop->getMesh().use();
-			}
+			shader->set("material.r", shading.debugging.unlitShowRedChannel);
+			shader->set("material.g", shading.debugging.unlitShowGreenChannel);
+			shader->set("material.b", shading.debugging.unlitShowBlueChannel);
+			shader->set("material.a", shading.debugging.unlitShowAlphaChannel);
 		}
+		drawProps(shader, *drawn, RenderQueue::Pass::opaque, true);
 	}
 
 	if(geometry.prop.mode != geometry.triangles)
@@ -535,17 +538,149 @@ void Renderer::renderProps(Shader* shader) const
 		ShaderManager::unlit()->use();
 		ShaderManager::unlit()->set("material.hasMap", false);
 		ShaderManager::unlit()->set("material.color", glm::vec3(0.0f));
+		drawProps(ShaderManager::unlit(), *drawn, RenderQueue::Pass::wireframe, false);
+		configurePolygonMode();
+	}
+}
+
+void Renderer::renderDepth(Shader* shader, std::vector<Prop*> const& props) const
+{
+	shader->use();
+	drawProps(shader, props, RenderQueue::Pass::shadow, false);
+}
 
-		for(auto const& prop : scene->getAll<Prop>())
+void Renderer::drawProps(Shader* shader, std::vector<Prop*> const& props, RenderQueue::Pass pass, bool useMaterials) const
+{
+	if(props.empty())
+		return;
+	for(int i = 0; i < int(props.size()); i++)
+	{
+		bool const sameMaterial = i > 0 && props[i]->getMaterial() == props[i - 1]->getMaterial();
+		bool const sameMesh = i > 0 && &props[i]->getMesh() == &props[i - 1]->getMesh();
+		stateChanges.unsortedMaterialBinds += useMaterials;
+		stateChanges.unsortedRedundantMaterialBinds += useMaterials && sameMaterial;
+		stateChanges.unsortedMeshSwitches += !sameMesh;
+	}
+	auto& sorted = instancing.sorted;
+	//depth only passes are drawn from the lights, whose distances to the props the camera knows nothing about,
+	//a range of 0 leaves their keys without depth, so they are only ordered by state
+	float const depthRange = pass == RenderQueue::Pass::shadow ? 0.0f : camera->getFarPlane();
+	scene->getRenderQueue().sort(props, pass, shader, useMaterials, camera->getPosition(), depthRange, sorted);
+
+	//shaders that read the instance buffer get their per draw data written straight into the frame's ring buffer region,
+	//every draw then only passes its first instance, the model uniform is left for the others,
+	//depth only passes skip the normal matrices, their shaders read the model matrices alone
+	bool const perDrawData = shader->supportsInstancing();
+	bool const batched = perDrawData && instancing.enabled;
+	bool const positionsOnly = pass == RenderQueue::Pass::shadow;
+	if(perDrawData)
+	{
+		RingBuffer::Allocation allocation;
+		if(positionsOnly)
 		{
-			if((!highlighting.enabled || !prop->isHighlighted()) && prop->isEnabled())
+			allocation = frameData.allocateStorage(sorted.size() * sizeof(glm::mat4));
+			glm::mat4* models = static_cast<glm::mat4*>(allocation.data);
+			for(int i = 0; i < int(sorted.size()); i++)
+				models[i] = sorted[i]->getGlobalTransformation();
+		}
+		else
+		{
+			allocation = frameData.allocateStorage(sorted.size() * sizeof(Instance));
+			Instance* instances = static_cast<Instance*>(allocation.data);
+			glm::mat4 const view = camera->getViewMatrix();
+			for(int i = 0; i < int(sorted.size()); i++)
 			{
-				ShaderManager::unlit()->set("model", prop->getGlobalTransformation());
-				prop->getMesh().use();
+				glm::mat4 const& model = sorted[i]->getGlobalTransformation();
+				instances[i] = {model, glm::transpose(glm::inverse(view * model))};
 			}
 		}
-		configurePolygonMode();
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, allocation.buffer, allocation.offset, allocation.size);
+		shader->set(uniforms::instanced, true);
+	}
+	auto const compatible = [&](Prop const* lhs, Prop const* rhs){
+		return &lhs->getMesh() == &rhs->getMesh() && (!useMaterials || lhs->getMaterial() == rhs->getMaterial());
+	};
+	//the draws of every batch become commands, consecutive ones sharing a material and pool are submitted together
+	bool const multiDraw = batched && instancing.multiDrawIndirect;
+	RingBuffer::Allocation commands;
+	if(multiDraw)
+	{
+		commands = frameData.allocateIndirect(sorted.size() * MeshArena::commandStride);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands.buffer);
+	}
+	MeshArena& arena = MeshArena::shared();
+	int pendingPool = -1;
+	GLenum pendingDrawMode = 0;
+	int firstCommand = 0;
+	int commandCount = 0;
+	Material const* boundMaterial = nullptr;
+	Mesh const* boundMesh = nullptr;
+	int drawCalls = 0;
+	auto const submit = [&](){
+		if(!commandCount)
+			return;
+		arena.multiDraw(pendingPool, pendingDrawMode, commands.offset + firstCommand * MeshArena::commandStride, commandCount, positionsOnly);
+		instancing.indirectCommands += commandCount;
+		firstCommand += commandCount;
+		commandCount = 0;
+		drawCalls++;
+	};
+	for(int begin = 0, end; begin < int(sorted.size()); begin = end)
+	{
+		end = begin + 1;
+		if(batched)
+			for(; end < int(sorted.size()) && compatible(sorted[begin], sorted[end]); end++);
+		Prop const* prop = sorted[begin];
+		Mesh const& mesh = prop->getMesh();
+		bool const materialChanged = useMaterials && prop->getMaterial() != boundMaterial;
+		if(multiDraw && (materialChanged || mesh.getArenaRange().pool != pendingPool || mesh.getDrawMode() != pendingDrawMode))
+		{
+			submit();
+			pendingPool = mesh.getArenaRange().pool;
+			pendingDrawMode = mesh.getDrawMode();
+		}
+		if(useMaterials)
+		{
+			if(materialChanged)
+			{
+				boundMaterial = prop->getMaterial();
+				boundMaterial->use(shader, shading.debugging.unlitMap);
+				stateChanges.materialBinds++;
+			}
+			else
+			{
+				stateChanges.skippedMaterialBinds++;
+			}
+		}
+		if(&mesh != boundMesh)
+		{
+			boundMesh = &mesh;
+			stateChanges.meshSwitches++;
+		}
+		if(multiDraw)
+		{
+			std::byte* command = static_cast<std::byte*>(commands.data) + (firstCommand + commandCount) * MeshArena::commandStride;
+			arena.writeCommand(command, mesh.getArenaRange(), end - begin, begin);
+			commandCount++;
+			continue;
+		}
+		if(perDrawData)
+		{
+			boundMesh->use(end - begin, begin, positionsOnly);
+		}
+		else
+		{
+			shader->set(uniforms::model, prop->getGlobalTransformation());
+			boundMesh->use(1, 0, positionsOnly);
+		}
+		drawCalls++;
 	}
+	if(multiDraw)
+		submit();
+	if(perDrawData)
+		shader->set(uniforms::instanced, false);
+	instancing.drawCalls += drawCalls;
+	profiler::counters::drawCalls.increment(drawCalls);
 }
 
 void Renderer::renderSkybox() const
@@ -604,6 +739,7 @@ void Renderer::resizeViewport(int width, int height)
 	viewport.width = width;
 	viewport.height = height;
 	updateFramebuffers();
+	shouldRender();
 }
 
 void Renderer::setCamera(Camera* camera)
@@ -612,8 +748,6 @@ void Renderer::setCamera(Camera* camera)
 	if(!camera)
 		return;
 	scene = camera->getScene();
-	shading.lighting.shadows.showMap = -1;
-	updateShadowMaps();
 	shouldRender();
 }
 
@@ -631,6 +765,11 @@ void Renderer::render()
 {
 	if(skipFrame())
 		return;
+	frameData.beginFrame();
+	instancing.drawCalls = 0;
+	instancing.indirectCommands = 0;
+	stateChanges = {};
+	scene->updateTransformations();
 	configureFramebuffers();
 	configureDepthTesting();
 	configureFaceCulling();
@@ -640,13 +779,15 @@ void Renderer::render()
 	renderAuxiliaryGeometry();
 	renderLights();
 
+	cullProps();
 	configureShaders();
 	renderHighlightedProps();
-	renderProps(shading.current);
+	renderProps(shading.current, culling.visibleProps);
 
 	renderSkybox();
 
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	frameData.endFrame();
 }
 
 unsigned int Renderer::getOutput()
@@ -662,13 +803,16 @@ unsigned int Renderer::getOutput()
 
 void Renderer::drawUI(bool* open)
 {
+	//edits made anywhere in the UI might not be timestamped
+	if(ImGui::IsAnyItemActive())
+		_shouldRender = true;
 	if(!*open)
 		return;
 	ImGui::Begin(getName().data(), open, ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoScrollbar);
 	ImGui::Image(ImTextureID(getOutput()), ImVec2(512, 512 / viewport.aspect()), ImVec2(0, 1), ImVec2(1, 0));
 	ImGui::NewLine();
 	ImGui::Columns(2, nullptr, true);
-	ImGui::Checkbox("Explicit Rendering", &explicitRendering);
+	ImGui::Checkbox("Skip Unchanged Frames", &skipUnchangedFrames);
 	ImGui::NextColumn();
 	ImGui::AlignTextToFramePadding();
 	ImGui::Text("Camera");
@@ -709,6 +853,44 @@ void Renderer::drawUI(bool* open)
 	ImGui::Checkbox("Bounding Box", &highlighting.boundingBox);
 
 	ImGui::NewLine();
+	if(ImGui::CollapsingHeader("Culling"))
+	{
+		ImGui::Checkbox("Frustum Culling", &culling.frustum);
+		ImGui::Text("Visible Props: %i", int(culling.visibleProps.size()));
+		ImGui::Text("Culled Props: %i", culling.culledProps);
+		ImGui::Checkbox("Occlusion Culling", &culling.occlusion);
+		if(culling.occlusion)
+		{
+			ImGui::SliderInt("Max Occluders", &culling.maxOccluders, 1, 64);
+			ImGui::SliderFloat("Min Occluder Size", &culling.minOccluderSize, 0.0f, 1.0f, "%.3f", 2.0f);
+			int resolution[2] = {culling.occlusionCuller.getWidth(), culling.occlusionCuller.getHeight()};
+			if(ImGui::InputInt2("Depth Buffer", resolution, ImGuiInputTextFlags_EnterReturnsTrue))
+				culling.occlusionCuller.resize(std::clamp(resolution[0], 4, 2048), std::clamp(resolution[1], 1, 2048));
+			ImGui::Text("Occluders: %i (%i triangles)", int(culling.occluders.size()), culling.occlusionCuller.getRasterizedTriangles());
+			ImGui::Text("Occluded Props: %i", culling.occludedProps);
+			ImGui::Text("Occlusion Culling: %.3f ms", culling.occlusionTime);
+		}
+	}
+	if(ImGui::CollapsingHeader("Instancing"))
+	{
+		ImGui::Checkbox("Enabled", &instancing.enabled);
+		ImGui::Checkbox("Multi Draw Indirect", &instancing.multiDrawIndirect);
+		ImGui::Text("Prop Draw Calls: %i", instancing.drawCalls);
+		if(instancing.enabled && instancing.multiDrawIndirect)
+			ImGui::Text("Indirect Commands: %i", instancing.indirectCommands);
+		if(!shading.current->supportsInstancing())
+			ImGui::Text("The current shader draws props one at a time");
+	}
+	if(ImGui::CollapsingHeader("Mesh Arena"))
+		MeshArena::shared().drawUI();
+	if(ImGui::CollapsingHeader("Frame Data"))
+		frameData.drawUI();
+	if(ImGui::CollapsingHeader("Render Queue"))
+	{
+		ImGui::Text("Material Binds: %i (%i skipped)", stateChanges.materialBinds, stateChanges.skippedMaterialBinds);
+		ImGui::Text("Unsorted: %i (%i redundant)", stateChanges.unsortedMaterialBinds, stateChanges.unsortedRedundantMaterialBinds);
+		ImGui::Text("Mesh Switches: %i (unsorted: %i)", stateChanges.meshSwitches, stateChanges.unsortedMeshSwitches);
+	}
 	if(ImGui::CollapsingHeader("Geometry"))
 	{
 		ImGui::AlignTextToFramePadding();
@@ -834,120 +1016,18 @@ void Renderer::drawUI(bool* open)
 			ImGui::SameLine();
 			ImGui::PushItemWidth(-1);
 			ImGui::SliderFloat("###Ambient Strength", &shading.lighting.ambientStrength, 0.0f, 1.0f);
+			ImGui::PopItemWidth();
+			if(shading.current->supportsClusteredLighting() && ImGui::TreeNode("Light Clusters"))
+			{
+				shading.lighting.clusters.drawUI();
+				ImGui::TreePop();
+			}
+			ImGui::PushItemWidth(-1);
 			ImGui::Checkbox("Shadow Mapping", &shading.lighting.shadows.enabled);
 			if(shading.lighting.shadows.enabled)
 			{
 				auto& shadows = shading.lighting.shadows;
-				ImGui::Text("Shadow Map Generation ");
-				ImGui::Checkbox("Face Culling", &shadows.faceCulling);
-				if(shadows.faceCulling)
-				{
-					ImGui::SameLine();
-					chooseGLEnumFromCombo(shadows.faceCullingMode, {
-						GL_FRONT_AND_BACK, GL_FRONT, GL_BACK
-					});
-				}
-				ImGui::AlignTextToFramePadding();
-				ImGui::Text("Resolution Exponent");
-				ImGui::SameLine();
-				ImGui::BeginGroup();
-				ImGui::InputInt("###Resolution", &shadows.resolution, 1);
-				if(shadows.resolution < 1)
-					shadows.resolution = 1;
-				ImGui::EndGroup();
-				if(ImGui::IsItemActive() || ImGui::IsItemDeactivatedAfterChange())
-					updateShadowMaps();
-				ImGui::AlignTextToFramePadding();
-				ImGui::Text("Directional Light Projection Size");
-				ImGui::SameLine();
-				ImGui::InputFloat("###directionalLightProjectionSize", &shadows.directionalLightProjectionSize, 0.1f, 1.0f);
-				ImGui::AlignTextToFramePadding();
-				ImGui::Text("Spotlight Near Plane");
-				ImGui::SameLine();
-				ImGui::InputFloat("###spotlightnearplane", &shadows.spotLightNearPlane, 0.01f, 1.0f);
-				ImGui::AlignTextToFramePadding();
-				ImGui::Text("Spotlight Far Plane");
-				ImGui::SameLine();
-				ImGui::InputFloat("###spotlightfarplane", &shadows.spotLightFarPlane, 1.0f, 5.0f);
-				ImGui::AlignTextToFramePadding();
-				ImGui::Text("Pointlight Near Plane");
-				ImGui::SameLine();
-				ImGui::InputFloat("###pointlightnearplane", &shadows.pointLightNearPlane, 0.01f, 1.0f);
-				ImGui::AlignTextToFramePadding();
-				ImGui::Text("Pointlight Far Plane");
-				ImGui::SameLine();
-				ImGui::InputFloat("###pointlightfarplane", &shadows.pointLightFarPlane, 1.0f, 5.0f);
-				std::string currentShadowMapName = "None";
-				auto& lightsD = scene->getAll<DirectionalLight>();
-				auto& lightsS = scene->getAll<SpotLight>();
-				auto& lightsP = scene->getAll<PointLight>();
-				int& showMap = shadows.showMap;
-				if(showMap > -1)
-				{
-					if(showMap < lightsD.size())
-						currentShadowMapName = lightsD[showMap]->getName();
-					else if(showMap < lightsD.size() + lightsS.size())
-						currentShadowMapName = lightsS[showMap - lightsD.size()]->getName();
-					else
-						currentShadowMapName = lightsP[showMap - lightsD.size() - lightsS.size()]->getName();
-				}
-				ImGui::AlignTextToFramePadding();
-				ImGui::Text("View Shadow Map");
-				ImGui::SameLine();
-				if(ImGui::BeginCombo("###ViewShadowMap", currentShadowMapName.data()))
-				{
-					bool isSelected = showMap == -1;
-					if(ImGui::Selectable("None", &isSelected))
-						showMap = -1;
-					if(isSelected)
-						ImGui::SetItemDefaultFocus();
-					ImGui::Separator();
-					int id = 0;
-					for(int i = 0; i < lightsD.size(); i++)
-					{
-						ImGui::PushID(id++);
-						isSelected = showMap == i;
-						if(ImGui::Selectable(lightsD[i]->getName().data(), &isSelected))
-							showMap = i;
-						if(isSelected)
-							ImGui::SetItemDefaultFocus();
-						ImGui::PopID();
-					}
-					ImGui::Separator();
-					int offset = lightsD.size();
-					for(int i = 0; i < lightsS.size(); i++)
-					{
-						ImGui::PushID(id++);
-						isSelected = showMap == offset + i;
-						if(ImGui::Selectable(lightsS[i]->getName().data(), &isSelected))
-							showMap = offset + i;
-						if(isSelected)
-							ImGui::SetItemDefaultFocus();
-						ImGui::PopID();
-					}
-					ImGui::Separator();
-					offset += lightsS.size();
-					for(int i = 0; i < lightsP.size(); i++)
-					{
-						ImGui::PushID(id++);
-						isSelected = showMap == offset + i;
-						if(ImGui::Selectable(lightsP[i]->getName().data(), &isSelected))
-							showMap = offset + i;
-						if(isSelected)
-							ImGui::SetItemDefaultFocus();
-						ImGui::PopID();
-					}
-					ImGui::EndCombo();
-				}
-				if(showMap > -1)
-				{
-					if(showMap < lightsD.size())
-						shadows.shadowMapsD[showMap].drawUI();
-					else if(showMap < lightsD.size() + lightsS.size())
-						shadows.shadowMapsS[showMap - lightsD.size()].drawUI();
-					else
-						shadows.shadowMapsP[showMap - lightsD.size() - lightsS.size()].drawUI();
-				}
+				scene->getRenderContext().drawUI();
 				ImGui::Separator();
 				ImGui::Text("Shadow Map Sampling");
 				ImGui::AlignTextToFramePadding();
@@ -1077,8 +1157,6 @@ void Renderer::drawUI(bool* open)
 			}
 		}
 	}
-	if(ImGui::IsAnyItemActive())
-		_shouldRender = true;
 	ImGui::Text("Status: ");
 	ImGui::SameLine();
 	if(_shouldRender)
@@ -7,6 +7,7 @@
 #include "SceneManager.h"
 #include "Globals.h"
 #include "FileSelector.h"
+#include "SceneSnapshot.h"
 
 #include <glad/glad.h>
 #include <imgui.h>
@@ -199,6 +200,18 @@ void drawResourcesUI(bool* open)
 			}
 		}
 		ImGui::SameLine();
+		if(ImGui::SmallButton("Load Snapshot"))
+		{
+			if(!browser && !importCallback)
+			{
+				browser = new FileSelector({SceneSnapshot::extension});
+				importCallback = [](std::filesystem::path file){
+					if(auto scene = SceneManager::loadSnapshot(file.string()); scene && !scene->getAll<Camera>().empty())
+						settings::mainRenderer().setCamera(scene->getAll<Camera>().front());
+				};
+			}
+		}
+		ImGui::SameLine();
 		if(ImGui::SmallButton("New"))
 			SceneManager::add(std::make_unique<Scene>());
 	});
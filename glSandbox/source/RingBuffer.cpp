@@ -0,0 +1,112 @@
+#include "RingBuffer.h"
+
+#include <imgui.h>
+#include <algorithm>
+
+RingBuffer::RingBuffer(GLsizeiptr regionSize)
+{
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+	createStorage(regionSize);
+}
+
+RingBuffer::~RingBuffer()
+{
+	releaseFences();
+	glDeleteBuffers(1, &buffer);
+	if(!retired.empty())
+		glDeleteBuffers(GLsizei(retired.size()), retired.data());
+}
+
+void RingBuffer::createStorage(GLsizeiptr regionSize)
+{
+	this->regionSize = regionSize;
+	GLbitfield const flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &buffer);
+	glNamedBufferStorage(buffer, regionSize * frames, nullptr, flags);
+	mapping = static_cast<std::byte*>(glMapNamedBufferRange(buffer, 0, regionSize * frames, flags));
+}
+
+void RingBuffer::releaseFences()
+{
+	for(auto& fence : fences)
+	{
+		if(fence)
+			glDeleteSync(fence);
+		fence = nullptr;
+	}
+}
+
+RingBuffer::Allocation RingBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment)
+{
+	GLsizeiptr offset = (head + alignment - 1) / alignment * alignment;
+	if(offset + size > regionSize)
+	{
+		//the old buffer may still be bound and read later this frame, so it is only deleted once the frame is submitted
+		retired.push_back(buffer);
+		releaseFences();
+		GLsizeiptr newSize = regionSize * 2;
+		while(newSize < size)
+			newSize *= 2;
+		createStorage(newSize);
+		region = 0;
+		offset = 0;
+		stats.growths++;
+	}
+	head = offset + size;
+	stats.used = std::max(stats.used, head);
+	GLintptr const start = region * regionSize + offset;
+	return {mapping + start, buffer, start, size};
+}
+
+void RingBuffer::beginFrame()
+{
+	region = (region + 1) % frames;
+	head = 0;
+	stats.used = 0;
+	GLsync& fence = fences[region];
+	if(!fence)
+		return;
+	//only blocks when the gpu is more than frames - 1 frames behind
+	GLenum const result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	if(result == GL_TIMEOUT_EXPIRED)
+	{
+		stats.waits++;
+		while(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000) == GL_TIMEOUT_EXPIRED);
+	}
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+void RingBuffer::endFrame()
+{
+	fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	if(!retired.empty())
+	{
+		glDeleteBuffers(GLsizei(retired.size()), retired.data());
+		retired.clear();
+	}
+}
+
+RingBuffer::Allocation RingBuffer::allocateUniform(GLsizeiptr size)
+{
+	return allocate(size, uniformAlignment);
+}
+
+RingBuffer::Allocation RingBuffer::allocateStorage(GLsizeiptr size)
+{
+	return allocate(size, storageAlignment);
+}
+
+RingBuffer::Allocation RingBuffer::allocateIndirect(GLsizeiptr size)
+{
+	return allocate(size, sizeof(GLuint));
+}
+
+void RingBuffer::drawUI()
+{
+	ImGui::Text("Region Size: %.2f KB x %i", regionSize / 1024.0f, frames);
+	ImGui::Text("Used Last Frame: %.2f KB", stats.used / 1024.0f);
+	ImGui::Text("Fence Waits: %i", stats.waits);
+	ImGui::Text("Growths: %i", stats.growths);
+}
@@ -4,6 +4,11 @@
 #include "Util.h"
 #include "CubemapManager.h"
 #include "MeshManager.h"
+#include "ThreadPool.h"
+#include "NodePool.h"
+#include "SceneSnapshot.h"
+#include "TriangleBVH.h"
+#include "RenderContext.h"
 
 #include <imgui.h>
 #include <set>
@@ -20,12 +25,23 @@ Scene::Scene(Scene &&other)
 {
 	root->setScene(this);
 }
-Scene::Scene(std::unique_ptr<Node>&& root)
+Scene::Scene(std::unique_ptr<Node>&& root, bool prepare)
 	:root(std::move(root))
 {
 	this->root->setScene(this);
-	fitToIdealSize();
-	addDefaultNodes();
+	if(prepare)
+	{
+		fitToIdealSize();
+		addDefaultNodes();
+	}
+}
+
+Scene::~Scene()
+{
+	renderContext.reset();
+	//the whole tree goes at once, so the slabs it emptied can be handed back
+	root.reset();
+	NodePool::trim();
 }
 
 void Scene::addDefaultNodes()
@@ -48,30 +64,88 @@ void Scene::addDefaultNodes()
 
 void Scene::updateCache() const
 {
-	cache.transformedNodes.clear();
-	cache.cameras.clear();
-	cache.props.clear();
-	cache.directionalLights.clear();
-	cache.pointLights.clear();
-	cache.spotLights.clear();
-	for(auto& node : root->getChildren())
+	cache.transformHierarchy.rebuild(root.get());
+	cache.transformationsOutdated = true;
+	cache.dirty = false;
+}
+
+template<typename Callable>
+static void visitTyped(Node* node, Callable&& operation)
+{
+	switch(node->getType())
 	{
-		node.get()->recursive([&](Node* node){
-			if(auto prop = dynamic_cast<Prop*>(node); prop)
-				cache.props.push_back(prop);
-			else if(auto camera = dynamic_cast<Camera*>(node); camera)
-				cache.cameras.push_back(camera);
-			else if(auto transformedNode = dynamic_cast<TransformedNode*>(node); transformedNode)
-				cache.transformedNodes.push_back(transformedNode);
-			else if(auto light = dynamic_cast<DirectionalLight*>(node); light)
-				cache.directionalLights.push_back(light);
-			else if(auto light = dynamic_cast<PointLight*>(node); light)
-				cache.pointLights.push_back(light);
-			else if(auto light = dynamic_cast<SpotLight*>(node); light)
-				cache.spotLights.push_back(light);
-		});
+		case NodeType::transformedNode:
+			operation(static_cast<TransformedNode*>(node));
+			break;
+		case NodeType::camera:
+			operation(static_cast<Camera*>(node));
+			break;
+		case NodeType::prop:
+			operation(static_cast<Prop*>(node));
+			break;
+		case NodeType::directionalLight:
+			operation(static_cast<DirectionalLight*>(node));
+			break;
+		case NodeType::pointLight:
+			operation(static_cast<PointLight*>(node));
+			break;
+		case NodeType::spotLight:
+			operation(static_cast<SpotLight*>(node));
+			break;
 	}
-	cache.dirty = false;
+}
+
+static bool isLight(Node* node)
+{
+	return node->getType() == NodeType::directionalLight ||
+		node->getType() == NodeType::pointLight ||
+		node->getType() == NodeType::spotLight;
+}
+
+void Scene::registerNode(Node* node)
+{
+	visitTyped(node, [&](auto typedNode){
+		auto& registry = getRegistry<std::remove_pointer_t<decltype(typedNode)>>();
+		node->registryIndex = int(registry.all.size());
+		registry.all.push_back(typedNode);
+		registry.enabledOutdated = true;
+	});
+	if(isLight(node))
+		lightsOutdated = true;
+	else if(node->getType() == NodeType::prop)
+	{
+		boundingVolumes.insert(static_cast<Prop*>(node));
+		renderQueue.insert(static_cast<Prop*>(node));
+	}
+}
+
+void Scene::unregisterNode(Node* node)
+{
+	visitTyped(node, [&](auto typedNode){
+		auto& registry = getRegistry<std::remove_pointer_t<decltype(typedNode)>>();
+		int const idx = node->registryIndex;
+		registry.all[idx] = registry.all.back();
+		registry.all[idx]->registryIndex = idx;
+		registry.all.pop_back();
+		registry.enabledOutdated = true;
+		node->registryIndex = -1;
+	});
+	if(isLight(node))
+		lightsOutdated = true;
+	else if(node->getType() == NodeType::prop)
+	{
+		boundingVolumes.remove(static_cast<Prop*>(node));
+		renderQueue.remove(static_cast<Prop*>(node));
+	}
+}
+
+void Scene::enabledOutdated(Node* node) const
+{
+	visitTyped(node, [&](auto typedNode){
+		getRegistry<std::remove_pointer_t<decltype(typedNode)>>().enabledOutdated = true;
+	});
+	if(isLight(node))
+		getRegistry<Light>().enabledOutdated = true;
 }
 
 std::string Scene::getNamePrefix() const
@@ -84,6 +158,56 @@ void Scene::cacheOutdated() const
 	cache.dirty = true;
 }
 
+void Scene::transformationsOutdated() const
+{
+	cache.transformationsOutdated = true;
+}
+
+void Scene::updateTransformations() const
+{
+	if(cache.dirty)
+		updateCache();
+	if(!useTransformHierarchy || !cache.transformationsOutdated)
+		return;
+	if(parallelTransformations)
+		cache.transformHierarchy.update(ThreadPool::shared());
+	else
+		cache.transformHierarchy.update();
+	cache.transformationsOutdated = false;
+}
+
+void Scene::boundsOutdated(Node* node) const
+{
+	if(node->getType() == NodeType::prop)
+		boundingVolumes.outdated(static_cast<Prop*>(node));
+}
+
+BoundingVolumeHierarchy const& Scene::getBoundingVolumes() const
+{
+	updateTransformations();
+	boundingVolumes.refit();
+	return boundingVolumes;
+}
+
+void Scene::renderStateOutdated(Node* node) const
+{
+	if(node->getType() == NodeType::prop)
+		renderQueue.outdated(static_cast<Prop*>(node));
+}
+
+RenderQueue const& Scene::getRenderQueue() const
+{
+	renderQueue.update();
+	return renderQueue;
+}
+
+RenderContext& Scene::getRenderContext() const
+{
+	if(!renderContext)
+		renderContext = std::make_unique<RenderContext>(*this);
+	return *renderContext;
+}
+
 Node* Scene::getRoot() const
 {
 	return root.get();
@@ -94,6 +218,11 @@ Node * Scene::getCurrent() const
 	return current;
 }
 
+void Scene::setCurrent(Node* node)
+{
+	current = node;
+}
+
 bool Scene::usesSkybox() const
 {
 	return useSkybox && skybox != nullptr;
@@ -109,9 +238,33 @@ Cubemap const* Scene::getSkyBox() const
 	return skybox;
 }
 
+std::optional<Scene::RaycastHit> Scene::raycast(glm::vec3 const& origin, glm::vec3 const& direction, float maxDistance) const
+{
+	std::optional<RaycastHit> ret;
+	Ray const ray{origin, glm::normalize(direction)};
+	getBoundingVolumes().raycast(ray, maxDistance, [&](Prop* prop, float){
+		if(!prop->isEnabled())
+			return maxDistance;
+		TriangleBVH const* triangles = prop->getMesh().getTriangleBVH();
+		if(!triangles)
+			return maxDistance;
+		//the local direction is left unnormalized so distances stay in world units
+		glm::mat4 const inverse = glm::inverse(prop->getGlobalTransformation());
+		Ray const localRay{glm::vec3{inverse * glm::vec4{ray.origin, 1.0f}}, glm::vec3{inverse * glm::vec4{ray.direction, 0.0f}}};
+		TriangleBVH::Hit hit;
+		if(triangles->raycast(localRay, maxDistance, hit))
+		{
+			maxDistance = hit.distance;
+			ret = RaycastHit{prop, hit.triangle, hit.distance, ray.at(hit.distance)};
+		}
+		return maxDistance;
+	});
+	return ret;
+}
+
 void Scene::fitToIdealSize() const
 {
-	Bounds bounds = root->getBounds();
+	Bounds bounds = getBoundingVolumes().getBounds();
 	if(bounds.empty())
 		return;
 
@@ -138,19 +291,50 @@ void Scene::drawUI()
 	ImGui::SetColumnWidth(-1, scrollAreaWidth);
 
 	ImGui::Text("Background");
+	Cubemap const* previousSkybox = skybox;
 	if(ImGui::RadioButton("Solid", useSkybox == false || skybox == nullptr))
+	{
 		useSkybox = false;
+		updateTimestamp();
+	}
 	ImGui::SameLine();
 	static float aaa = 0.0f;
-	ImGui::ColorEdit3("###Background", &backgroundColor.x, ImGuiColorEditFlags_NoInputs | ImGuiColorEditFlags_Float);
+	if(ImGui::ColorEdit3("###Background", &backgroundColor.x, ImGuiColorEditFlags_NoInputs | ImGuiColorEditFlags_Float))
+		updateTimestamp();
 	if(ImGui::RadioButton("Cubemap", useSkybox == true && skybox != nullptr))
+	{
 		useSkybox = true;
+		updateTimestamp();
+	}
 	ImGui::SameLine();
 	skybox = chooseFromCombo(skybox, CubemapManager::getAll());
+	if(skybox != previousSkybox)
+		updateTimestamp();
 	if(ImGui::Button("Fit To:"))
 		fitToIdealSize();
 	ImGui::SameLine();
 	ImGui::InputFloat("###IdealSize", &idealSize);
+	ImGui::Checkbox("Flat Transform Hierarchy", &useTransformHierarchy);
+	if(useTransformHierarchy)
+	{
+		ImGui::SameLine();
+		ImGui::Checkbox("Parallel", &parallelTransformations);
+	}
+	ImGui::Text("Bounding Volumes: %i props, cost %.2f", boundingVolumes.getSize(), boundingVolumes.getCost());
+	ImGui::SameLine();
+	if(ImGui::Button("Rebuild"))
+		boundingVolumes.rebuild();
+	ImGui::Text("Render Queue: %i items", renderQueue.getSize());
+	if(ImGui::Button("Save Snapshot"))
+	{
+		std::string const filename = SceneSnapshot::getFilename(getName());
+		snapshotStatus = SceneSnapshot::save(*this, filename) ? "Saved " + filename : "Could not save " + filename;
+	}
+	if(!snapshotStatus.empty())
+	{
+		ImGui::SameLine();
+		ImGui::Text("%s", snapshotStatus.data());
+	}
 	
 	auto getName = [](Node* node) -> char const*{
 		//TODO find a better solution
@@ -299,7 +483,6 @@ void Scene::drawUI()
 			}
 		}
 	};
-	root->recursive([](Node* node){ node->setHighlighted(false); });
 	if(hierarchyView)
 	{
 		auto drawNode = [&](Node* node, bool root = false){
@@ -315,8 +498,6 @@ void Scene::drawUI()
 				current = node;
 			if(ImGui::IsItemHovered() || current == node)
 				node->recursive([&](Node* node){ nodesMarkedForHighlighting.insert(node); });
-			else
-				node->setHighlighted(false);
 			return expandNode;
 		};
 		auto drawSubtree = [&, id = 0](Node* node, auto& drawSubtree)mutable -> void{
@@ -348,8 +529,6 @@ void Scene::drawUI()
 				current = node;
 			if(ImGui::IsItemHovered() || current == node)
 				node->recursive([&](Node* node){ nodesMarkedForHighlighting.insert(node); });
-			else
-				node->setHighlighted(false);
 		};
 		auto drawList = [&](auto const& nodes){
 
@@ -401,8 +580,8 @@ void Scene::drawUI()
 		ImGui::EndChild();
 
 	}
-	for(auto node : nodesMarkedForHighlighting)
-		node->setHighlighted(true);
+	//highlights are only set once they are all known, so nodes that stay highlighted aren't stamped every frame
+	root->recursive([&](Node* node){ node->setHighlighted(nodesMarkedForHighlighting.count(node) != 0); });
 	for(auto node : nodesMarkedForShallowRemove)
 	{
 		if(current == node)
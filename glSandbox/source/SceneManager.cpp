@@ -4,6 +4,12 @@
 #include "MaterialManager.h"
 #include "ImportGLTF.h"
 #include "Prop.h"
+#include "NodePool.h"
+#include "SceneSnapshot.h"
+
+#include <chrono>
+
+static SceneManager::ImportStats lastImport;
 
 void SceneManager::initialize()
 {
@@ -11,17 +17,55 @@ void SceneManager::initialize()
 	testShadowMapping();
 }
 
-Scene* SceneManager::importGLTF(std::string_view const filename)
+static Scene* addAsset(Asset&& asset, std::string_view const filename, std::chrono::steady_clock::time_point start, NodePool::Stats const& poolBefore)
 {
-	auto asset = import(filename);
+	NodePool::Stats const poolAfter = NodePool::getStats();
+	lastImport.file = filename;
+	lastImport.milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	lastImport.nodes = 0;
+	lastImport.parents = 0;
+	lastImport.spilledChildren = 0;
+	for(auto const& scene : asset.scenes)
+	{
+		scene->getRoot()->recursive([&](Node* node){
+			lastImport.nodes++;
+			lastImport.parents += !node->getChildren().empty();
+			lastImport.spilledChildren += node->getChildren().isSpilled();
+		});
+	}
+	lastImport.unpooledNodes = poolAfter.unpooledAllocations - poolBefore.unpooledAllocations;
+	lastImport.slabAllocations = poolAfter.slabAllocations - poolBefore.slabAllocations;
+
 	auto ret = asset.scenes[0].get();//active scene
-	add(std::move(asset.scenes));
+	SceneManager::add(std::move(asset.scenes));
 	MeshManager::add(std::move(asset.meshes));
 	TextureManager::add(std::move(asset.textures));
 	MaterialManager::add(std::move(asset.materials));
 	return ret;
 }
 
+Scene* SceneManager::importGLTF(std::string_view const filename)
+{
+	auto const start = std::chrono::steady_clock::now();
+	NodePool::Stats const poolBefore = NodePool::getStats();
+	return addAsset(import(filename), filename, start, poolBefore);
+}
+
+Scene* SceneManager::loadSnapshot(std::string_view const filename)
+{
+	auto const start = std::chrono::steady_clock::now();
+	NodePool::Stats const poolBefore = NodePool::getStats();
+	auto asset = SceneSnapshot::load(filename);
+	if(!asset)
+		return nullptr;
+	return addAsset(std::move(*asset), filename, start, poolBefore);
+}
+
+SceneManager::ImportStats const& SceneManager::getLastImport()
+{
+	return lastImport;
+}
+
 Scene* SceneManager::basic()
 {
 	static auto ret = [&]() -> Scene*{
@@ -0,0 +1,700 @@
+#include "SceneSnapshot.h"
+#include "MappedFile.h"
+#include "Camera.h"
+#include "Lights.h"
+#include "Prop.h"
+#include "MaterialPBRMetallicRoughness.h"
+
+#include <glad/glad.h>
+#include <cstring>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	constexpr char magic[4] = {'G', 'L', 'S', 'S'};
+	constexpr uint64_t alignment = 8;
+
+	//bytes from the start of the file
+	struct Range
+	{
+		uint64_t offset = 0;
+		uint64_t size = 0;
+	};
+
+	struct Header
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t fileSize;
+		Range name;
+		Range textures;
+		Range materials;
+		Range meshes;
+		Range nodes;
+	};
+
+	//textures loaded from disk keep their path, the others, like embedded images, keep their pixels
+	struct TextureRecord
+	{
+		Range name;
+		Range path;
+		Range pixels;
+		uint32_t linear;
+		uint32_t width;
+		uint32_t height;
+		uint32_t format;
+		uint32_t pixelTransfer;
+		uint32_t dataType;
+	};
+
+	struct MaterialRecord
+	{
+		Range name;
+		uint32_t metallicRoughness;
+		int32_t normalMap;
+		int32_t occlusionMap;
+		int32_t emissiveMap;
+		uint32_t normalMapping;
+		uint32_t occlusionMapping;
+		glm::vec3 emissiveFactor;
+		int32_t baseColorMap;
+		glm::vec4 baseColorFactor;
+		int32_t metallicRoughnessMap;
+		float metallicFactor;
+		float roughnessFactor;
+		uint32_t padding;
+	};
+
+	struct AttributeRecord
+	{
+		uint32_t present;
+		uint32_t stride;
+		uint64_t offset;
+		uint32_t componentSize;
+		uint32_t dataType;
+		Range data;
+	};
+
+	struct MeshRecord
+	{
+		Range name;
+		glm::vec3 min;
+		glm::vec3 max;
+		uint32_t drawMode;
+		uint32_t interleaved;
+		Range vertexData;
+		AttributeRecord attributes[Mesh::AttributeType::N];
+		uint32_t indexCount;
+		uint32_t indexDataType;
+		Range indexData;
+	};
+
+	//nodes are stored depth first, parents before their children
+	struct NodeRecord
+	{
+		Range name;
+		uint32_t type;
+		int32_t parent;
+		uint32_t enabled;
+		uint32_t flags;
+		glm::vec3 translation;
+		glm::quat rotation;
+		glm::vec3 scale;
+		int32_t mesh;
+		int32_t material;
+		glm::vec3 color;
+		float intensity;
+		float parameters[4];
+	};
+
+	static_assert(std::is_trivially_copyable_v<Header> && std::is_trivially_copyable_v<TextureRecord> &&
+		std::is_trivially_copyable_v<MaterialRecord> && std::is_trivially_copyable_v<MeshRecord> &&
+		std::is_trivially_copyable_v<NodeRecord>);
+
+	enum CameraFlags : uint32_t
+	{
+		orthographic = 1,
+		visualizeFrustum = 2
+	};
+
+	class Writer
+	{
+	private:
+		std::vector<uint8_t> buffer;
+
+	public:
+		Writer()
+		{
+			buffer.resize(sizeof(Header));
+		}
+
+	public:
+		//reserves an aligned, zeroed block and returns where it starts
+		Range reserve(uint64_t size)
+		{
+			uint64_t const offset = (buffer.size() + alignment - 1) / alignment * alignment;
+			buffer.resize(offset + size);
+			return {offset, size};
+		}
+		uint8_t* at(Range range)
+		{
+			return buffer.data() + range.offset;
+		}
+		Range write(void const* data, uint64_t size)
+		{
+			Range const ret = reserve(size);
+			if(size)
+				std::memcpy(at(ret), data, size);
+			return ret;
+		}
+		Range write(std::string const& string)
+		{
+			return write(string.data(), string.size());
+		}
+		template <typename T>
+		Range write(std::vector<T> const& records)
+		{
+			return write(records.data(), records.size() * sizeof(T));
+		}
+		Header& getHeader()
+		{
+			return *reinterpret_cast<Header*>(buffer.data());
+		}
+		std::vector<uint8_t> const& getBuffer() const
+		{
+			return buffer;
+		}
+	};
+
+	class Reader
+	{
+	private:
+		uint8_t const* const data;
+		uint64_t const size;
+
+	public:
+		Reader(MappedFile const& file)
+			: data(file.getData()), size(file.getSize())
+		{
+		}
+
+	public:
+		bool valid(Range range) const
+		{
+			return range.offset <= size && range.size <= size - range.offset;
+		}
+		uint8_t const* at(Range range) const
+		{
+			return data + range.offset;
+		}
+		std::string string(Range range) const
+		{
+			return {reinterpret_cast<char const*>(at(range)), size_t(range.size)};
+		}
+		template <typename T>
+		std::pair<T const*, int> records(Range range) const
+		{
+			if(!valid(range) || range.size % sizeof(T) != 0 || range.offset % alignof(T) != 0)
+				return {nullptr, -1};
+			return {reinterpret_cast<T const*>(at(range)), int(range.size / sizeof(T))};
+		}
+	};
+
+	Light const* asLight(Node const* node)
+	{
+		switch(node->getType())
+		{
+			case NodeType::directionalLight:
+				return static_cast<DirectionalLight const*>(node);
+			case NodeType::pointLight:
+				return static_cast<PointLight const*>(node);
+			case NodeType::spotLight:
+				return static_cast<SpotLight const*>(node);
+			default:
+				return nullptr;
+		}
+	}
+
+	//tightly packed, 0 for layouts that aren't kept
+	uint64_t pixelSize(GLenum pixelTransfer, GLenum dataType)
+	{
+		uint64_t channels = 0;
+		switch(pixelTransfer)
+		{
+			case GL_RED:
+			case GL_DEPTH_COMPONENT:
+				channels = 1;
+				break;
+			case GL_RG:
+				channels = 2;
+				break;
+			case GL_RGB:
+				channels = 3;
+				break;
+			case GL_RGBA:
+				channels = 4;
+				break;
+			default:
+				return 0;
+		}
+		switch(dataType)
+		{
+			case GL_UNSIGNED_BYTE:
+				return channels;
+			case GL_UNSIGNED_SHORT:
+			case GL_HALF_FLOAT:
+				return channels * 2;
+			case GL_FLOAT:
+				return channels * 4;
+			default:
+				return 0;
+		}
+	}
+
+	uint32_t indexSize(GLenum dataType)
+	{
+		switch(dataType)
+		{
+			case GL_UNSIGNED_BYTE:
+				return 1;
+			case GL_UNSIGNED_SHORT:
+				return 2;
+			default:
+				return 4;
+		}
+	}
+}
+
+std::string SceneSnapshot::getFilename(std::string_view const sceneName)
+{
+	std::string filename;
+	for(char const c : sceneName)
+		filename += std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' || c == ' ' || c == '.' ? c : '_';
+	if(filename.empty())
+		filename = "scene";
+	//names windows reserves for devices, whatever the extension
+	std::string upper = filename;
+	std::transform(upper.begin(), upper.end(), upper.begin(), [](unsigned char c){
+		return char(std::toupper(c));
+	});
+	std::array<char const*, 6> const reserved{"CON", "PRN", "AUX", "NUL", "COM", "LPT"};
+	for(auto name : reserved)
+		if(upper == name || (upper.size() == 4 && upper.compare(0, 3, name) == 0 && std::isdigit(static_cast<unsigned char>(upper[3]))))
+			filename.insert(filename.begin(), '_');
+	return filename + extension;
+}
+
+bool SceneSnapshot::save(Scene const& scene, std::string_view const filename)
+{
+	Writer writer;
+	std::vector<TextureRecord> textures;
+	std::vector<MaterialRecord> materials;
+	std::vector<MeshRecord> meshes;
+	std::vector<NodeRecord> nodes;
+	std::unordered_map<Texture const*, int> textureIndices;
+	std::unordered_map<Material const*, int> materialIndices;
+	std::unordered_map<Mesh const*, int> meshIndices;
+
+	auto addTexture = [&](Texture const* texture) -> int{
+		if(!texture)
+			return -1;
+		if(auto it = textureIndices.find(texture); it != textureIndices.end())
+			return it->second;
+		TextureRecord record{};
+		if(texture->path)
+		{
+			record.path = writer.write(*texture->path);
+		}
+		else
+		{
+			uint64_t const size = uint64_t(texture->width) * texture->height * pixelSize(texture->pixelTransfer, texture->dataType);
+			if(size == 0)
+				return -1;
+			record.width = texture->width;
+			record.height = texture->height;
+			record.format = texture->format;
+			record.pixelTransfer = texture->pixelTransfer;
+			record.dataType = texture->dataType;
+			record.pixels = writer.reserve(size);
+			glPixelStorei(GL_PACK_ALIGNMENT, 1);
+			glGetTextureImage(texture->getID(), 0, texture->pixelTransfer, texture->dataType, GLsizei(size), writer.at(record.pixels));
+			glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		}
+		record.name = writer.write(texture->getName());
+		record.linear = texture->linear;
+		textureIndices.emplace(texture, int(textures.size()));
+		textures.push_back(record);
+		return int(textures.size()) - 1;
+	};
+
+	auto addMaterial = [&](Material const* material) -> int{
+		if(!material)
+			return -1;
+		auto[it, inserted] = materialIndices.try_emplace(material, int(materials.size()));
+		if(!inserted)
+			return it->second;
+		MaterialRecord record{};
+		record.name = writer.write(material->getName());
+		record.normalMap = addTexture(material->normalMap);
+		record.occlusionMap = addTexture(material->occlusionMap);
+		record.emissiveMap = addTexture(material->emissiveMap);
+		record.normalMapping = material->normalMapping;
+		record.occlusionMapping = material->occlusionMapping;
+		record.emissiveFactor = material->emissiveFactor;
+		record.baseColorMap = -1;
+		record.metallicRoughnessMap = -1;
+		if(auto materialMR = dynamic_cast<MaterialPBRMetallicRoughness const*>(material))
+		{
+			record.metallicRoughness = true;
+			record.baseColorMap = addTexture(materialMR->baseColorMap);
+			record.baseColorFactor = materialMR->baseColorFactor;
+			record.metallicRoughnessMap = addTexture(materialMR->metallicRoughnessMap);
+			record.metallicFactor = materialMR->metallicFactor;
+			record.roughnessFactor = materialMR->roughnessFactor;
+		}
+		materials.push_back(record);
+		return it->second;
+	};
+
+	auto addMesh = [&](Mesh const& mesh) -> int{
+		auto[it, inserted] = meshIndices.try_emplace(&mesh, int(meshes.size()));
+		if(!inserted)
+			return it->second;
+		MeshRecord record{};
+		record.name = writer.write(mesh.getName());
+		std::tie(record.min, record.max) = mesh.getBounds().getValues();
+		record.drawMode = mesh.drawMode;
+		record.interleaved = mesh.layout.interleaved;
+		record.vertexData = writer.reserve(mesh.layout.size);
+		MeshArena const& arena = MeshArena::shared();
+		glGetNamedBufferSubData(arena.getVertexBuffer(mesh.arenaRange.pool), arena.getVertexOffset(mesh.arenaRange),
+			GLsizeiptr(mesh.layout.size), writer.at(record.vertexData));
+		for(int i = 0; i < Mesh::AttributeType::N; i++)
+		{
+			auto const& attribute = mesh.layout.array[i];
+			if(!attribute)
+				continue;
+			AttributeRecord& attributeRecord = record.attributes[i];
+			attributeRecord.present = true;
+			attributeRecord.stride = attribute->stride;
+			attributeRecord.offset = attribute->offset;
+			attributeRecord.componentSize = attribute->componentSize;
+			attributeRecord.dataType = attribute->dataType;
+			if(mesh.layout.interleaved)
+				attributeRecord.data = {record.vertexData.offset, attribute->size};
+			else
+				attributeRecord.data = {record.vertexData.offset + attribute->offset, attribute->size};
+		}
+		if(mesh.indexedDrawing)
+		{
+			record.indexCount = mesh.indexCount;
+			record.indexDataType = mesh.indexDataType;
+			record.indexData = writer.reserve(uint64_t(mesh.indexCount) * indexSize(mesh.indexDataType));
+			glGetNamedBufferSubData(arena.getIndexBuffer(mesh.arenaRange.pool), arena.getIndexOffset(mesh.arenaRange),
+				GLsizeiptr(record.indexData.size), writer.at(record.indexData));
+		}
+		meshes.push_back(record);
+		return it->second;
+	};
+
+	std::vector<std::pair<Node const*, int>> stack{{scene.getRoot(), -1}};
+	while(!stack.empty())
+	{
+		auto const[node, parent] = stack.back();
+		stack.pop_back();
+		NodeRecord record{};
+		record.name = writer.write(node->getName());
+		record.type = uint32_t(node->getType());
+		record.parent = parent;
+		record.enabled = node->isEnabled();
+		std::tie(record.translation, record.rotation, record.scale) = node->getLocalComponents();
+		record.mesh = -1;
+		record.material = -1;
+		switch(node->getType())
+		{
+			case NodeType::prop:
+			{
+				auto const prop = static_cast<Prop const*>(node);
+				record.mesh = addMesh(prop->getMesh());
+				record.material = addMaterial(prop->getMaterial());
+				break;
+			}
+			case NodeType::camera:
+			{
+				auto const camera = static_cast<Camera const*>(node);
+				record.flags = (camera->projectionOrtho ? uint32_t(orthographic) : uint32_t(0)) |
+					(camera->visualizeFrustum ? uint32_t(visualizeFrustum) : uint32_t(0));
+				record.parameters[0] = camera->nearPlane;
+				record.parameters[1] = camera->farPlane;
+				record.parameters[2] = camera->fov;
+				record.parameters[3] = camera->orthoScale;
+				break;
+			}
+			case NodeType::directionalLight:
+			case NodeType::pointLight:
+			case NodeType::spotLight:
+			{
+				Light const* light = asLight(node);
+				record.color = light->getColor();
+				record.intensity = light->getIntensity();
+				if(node->getType() == NodeType::spotLight)
+				{
+					record.parameters[0] = static_cast<SpotLight const*>(node)->getInnerCutoff();
+					record.parameters[1] = static_cast<SpotLight const*>(node)->getOuterCutoff();
+				}
+				break;
+			}
+			default:
+				break;
+		}
+		int const index = int(nodes.size());
+		nodes.push_back(record);
+		auto const& children = node->getChildren();
+		for(auto it = children.rbegin(); it != children.rend(); it++)
+			stack.emplace_back(it->get(), index);
+	}
+
+	Range const name = writer.write(scene.getName());
+	Range const textureRecords = writer.write(textures);
+	Range const materialRecords = writer.write(materials);
+	Range const meshRecords = writer.write(meshes);
+	Range const nodeRecords = writer.write(nodes);
+	Header& header = writer.getHeader();
+	std::memcpy(header.magic, magic, sizeof(magic));
+	header.version = version;
+	header.fileSize = writer.getBuffer().size();
+	header.name = name;
+	header.textures = textureRecords;
+	header.materials = materialRecords;
+	header.meshes = meshRecords;
+	header.nodes = nodeRecords;
+
+	std::ofstream file{std::string(filename), std::ios::binary | std::ios::trunc};
+	file.write(reinterpret_cast<char const*>(writer.getBuffer().data()), std::streamsize(writer.getBuffer().size()));
+	return bool(file);
+}
+
+std::optional<Asset> SceneSnapshot::load(std::string_view const filename)
+{
+	MappedFile file{filename};
+	if(!file.isOpen() || file.getSize() < sizeof(Header))
+		return std::nullopt;
+	Reader const reader{file};
+	Header const& header = *reinterpret_cast<Header const*>(file.getData());
+	if(std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version || header.fileSize != file.getSize())
+		return std::nullopt;
+	auto const[textureRecords, textureCount] = reader.records<TextureRecord>(header.textures);
+	auto const[materialRecords, materialCount] = reader.records<MaterialRecord>(header.materials);
+	auto const[meshRecords, meshCount] = reader.records<MeshRecord>(header.meshes);
+	auto const[nodeRecords, nodeCount] = reader.records<NodeRecord>(header.nodes);
+	if(textureCount < 0 || materialCount < 0 || meshCount < 0 || nodeCount <= 0 || !reader.valid(header.name))
+		return std::nullopt;
+
+	Asset asset;
+	for(int i = 0; i < textureCount; i++)
+	{
+		TextureRecord const& record = textureRecords[i];
+		if(!reader.valid(record.name) || !reader.valid(record.path) || !reader.valid(record.pixels))
+			return std::nullopt;
+		std::unique_ptr<Texture> texture;
+		if(record.path.size)
+		{
+			texture = std::make_unique<Texture>(reader.string(record.path), bool(record.linear));
+		}
+		else
+		{
+			if(record.pixels.size == 0 ||
+				record.pixels.size != uint64_t(record.width) * record.height * pixelSize(record.pixelTransfer, record.dataType))
+				return std::nullopt;
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			texture = std::make_unique<Texture>(record.format, int(record.width), int(record.height), record.pixelTransfer,
+				record.dataType, const_cast<uint8_t*>(reader.at(record.pixels)));
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+			texture->linear = record.linear;
+		}
+		texture->setName(reader.string(record.name));
+		asset.textures.push_back(std::move(texture));
+	}
+	auto getTexture = [&](int32_t index) -> Texture*{
+		return index >= 0 && index < textureCount ? asset.textures[index].get() : nullptr;
+	};
+
+	for(int i = 0; i < materialCount; i++)
+	{
+		MaterialRecord const& record = materialRecords[i];
+		if(!reader.valid(record.name))
+			return std::nullopt;
+		std::unique_ptr<Material> material;
+		if(record.metallicRoughness)
+		{
+			auto materialMR = std::make_unique<MaterialPBRMetallicRoughness>();
+			materialMR->setBaseColorMap(getTexture(record.baseColorMap));
+			materialMR->setBaseColorFactor(record.baseColorFactor);
+			materialMR->setMetallicRoughnessMap(getTexture(record.metallicRoughnessMap));
+			materialMR->setMetallicFactor(record.metallicFactor);
+			materialMR->setRoughnessFactor(record.roughnessFactor);
+			material = std::move(materialMR);
+		}
+		else
+		{
+			material = std::make_unique<Material>();
+		}
+		material->setName(reader.string(record.name));
+		material->setNormalMap(getTexture(record.normalMap));
+		material->normalMapping = record.normalMapping;
+		material->setOcclusionMap(getTexture(record.occlusionMap));
+		material->occlusionMapping = record.occlusionMapping;
+		material->setEmissiveMap(getTexture(record.emissiveMap));
+		material->setEmissiveFactor(record.emissiveFactor);
+		asset.materials.push_back(std::move(material));
+	}
+
+	for(int i = 0; i < meshCount; i++)
+	{
+		MeshRecord const& record = meshRecords[i];
+		if(!reader.valid(record.name) || !reader.valid(record.vertexData) || !reader.valid(record.indexData))
+			return std::nullopt;
+		Mesh::Attributes attributes;
+		attributes.interleaved = record.interleaved;
+		attributes.data = reader.at(record.vertexData);
+		attributes.size = record.vertexData.size;
+		for(int j = 0; j < Mesh::AttributeType::N; j++)
+		{
+			AttributeRecord const& attributeRecord = record.attributes[j];
+			if(!attributeRecord.present)
+				continue;
+			if(!reader.valid(attributeRecord.data) || attributeRecord.stride == 0)
+				return std::nullopt;
+			Mesh::Attributes::AttributeBuffer attribute;
+			attribute.data = reader.at(attributeRecord.data);
+			attribute.size = attributeRecord.data.size;
+			attribute.stride = attributeRecord.stride;
+			attribute.offset = attributeRecord.offset;
+			attribute.componentSize = attributeRecord.componentSize;
+			attribute.dataType = attributeRecord.dataType;
+			attribute.attributeType = Mesh::AttributeType(j);
+			attributes.array[j] = attribute;
+		}
+		if(!attributes.array[Mesh::AttributeType::positions])
+			return std::nullopt;
+		std::optional<Mesh::IndexBuffer> indices;
+		if(record.indexCount)
+		{
+			if(record.indexData.size != uint64_t(record.indexCount) * indexSize(record.indexDataType))
+				return std::nullopt;
+			indices = Mesh::IndexBuffer{reader.at(record.indexData), record.indexData.size, record.indexCount, record.indexDataType};
+		}
+		auto mesh = std::make_unique<Mesh>(Bounds{record.min, record.max}, record.drawMode, std::move(attributes), std::move(indices));
+		mesh->setName(reader.string(record.name));
+		asset.meshes.push_back(std::move(mesh));
+	}
+
+	std::vector<Node*> nodes;
+	nodes.reserve(nodeCount);
+	std::unique_ptr<Node> root;
+	for(int i = 0; i < nodeCount; i++)
+	{
+		NodeRecord const& record = nodeRecords[i];
+		if(!reader.valid(record.name) || (i == 0) != (record.parent == -1) || record.parent < -1 || record.parent >= i)
+			return std::nullopt;
+		auto setComponents = [&](auto* node){
+			using T = std::remove_pointer_t<decltype(node)>;
+			if constexpr(std::is_base_of_v<Translation, T>)
+				node->setLocalTranslation(record.translation);
+			if constexpr(std::is_base_of_v<Rotation, T>)
+				node->setLocalRotation(record.rotation);
+			if constexpr(std::is_base_of_v<Scale, T>)
+				node->setLocalScale(record.scale);
+		};
+		auto setLight = [&](Light* light){
+			light->setColor(record.color);
+			light->setIntensity(record.intensity);
+		};
+		std::unique_ptr<Node> node;
+		switch(NodeType(record.type))
+		{
+			case NodeType::transformedNode:
+			{
+				auto transformedNode = std::make_unique<TransformedNode>();
+				setComponents(transformedNode.get());
+				node = std::move(transformedNode);
+				break;
+			}
+			case NodeType::prop:
+			{
+				if(record.mesh < 0 || record.mesh >= meshCount)
+					return std::nullopt;
+				Mesh* mesh = asset.meshes[record.mesh].get();
+				auto prop = record.material >= 0 && record.material < materialCount ?
+					std::make_unique<Prop>(mesh, asset.materials[record.material].get()) : std::make_unique<Prop>(mesh);
+				setComponents(prop.get());
+				node = std::move(prop);
+				break;
+			}
+			case NodeType::camera:
+			{
+				auto camera = std::make_unique<Camera>();
+				setComponents(camera.get());
+				camera->projectionOrtho = record.flags & orthographic;
+				camera->visualizeFrustum = record.flags & visualizeFrustum;
+				camera->nearPlane = record.parameters[0];
+				camera->farPlane = record.parameters[1];
+				camera->fov = record.parameters[2];
+				camera->orthoScale = record.parameters[3];
+				node = std::move(camera);
+				break;
+			}
+			case NodeType::directionalLight:
+			{
+				auto light = std::make_unique<DirectionalLight>();
+				setComponents(light.get());
+				setLight(light.get());
+				node = std::move(light);
+				break;
+			}
+			case NodeType::pointLight:
+			{
+				auto light = std::make_unique<PointLight>();
+				setComponents(light.get());
+				setLight(light.get());
+				node = std::move(light);
+				break;
+			}
+			case NodeType::spotLight:
+			{
+				auto light = std::make_unique<SpotLight>();
+				setComponents(light.get());
+				setLight(light.get());
+				light->setCutoff(record.parameters[0], record.parameters[1]);
+				node = std::move(light);
+				break;
+			}
+			default:
+				return std::nullopt;
+		}
+		node->setName(reader.string(record.name));
+		if(!record.enabled)
+			node->disable();
+		if(record.parent == -1)
+		{
+			nodes.push_back(node.get());
+			root = std::move(node);
+		}
+		else
+		{
+			nodes.push_back(nodes[record.parent]->addChild(std::move(node)));
+		}
+	}
+
+	auto scene = std::make_unique<Scene>(std::move(root), false);
+	scene->setName(reader.string(header.name));
+	asset.scenes.push_back(std::move(scene));
+	return asset;
+}
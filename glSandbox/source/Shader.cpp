@@ -38,13 +38,112 @@ Shader::Shader(std::string const vertexPath, std::string const fragmentPath, std
 {
 }
 
+Shader::Shader(std::string const computePath)
+	:computePath(computePath)
+{
+}
+
+std::vector<std::string>& Shader::getSlotNames()
+{
+	static std::vector<std::string> names;
+	return names;
+}
+
+int Shader::getSlot(std::string_view const name)
+{
+	static std::unordered_map<std::string, int> slots;
+	auto const[it, inserted] = slots.try_emplace(std::string(name), int(slots.size()));
+	if(inserted)
+		getSlotNames().emplace_back(name);
+	return it->second;
+}
+
+void Shader::introspect()
+{
+	uniformLocations.clear();
+	uniformNames.clear();
+	slotLocations.clear();
+	int uniformCount = 0;
+	glGetProgramInterfaceiv(ID, GL_UNIFORM, GL_ACTIVE_RESOURCES, &uniformCount);
+	int maxNameLength = 0;
+	glGetProgramInterfaceiv(ID, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+	std::string name(maxNameLength, '\0');
+	auto const add = [&](std::string name, int location){
+		uniformLocations[uniformNames.emplace_back(std::move(name))] = location;
+	};
+	for(int i = 0; i < uniformCount; i++)
+	{
+		GLenum const properties[] = {GL_LOCATION, GL_ARRAY_SIZE};
+		int values[2];
+		glGetProgramResourceiv(ID, GL_UNIFORM, i, 2, properties, 2, nullptr, values);
+		auto const[location, arraySize] = values;
+		//members of uniform blocks have no location
+		if(location == -1)
+			continue;
+		int length = 0;
+		glGetProgramResourceName(ID, GL_UNIFORM, i, maxNameLength, &length, name.data());
+		std::string_view const resource{name.data(), std::size_t(length)};
+		//arrays of basic types are reported once, as name[0], and their elements have consecutive locations
+		if(resource.size() > 3 && resource.substr(resource.size() - 3) == "[0]")
+		{
+			std::string const base{resource.substr(0, resource.size() - 3)};
+			add(base, location);
+			for(int element = 0; element < arraySize; element++)
+				add(base + "[" + std::to_string(element) + "]", location + element);
+		}
+		else
+		{
+			add(std::string(resource), location);
+		}
+	}
+}
+
 int Shader::getLocation(std::string_view const name) const
 {
-	int res = glGetUniformLocation(ID, name.data());
-//#ifndef NDEBUG
-//	assert(res != -1);
-//#endif
-	return res;
+	auto const it = uniformLocations.find(name);
+	if(it == uniformLocations.end())
+		return -1;
+	return it->second;
+}
+
+int Shader::getLocation(int slot) const
+{
+	if(slot >= int(slotLocations.size()))
+		slotLocations.resize(getSlotNames().size(), unresolved);
+	int& location = slotLocations[slot];
+	if(location == unresolved)
+		location = getLocation(getSlotNames()[slot]);
+	return location;
+}
+
+void Shader::upload(int location, int value)
+{
+	glUniform1i(location, value);
+}
+
+void Shader::upload(int location, float value)
+{
+	glUniform1f(location, value);
+}
+
+void Shader::upload(int location, glm::vec2 const& value)
+{
+	glUniform2f(location, value.x, value.y);
+}
+
+void Shader::upload(int location, glm::vec3 const& value)
+{
+	glUniform3f(location, value.x, value.y, value.z);
+}
+
+void Shader::upload(int location, glm::vec4 const& value)
+{
+	glUniform4f(location, value.x, value.y, value.z, value.w);
+}
+
+void Shader::upload(int location, glm::mat4 const& value)
+{
+	glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
 }
 
 std::string Shader::getNamePrefix() const
@@ -52,6 +151,17 @@ std::string Shader::getNamePrefix() const
 	return "shader";
 }
 
+void Shader::updateTimestamp()
+{
+	Timestamp::updateTimestamp();
+	latestTimestamp = getTimestamp();
+}
+
+uint64_t Shader::getLatestTimestamp()
+{
+	return latestTimestamp;
+}
+
 void Shader::reload()
 {
 	if(initialized)
@@ -59,20 +169,22 @@ void Shader::reload()
 	initialized = true;
 	ID = glCreateProgram();
 
-	std::string const vertexCode = read(vertexPath);
-	unsigned int vertex = compile(vertexCode, GL_VERTEX_SHADER);
-	glAttachShader(ID, vertex);
-
-	std::string const fragmentCode = read(fragmentPath);
-	unsigned int fragment = compile(fragmentCode, GL_FRAGMENT_SHADER);
-	glAttachShader(ID, fragment);
-
-	unsigned int geometry;
-	if(geometryPath)
+	std::vector<unsigned int> stages;
+	auto const attach = [&](std::string const& path, GLenum type){
+		std::string const code = read(path);
+		stages.push_back(compile(code, type));
+		glAttachShader(ID, stages.back());
+	};
+	if(computePath)
 	{
-		std::string const geometryCode = read(*geometryPath);
-		geometry = compile(geometryCode, GL_GEOMETRY_SHADER);
-		glAttachShader(ID, geometry);
+		attach(*computePath, GL_COMPUTE_SHADER);
+	}
+	else
+	{
+		attach(vertexPath, GL_VERTEX_SHADER);
+		attach(fragmentPath, GL_FRAGMENT_SHADER);
+		if(geometryPath)
+			attach(*geometryPath, GL_GEOMETRY_SHADER);
 	}
 
 	glLinkProgram(ID);
@@ -88,10 +200,13 @@ void Shader::reload()
 		//assert(false);
 	}
 
-	glDeleteShader(vertex);
-	glDeleteShader(fragment);
-	if(geometryPath)
-		glDeleteShader(geometry);
+	instanced = glGetProgramResourceIndex(ID, GL_SHADER_STORAGE_BLOCK, "Instances") != GL_INVALID_INDEX;
+	clusteredLighting = glGetProgramResourceIndex(ID, GL_SHADER_STORAGE_BLOCK, "ClusterLights") != GL_INVALID_INDEX;
+	introspect();
+
+	for(unsigned int stage : stages)
+		glDeleteShader(stage);
+	updateTimestamp();
 
 	//validate();
 }
@@ -103,6 +218,16 @@ void Shader::use()
 	glUseProgram(ID);
 }
 
+bool Shader::supportsInstancing() const
+{
+	return instanced;
+}
+
+bool Shader::supportsClusteredLighting() const
+{
+	return clusteredLighting;
+}
+
 void Shader::validate()
 {
 	glValidateProgram(ID);
@@ -123,31 +248,61 @@ void Shader::validate()
 
 void Shader::set(std::string_view const name, int value) const
 {
-	glUniform1i(getLocation(name), value);
+	upload(getLocation(name), value);
 }
 void Shader::set(std::string_view const name, float value) const
 {
-	glUniform1f(getLocation(name), value);
+	upload(getLocation(name), value);
 }
 void Shader::set(std::string_view const name, glm::vec2 const& value) const
 {
-	glUniform2f(getLocation(name), value.x, value.y);
+	upload(getLocation(name), value);
 }
 void Shader::set(std::string_view const name, glm::vec3 const& value) const
 {
-	glUniform3f(getLocation(name), value.x, value.y, value.z);
+	upload(getLocation(name), value);
 }
 void Shader::set(std::string_view const name, glm::vec4 const& value) const
 {
-	glUniform4f(getLocation(name), value.x, value.y, value.z, value.w);
+	upload(getLocation(name), value);
 }
 void Shader::set(std::string_view const name, glm::mat4 const& value) const
 {
-	glUniformMatrix4fv(getLocation(name), 1, GL_FALSE, glm::value_ptr(value));
+	upload(getLocation(name), value);
+}
+void Shader::set(Uniform<int> const& uniform, int value) const
+{
+	upload(getLocation(uniform.slot), value);
+}
+void Shader::set(Uniform<float> const& uniform, float value) const
+{
+	upload(getLocation(uniform.slot), value);
+}
+void Shader::set(Uniform<glm::vec2> const& uniform, glm::vec2 const& value) const
+{
+	upload(getLocation(uniform.slot), value);
+}
+void Shader::set(Uniform<glm::vec3> const& uniform, glm::vec3 const& value) const
+{
+	upload(getLocation(uniform.slot), value);
+}
+void Shader::set(Uniform<glm::vec4> const& uniform, glm::vec4 const& value) const
+{
+	upload(getLocation(uniform.slot), value);
+}
+void Shader::set(Uniform<glm::mat4> const& uniform, glm::mat4 const& value) const
+{
+	upload(getLocation(uniform.slot), value);
+}
+
+int Shader::getUniformCount() const
+{
+	return int(uniformLocations.size());
 }
 
 void Shader::drawUI()
 {
 	if(ImGui::Button("Reload"))
 		reload();
+	ImGui::Text("Active uniforms: %i", getUniformCount());
 }
@@ -21,6 +21,7 @@ void ShaderManager::initialize()
 	debugDepthBuffer();
 	shadowMappingUnidirectional();
 	shadowMappingOmnidirectional();
+	clusterLights();
 	skybox();
 	gammaHDR();
 	passthrough();
@@ -206,6 +207,14 @@ Shader* ShaderManager::shadowMappingOmnidirectional()
 	return ret;
 }
 
+Shader* ShaderManager::clusterLights()
+{
+	static auto ret = load("Cluster Lights",
+		"shaders/clusterLights.comp"
+	);
+	return ret;
+}
+
 Shader* ShaderManager::skybox()
 {
 	static auto ret = load("Skybox",
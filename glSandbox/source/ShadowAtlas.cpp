@@ -0,0 +1,470 @@
+#include "ShadowAtlas.h"
+#include "Node.h"
+#include "UIUtilities.h"
+
+#include <imgui.h>
+#include <algorithm>
+
+std::size_t ShadowAtlas::KeyHash::operator()(Key const& key) const
+{
+	return std::hash<Node const*>{}(key.first) ^ std::hash<int>{}(key.second) * 31;
+}
+
+ShadowAtlas::ShadowAtlas(int atlasSize, int cubeSize, int cubeLayers)
+	: atlasSize(atlasSize), cubeSize(cubeSize), cubeLayers(cubeLayers)
+{
+	glCreateFramebuffers(1, &framebuffer);
+	glNamedFramebufferDrawBuffer(framebuffer, GL_NONE);
+	glNamedFramebufferReadBuffer(framebuffer, GL_NONE);
+	glCreateBuffers(1, &shadowBuffer);
+	createTextures();
+}
+
+ShadowAtlas::~ShadowAtlas()
+{
+	deleteTextures();
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteBuffers(1, &shadowBuffer);
+}
+
+void ShadowAtlas::createTextures()
+{
+	static float const borderColor[] = {1.0f, 1.0f, 1.0f, 1.0f};
+	glCreateTextures(GL_TEXTURE_2D, 1, &atlas);
+	glTextureStorage2D(atlas, 1, GL_DEPTH_COMPONENT32F, atlasSize, atlasSize);
+	glTextureParameteri(atlas, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(atlas, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(atlas, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTextureParameteri(atlas, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	glTextureParameterfv(atlas, GL_TEXTURE_BORDER_COLOR, borderColor);
+	glTextureParameteri(atlas, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glGenTextures(1, &atlasView);
+	glTextureView(atlasView, GL_TEXTURE_2D, atlas, GL_DEPTH_COMPONENT32F, 0, 1, 0, 1);
+
+	glCreateTextures(GL_TEXTURE_CUBE_MAP_ARRAY, 1, &cubeArray);
+	glTextureStorage3D(cubeArray, 1, GL_DEPTH_COMPONENT32F, cubeSize, cubeSize, std::max(cubeLayers, 1) * 6);
+	glTextureParameteri(cubeArray, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(cubeArray, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(cubeArray, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+
+	nodes.clear();
+	freeChildren.clear();
+	QuadNode root;
+	root.tile = {glm::ivec2{0}, atlasSize};
+	nodes.push_back(root);
+	freeLayers.clear();
+	for(int layer = cubeLayers - 1; layer >= 0; layer--)
+		freeLayers.push_back(layer);
+	allocations.clear();
+	stats.tiles = 0;
+	stats.usedArea = 0;
+}
+
+void ShadowAtlas::createStaticTextures()
+{
+	glCreateTextures(GL_TEXTURE_2D, 1, &staticAtlas);
+	glTextureStorage2D(staticAtlas, 1, GL_DEPTH_COMPONENT32F, atlasSize, atlasSize);
+	glCreateTextures(GL_TEXTURE_CUBE_MAP_ARRAY, 1, &staticCubeArray);
+	glTextureStorage3D(staticCubeArray, 1, GL_DEPTH_COMPONENT32F, cubeSize, cubeSize, std::max(cubeLayers, 1) * 6);
+}
+
+void ShadowAtlas::deleteTextures()
+{
+	glDeleteTextures(1, &atlasView);
+	glDeleteTextures(1, &atlas);
+	glDeleteTextures(1, &cubeArray);
+	glDeleteTextures(1, &staticAtlas);
+	glDeleteTextures(1, &staticCubeArray);
+	staticAtlas = 0;
+	staticCubeArray = 0;
+}
+
+void ShadowAtlas::split(int node)
+{
+	int children;
+	if(freeChildren.empty())
+	{
+		children = int(nodes.size());
+		nodes.resize(nodes.size() + 4);
+	}
+	else
+	{
+		children = freeChildren.back();
+		freeChildren.pop_back();
+	}
+	Tile const tile = nodes[node].tile;
+	int const size = tile.size / 2;
+	for(int i = 0; i < 4; i++)
+	{
+		QuadNode& child = nodes[children + i];
+		child = QuadNode{};
+		child.tile = {tile.offset + glm::ivec2{i % 2, i / 2} * size, size};
+		child.parent = node;
+	}
+	nodes[node].children = children;
+}
+
+int ShadowAtlas::allocateNode(int node, int size)
+{
+	if(nodes[node].used || nodes[node].tile.size < size)
+		return -1;
+	if(nodes[node].children == -1)
+	{
+		if(nodes[node].tile.size == size)
+		{
+			nodes[node].used = true;
+			return node;
+		}
+		split(node);
+	}
+	//children that are already split are tried first, so free space stays in large pieces
+	int const children = nodes[node].children;
+	for(bool splitChildren : {true, false})
+	{
+		for(int i = 0; i < 4; i++)
+		{
+			int const child = children + i;
+			if((nodes[child].children != -1) != splitChildren)
+				continue;
+			int const allocated = allocateNode(child, size);
+			if(allocated != -1)
+				return allocated;
+		}
+	}
+	return -1;
+}
+
+void ShadowAtlas::freeNode(int node)
+{
+	nodes[node].used = false;
+	//parents whose children are all free become free leaves again
+	for(int parent = nodes[node].parent; parent != -1; parent = nodes[parent].parent)
+	{
+		int const children = nodes[parent].children;
+		for(int i = 0; i < 4; i++)
+			if(nodes[children + i].used || nodes[children + i].children != -1)
+				return;
+		freeChildren.push_back(children);
+		nodes[parent].children = -1;
+	}
+}
+
+void ShadowAtlas::release(Allocation& allocation)
+{
+	if(allocation.node != -1)
+	{
+		int const size = nodes[allocation.node].tile.size;
+		stats.usedArea -= size * size;
+		stats.tiles--;
+		freeNode(allocation.node);
+		allocation.node = -1;
+	}
+	if(allocation.layer != -1)
+	{
+		freeLayers.push_back(allocation.layer);
+		allocation.layer = -1;
+	}
+	allocation.cache.valid = false;
+	allocation.cache.drawn = false;
+	allocation.lightSpace = glm::mat4{1.0f};
+}
+
+void ShadowAtlas::resize(int atlasSize, int cubeSize, int cubeLayers)
+{
+	if(atlasSize == this->atlasSize && cubeSize == this->cubeSize && cubeLayers == this->cubeLayers)
+		return;
+	this->atlasSize = atlasSize;
+	this->cubeSize = cubeSize;
+	this->cubeLayers = cubeLayers;
+	deleteTextures();
+	createTextures();
+}
+
+int ShadowAtlas::getAtlasSize() const
+{
+	return atlasSize;
+}
+
+int ShadowAtlas::getCubeSize() const
+{
+	return cubeSize;
+}
+
+int ShadowAtlas::getCubeLayers() const
+{
+	return cubeLayers;
+}
+
+void ShadowAtlas::beginUpdate()
+{
+	for(auto&[key, allocation] : allocations)
+	{
+		allocation.requested = false;
+		allocation.shadow = -1;
+		allocation.cascades = 0;
+	}
+	shadows.clear();
+	stats.failures = 0;
+	stats.staticLayers = 0;
+	stats.dynamicLayers = 0;
+	stats.cached = 0;
+	stats.deferred = 0;
+}
+
+int ShadowAtlas::request(Node const* light, int size, int cascade)
+{
+	size = std::min(size, atlasSize);
+	Allocation& allocation = allocations[{light, cascade}];
+	allocation.requested = true;
+	if(allocation.node != -1 && allocation.requestedSize != size)
+	{
+		release(allocation);
+		stats.reallocations++;
+	}
+	allocation.requestedSize = size;
+	if(allocation.node == -1)
+	{
+		//a full atlas hands out smaller tiles before giving up
+		for(int tileSize = size; allocation.node == -1 && tileSize >= std::max(size / 8, 1); tileSize /= 2)
+			allocation.node = allocateNode(0, tileSize);
+		if(allocation.node == -1)
+		{
+			stats.failures++;
+			return -1;
+		}
+		int const tileSize = nodes[allocation.node].tile.size;
+		stats.usedArea += tileSize * tileSize;
+		stats.tiles++;
+	}
+	Tile const& tile = nodes[allocation.node].tile;
+	allocation.shadow = int(shadows.size());
+	Shadow shadow{};
+	shadow.lightSpace = allocation.lightSpace;
+	shadow.rect = glm::vec4{glm::vec2{tile.offset}, glm::vec2{float(tile.size)}} / float(atlasSize);
+	shadow.cascadeEnd = allocation.cascadeEnd;
+	shadows.push_back(shadow);
+	return allocation.shadow;
+}
+
+int ShadowAtlas::requestCascades(Node const* light, int size, int cascades, int firstCascade)
+{
+	int granted = 0;
+	while(granted < std::min(cascades, maxCascades) && request(light, size, firstCascade + granted) != -1)
+		granted++;
+	if(granted)
+		allocations.at({light, firstCascade}).cascades = granted;
+	return granted;
+}
+
+int ShadowAtlas::requestCube(Node const* light, float farPlane)
+{
+	Allocation& allocation = allocations[{light, 0}];
+	allocation.requested = true;
+	if(allocation.layer == -1)
+	{
+		if(freeLayers.empty())
+		{
+			stats.failures++;
+			return -1;
+		}
+		allocation.layer = freeLayers.back();
+		freeLayers.pop_back();
+	}
+	allocation.shadow = int(shadows.size());
+	Shadow shadow{};
+	shadow.lightSpace = glm::mat4{1.0f};
+	shadow.rect = glm::vec4{float(allocation.layer), farPlane, 0.0f, 0.0f};
+	shadows.push_back(shadow);
+	return allocation.shadow;
+}
+
+void ShadowAtlas::endUpdate()
+{
+	for(auto it = allocations.begin(); it != allocations.end();)
+	{
+		if(it->second.requested)
+		{
+			++it;
+			continue;
+		}
+		release(it->second);
+		it = allocations.erase(it);
+	}
+}
+
+int ShadowAtlas::getShadow(Node const* light, int cascade) const
+{
+	auto const it = allocations.find({light, cascade});
+	return it == allocations.end() ? -1 : it->second.shadow;
+}
+
+int ShadowAtlas::getCascades(Node const* light, int firstCascade) const
+{
+	auto const it = allocations.find({light, firstCascade});
+	if(it == allocations.end() || it->second.shadow == -1)
+		return 0;
+	return std::max(it->second.cascades, 1);
+}
+
+ShadowAtlas::Tile ShadowAtlas::getTile(Node const* light, int cascade) const
+{
+	return nodes[allocations.at({light, cascade}).node].tile;
+}
+
+int ShadowAtlas::getLayer(Node const* light) const
+{
+	return allocations.at({light, 0}).layer;
+}
+
+ShadowAtlas::Update ShadowAtlas::getUpdate(Node const* light, uint64_t lightSignature, uint64_t staticSignature, uint64_t dynamicSignature, int cascade)
+{
+	Allocation& allocation = allocations.at({light, cascade});
+	auto& cache = allocation.cache;
+	int const allFaces = allocation.layer != -1 ? 0b111111 : 1;
+	if(!cache.valid || cache.light != lightSignature || cache.staticCasters != staticSignature)
+		cache.staleStatic = allFaces;
+	if(cache.staleStatic || cache.dynamicCasters != dynamicSignature)
+		cache.staleDynamic = allFaces;
+	cache.valid = true;
+	cache.light = lightSignature;
+	cache.staticCasters = staticSignature;
+	cache.dynamicCasters = dynamicSignature;
+	if(!cache.staleDynamic)
+		stats.cached++;
+	Update update;
+	update.staticFaces = cache.staleStatic;
+	//a stale static face has to be copied under the dynamic casters again
+	update.dynamicFaces = cache.staleDynamic | cache.staleStatic;
+	update.fresh = !cache.drawn;
+	return update;
+}
+
+void ShadowAtlas::defer(Node const* light, int cascade)
+{
+	allocations.at({light, cascade}).cache.deferredFrames++;
+	stats.deferred++;
+}
+
+int ShadowAtlas::getDeferredFrames(Node const* light, int cascade) const
+{
+	return allocations.at({light, cascade}).cache.deferredFrames;
+}
+
+bool ShadowAtlas::hasDeferred() const
+{
+	return stats.deferred > 0;
+}
+
+void ShadowAtlas::invalidate()
+{
+	for(auto&[key, allocation] : allocations)
+		allocation.cache.valid = false;
+}
+
+void ShadowAtlas::renderTo(Node const* light, Layer layer, int cascade, int face)
+{
+	static float const clearDepth = 1.0f;
+	Allocation& allocation = allocations.at({light, cascade});
+	if(layer != Layer::all && !staticAtlas)
+		createStaticTextures();
+	bool const cube = allocation.layer != -1;
+	GLenum const target = cube ? GL_TEXTURE_CUBE_MAP_ARRAY : GL_TEXTURE_2D;
+	unsigned int const texture = cube ? cubeArray : atlas;
+	unsigned int const staticTexture = cube ? staticCubeArray : staticAtlas;
+	//the whole cube array is attached, the omnidirectional shader picks the layer of the cube's faces
+	glm::ivec3 offset{0, 0, allocation.layer * 6 + std::max(face, 0)};
+	glm::ivec3 size{cubeSize, cubeSize, face == -1 ? 6 : 1};
+	if(!cube)
+	{
+		Tile const& tile = nodes[allocation.node].tile;
+		offset = glm::ivec3{tile.offset, 0};
+		size = glm::ivec3{tile.size, tile.size, 1};
+	}
+	unsigned int const drawn = layer == Layer::staticCasters ? staticTexture : texture;
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glNamedFramebufferTexture(framebuffer, GL_DEPTH_ATTACHMENT, drawn, 0);
+	glViewport(offset.x, offset.y, size.x, size.y);
+	if(layer == Layer::dynamicCasters)
+	{
+		glCopyImageSubData(staticTexture, target, 0, offset.x, offset.y, offset.z,
+			texture, target, 0, offset.x, offset.y, offset.z, size.x, size.y, size.z);
+		stats.dynamicLayers++;
+	}
+	else
+	{
+		glClearTexSubImage(drawn, 0, offset.x, offset.y, offset.z, size.x, size.y, size.z, GL_DEPTH_COMPONENT, GL_FLOAT, &clearDepth);
+		if(layer == Layer::staticCasters)
+			stats.staticLayers++;
+		else
+			stats.dynamicLayers++;
+	}
+
+	auto& cache = allocation.cache;
+	int const faces = !cube ? 1 : face == -1 ? 0b111111 : 1 << face;
+	if(layer == Layer::staticCasters)
+	{
+		cache.staleStatic &= ~faces;
+		return;
+	}
+	//without a static layer the whole shadow map is drawn at once
+	if(layer == Layer::all)
+		cache.staleStatic &= ~faces;
+	cache.staleDynamic &= ~faces;
+	if(!cache.staleDynamic)
+	{
+		cache.drawn = true;
+		cache.deferredFrames = 0;
+	}
+}
+
+void ShadowAtlas::setLightSpace(Node const* light, glm::mat4 const& lightSpace, float cascadeEnd, int cascade)
+{
+	Allocation& allocation = allocations.at({light, cascade});
+	allocation.lightSpace = lightSpace;
+	allocation.cascadeEnd = cascadeEnd;
+	shadows[allocation.shadow].lightSpace = lightSpace;
+	shadows[allocation.shadow].cascadeEnd = cascadeEnd;
+}
+
+void ShadowAtlas::setDepthComparison(GLenum comparison)
+{
+	glTextureParameteri(atlas, GL_TEXTURE_COMPARE_FUNC, comparison);
+	glTextureParameteri(cubeArray, GL_TEXTURE_COMPARE_FUNC, comparison);
+}
+
+void ShadowAtlas::use(int atlasUnit, int cubeArrayUnit) const
+{
+	glNamedBufferData(shadowBuffer, std::max<std::size_t>(shadows.size(), 1) * sizeof(Shadow), shadows.data(), GL_STREAM_DRAW);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, shadowBuffer);
+	glBindTextureUnit(atlasUnit, atlas);
+	glBindTextureUnit(cubeArrayUnit, cubeArray);
+}
+
+void ShadowAtlas::drawUI()
+{
+	IDGuard idGuard{this};
+	ImGui::Text("Atlas: %i x %i, %i tiles, %.1f%% used", atlasSize, atlasSize, stats.tiles,
+		100.0f * stats.usedArea / (float(atlasSize) * atlasSize));
+	ImGui::Text("Cube Array: %i x %i, %i / %i layers used", cubeSize, cubeSize, cubeLayers - int(freeLayers.size()), cubeLayers);
+	ImGui::Text("Reallocated Tiles: %i", stats.reallocations);
+	ImGui::Text("Drawn Layers: %i static, %i dynamic, %i shadows cached, %i deferred", stats.staticLayers, stats.dynamicLayers,
+		stats.cached, stats.deferred);
+	if(staticAtlas)
+		ImGui::Text("Static Layers: %.1f MB", (float(atlasSize) * atlasSize + float(cubeSize) * cubeSize * 6 * std::max(cubeLayers, 1)) * 4 / (1024.0f * 1024.0f));
+	if(stats.failures)
+		ImGui::Text("Lights Without Room: %i", stats.failures);
+	for(auto const&[key, allocation] : allocations)
+	{
+		auto const&[light, cascade] = key;
+		if(allocation.node != -1)
+		{
+			Tile const& tile = nodes[allocation.node].tile;
+			ImGui::BulletText("%s (%i): %i x %i at (%i, %i)", light->getName().data(), cascade, tile.size, tile.size, tile.offset.x, tile.offset.y);
+		}
+		else if(allocation.layer != -1)
+		{
+			ImGui::BulletText("%s: cube layer %i", light->getName().data(), allocation.layer);
+		}
+	}
+	ImGui::Image(ImTextureID(atlasView), ImVec2(256, 256), ImVec2(0, 1), ImVec2(1, 0));
+}
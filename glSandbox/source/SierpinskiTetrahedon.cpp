@@ -61,13 +61,14 @@ void SierpinskiTetrahedon::generate() const
 	mesh = std::make_unique<Mesh>(bounds, GL_TRIANGLES, buildAttributes(std::move(vertices)), buildIndexBuffer(std::move(indices)));
 }
 
-void SierpinskiTetrahedon::drawUI()
+bool SierpinskiTetrahedon::drawUI()
 {
-	ImGui::BeginGroup();
+	int const previousIterations = iterations;
 	ImGui::InputInt("Iterations ", &iterations, 1);
 	if(iterations < 0)
 		iterations = 0;
-	ImGui::EndGroup();
-	if(ImGui::IsItemActive() || ImGui::IsItemDeactivatedAfterChange())
-		parametersChanged = true;
+	if(iterations == previousIterations)
+		return false;
+	parametersChanged = true;
+	return true;
 }
@@ -47,6 +47,7 @@ Texture& Texture::operator=(Texture&& other)
 	mipmapping = other.mipmapping; linear = other.linear; path = other.path;
 
 	std::swap(this->ID, other.ID);
+	updateTimestamp();
 	return *this;
 }
 
@@ -164,6 +165,17 @@ std::string Texture::getNamePrefix() const
 	return "texture";
 }
 
+void Texture::updateTimestamp()
+{
+	Timestamp::updateTimestamp();
+	latestTimestamp = getTimestamp();
+}
+
+uint64_t Texture::getLatestTimestamp()
+{
+	return latestTimestamp;
+}
+
 unsigned int Texture::getID() const
 {
 	if(!allocated)
@@ -39,8 +39,9 @@ void TextureRenderer::render()
 {
 	initializeRenderState();
 	ShaderManager::visualizeTexture()->use();
+	static Shader::UniformArray<Shader::Uniform<int>> const channels{"visualizeChannel[", "]"};
 	for(int i = 0; i < 4; i++)
-		ShaderManager::visualizeTexture()->set("visualizeChannel[" + std::to_string(i) + "]", visualizeChannel[i]);
+		ShaderManager::visualizeTexture()->set(channels[i], visualizeChannel[i]);
 	ShaderManager::visualizeTexture()->set("linear", texture->isLinear());
 	ShaderManager::visualizeTexture()->set("linearize", linearize);
 	if(linearize)
@@ -0,0 +1,107 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+thread_local ThreadPool* ThreadPool::currentPool = nullptr;
+thread_local int ThreadPool::currentQueue = 0;
+
+ThreadPool::ThreadPool(int workerCount)
+{
+	for(int i = 0; i <= workerCount; i++)
+		queues.push_back(std::make_unique<Queue>());
+	for(int i = 1; i <= workerCount; i++)
+		workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock{sleepMutex};
+		stopping = true;
+	}
+	sleepCondition.notify_all();
+	for(auto& worker : workers)
+		worker.join();
+}
+
+int ThreadPool::getOwnQueue() const
+{
+	return currentPool == this ? currentQueue : 0;
+}
+
+bool ThreadPool::tryRunTask(int ownQueue)
+{
+	std::function<void()> task;
+	for(int i = 0; i < int(queues.size()) && !task; i++)
+	{
+		Queue& queue = *queues[(ownQueue + i) % queues.size()];
+		std::lock_guard<std::mutex> lock{queue.mutex};
+		if(queue.tasks.empty())
+			continue;
+		if(i == 0)
+		{
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+		}
+		else
+		{
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+		}
+	}
+	if(!task)
+		return false;
+	queuedTasks--;
+	task();
+	pendingTasks--;
+	return true;
+}
+
+void ThreadPool::workerLoop(int ownQueue)
+{
+	currentPool = this;
+	currentQueue = ownQueue;
+	while(!stopping)
+	{
+		if(tryRunTask(ownQueue))
+			continue;
+		std::unique_lock<std::mutex> lock{sleepMutex};
+		sleepCondition.wait(lock, [&](){
+			return stopping || queuedTasks > 0;
+		});
+	}
+}
+
+ThreadPool& ThreadPool::shared()
+{
+	static ThreadPool pool{std::max(1, int(std::thread::hardware_concurrency()) - 1)};
+	return pool;
+}
+
+int ThreadPool::getWorkerCount() const
+{
+	return int(workers.size());
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+	pendingTasks++;
+	{
+		Queue& queue = *queues[getOwnQueue()];
+		std::lock_guard<std::mutex> lock{queue.mutex};
+		queue.tasks.push_back(std::move(task));
+		queuedTasks++;
+	}
+	{
+		std::lock_guard<std::mutex> lock{sleepMutex};
+	}
+	sleepCondition.notify_one();
+}
+
+void ThreadPool::wait()
+{
+	int const ownQueue = getOwnQueue();
+	while(pendingTasks > 0)
+		if(!tryRunTask(ownQueue))
+			std::this_thread::yield();
+}
@@ -0,0 +1,114 @@
+#include "TransformHierarchy.h"
+#include "Node.h"
+#include "Profiler.h"
+#include "SIMD.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <utility>
+
+void TransformHierarchy::rebuild(Node* root)
+{
+	nodes.clear();
+	parents.clear();
+	if(!root)
+		return;
+
+	std::vector<std::pair<Node*, int>> stack{{root, -1}};
+	while(!stack.empty())
+	{
+		auto[node, parent] = stack.back();
+		stack.pop_back();
+		int const idx = int(nodes.size());
+		nodes.push_back(node);
+		parents.push_back(parent);
+		auto const& children = node->getChildren();
+		for(auto it = children.rbegin(); it != children.rend(); it++)
+			stack.emplace_back(it->get(), idx);
+	}
+
+	subtreeEnds.resize(nodes.size());
+	for(int i = 0; i < int(nodes.size()); i++)
+		subtreeEnds[i] = i + 1;
+	for(int i = int(nodes.size()) - 1; i > 0; i--)
+		subtreeEnds[parents[i]] = std::max(subtreeEnds[parents[i]], subtreeEnds[i]);
+
+	globalTransformations.resize(nodes.size());
+}
+
+void TransformHierarchy::updateRange(int begin, int end)
+{
+	int updates = 0;
+	for(int i = begin; i < end; i++)
+	{
+		auto& cache = nodes[i]->transformationCache;
+		if(!cache.globalOutdated)
+		{
+			globalTransformations[i] = cache.global;
+			continue;
+		}
+
+		if(cache.localOutdated)
+		{
+			auto const[translation, rotation, scale] = nodes[i]->getLocalComponents();
+			cache.local = glm::mat4_cast(rotation);
+			cache.local[0] *= scale.x;
+			cache.local[1] *= scale.y;
+			cache.local[2] *= scale.z;
+			cache.local[3] = glm::vec4{translation, 1.0f};
+			cache.localOutdated = false;
+			updates++;
+		}
+
+		if(parents[i] == -1)
+		{
+			globalTransformations[i] = cache.local;
+		}
+		else if(nodes[i]->inheritsAllComponents())
+		{
+			simd::multiply(globalTransformations[parents[i]], cache.local, globalTransformations[i]);
+		}
+		else
+		{
+			//the parent's cache is already up to date, so the regular path is cheap
+			globalTransformations[i] = nodes[i]->getGlobalTransformation();
+			continue;
+		}
+		cache.global = globalTransformations[i];
+		cache.globalOutdated = false;
+		updates++;
+	}
+	profiler::counters::transformationUpdates.increment(updates);
+}
+
+void TransformHierarchy::updateSubtree(int root, ThreadPool& threadPool)
+{
+	if(subtreeEnds[root] - root <= parallelGrainSize)
+	{
+		updateRange(root, subtreeEnds[root]);
+		return;
+	}
+	updateRange(root, root + 1);
+	for(int child = root + 1; child < subtreeEnds[root]; child = subtreeEnds[child])
+		threadPool.submit([this, child, &threadPool](){
+			updateSubtree(child, threadPool);
+		});
+}
+
+void TransformHierarchy::update()
+{
+	updateRange(0, getSize());
+}
+
+void TransformHierarchy::update(ThreadPool& threadPool)
+{
+	if(nodes.empty())
+		return;
+	updateSubtree(0, threadPool);
+	threadPool.wait();
+}
+
+int TransformHierarchy::getSize() const
+{
+	return int(nodes.size());
+}
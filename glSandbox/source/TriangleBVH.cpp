@@ -0,0 +1,252 @@
+#include "TriangleBVH.h"
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+	constexpr int binCount = 12;
+
+	struct Box
+	{
+		glm::vec3 min{FLT_MAX};
+		glm::vec3 max{-FLT_MAX};
+
+		void grow(glm::vec3 const& point)
+		{
+			min = glm::min(min, point);
+			max = glm::max(max, point);
+		}
+
+		void grow(Box const& other)
+		{
+			min = glm::min(min, other.min);
+			max = glm::max(max, other.max);
+		}
+
+		float getArea() const
+		{
+			glm::vec3 const extent = glm::max(max - min, glm::vec3{0.0f});
+			return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+		}
+	};
+}
+
+TriangleBVH::TriangleBVH(std::vector<glm::vec3> const& positions, std::vector<uint32_t> const& indices)
+{
+	int const triangleCount = int(indices.size() / 3);
+	if(triangleCount == 0)
+		return;
+
+	std::vector<Box> boxes(triangleCount);
+	std::vector<glm::vec3> centroids(triangleCount);
+	for(int i = 0; i < triangleCount; i++)
+	{
+		for(int j = 0; j < 3; j++)
+			boxes[i].grow(positions[indices[i * 3 + j]]);
+		centroids[i] = (boxes[i].min + boxes[i].max) * 0.5f;
+	}
+	triangleIndices.resize(triangleCount);
+	for(int i = 0; i < triangleCount; i++)
+		triangleIndices[i] = i;
+
+	//binned surface area heuristic, falling back to a median split when the bins can't separate the triangles
+	struct Task
+	{
+		int node;
+		int begin;
+		int end;
+	};
+	std::vector<Task> stack{{0, 0, triangleCount}};
+	nodes.reserve(2 * triangleCount / maxLeafSize + 1);
+	nodes.emplace_back();
+	while(!stack.empty())
+	{
+		auto const[current, begin, end] = stack.back();
+		stack.pop_back();
+		Box bounds;
+		Box centroidBounds;
+		for(int i = begin; i < end; i++)
+		{
+			bounds.grow(boxes[triangleIndices[i]]);
+			centroidBounds.grow(centroids[triangleIndices[i]]);
+		}
+		nodes[current].min = bounds.min;
+		nodes[current].max = bounds.max;
+		int const count = end - begin;
+		if(count <= maxLeafSize)
+		{
+			nodes[current].first = begin;
+			nodes[current].count = count;
+			continue;
+		}
+
+		glm::vec3 const centroidExtent = centroidBounds.max - centroidBounds.min;
+		int axis = 0;
+		if(centroidExtent.y > centroidExtent[axis])
+			axis = 1;
+		if(centroidExtent.z > centroidExtent[axis])
+			axis = 2;
+
+		int middle = begin;
+		if(centroidExtent[axis] > 0.0f)
+		{
+			float const scale = binCount / centroidExtent[axis];
+			auto const getBin = [&](int triangle){
+				return std::min(binCount - 1, int((centroids[triangle][axis] - centroidBounds.min[axis]) * scale));
+			};
+			std::array<Box, binCount> bins;
+			std::array<int, binCount> binSizes{};
+			for(int i = begin; i < end; i++)
+			{
+				int const bin = getBin(triangleIndices[i]);
+				bins[bin].grow(boxes[triangleIndices[i]]);
+				binSizes[bin]++;
+			}
+			//costs of splitting after each bin, swept from both sides
+			std::array<float, binCount - 1> costs;
+			Box left;
+			int leftCount = 0;
+			for(int i = 0; i < binCount - 1; i++)
+			{
+				left.grow(bins[i]);
+				leftCount += binSizes[i];
+				costs[i] = leftCount ? left.getArea() * leftCount : 0.0f;
+			}
+			Box right;
+			int rightCount = 0;
+			for(int i = binCount - 1; i > 0; i--)
+			{
+				right.grow(bins[i]);
+				rightCount += binSizes[i];
+				costs[i - 1] += rightCount ? right.getArea() * rightCount : 0.0f;
+			}
+			int const split = int(std::min_element(costs.begin(), costs.end()) - costs.begin());
+			middle = int(std::partition(triangleIndices.begin() + begin, triangleIndices.begin() + end, [&](int triangle){
+				return getBin(triangle) <= split;
+			}) - triangleIndices.begin());
+		}
+		if(middle == begin || middle == end)
+		{
+			middle = begin + count / 2;
+			std::nth_element(triangleIndices.begin() + begin, triangleIndices.begin() + middle, triangleIndices.begin() + end, [&](int lhs, int rhs){
+				return centroids[lhs][axis] < centroids[rhs][axis];
+			});
+		}
+
+		int const first = int(nodes.size());
+		nodes[current].first = first;
+		nodes[current].count = 0;
+		nodes.emplace_back();
+		nodes.emplace_back();
+		stack.push_back({first + 1, middle, end});
+		stack.push_back({first, begin, middle});
+	}
+
+	triangles.reserve(triangleCount);
+	for(int triangle : triangleIndices)
+	{
+		glm::vec3 const& v0 = positions[indices[triangle * 3]];
+		glm::vec3 const& v1 = positions[indices[triangle * 3 + 1]];
+		glm::vec3 const& v2 = positions[indices[triangle * 3 + 2]];
+		triangles.push_back({v0, v1 - v0, v2 - v0});
+	}
+}
+
+int TriangleBVH::getTriangleCount() const
+{
+	return int(triangles.size());
+}
+
+int TriangleBVH::getNodeCount() const
+{
+	return int(nodes.size());
+}
+
+std::size_t TriangleBVH::getMemoryUsage() const
+{
+	return nodes.capacity() * sizeof(Node) + triangles.capacity() * sizeof(Triangle) + triangleIndices.capacity() * sizeof(int);
+}
+
+bool TriangleBVH::raycast(Ray const& ray, float maxDistance, Hit& hit) const
+{
+	if(nodes.empty())
+		return false;
+	glm::vec3 const inverseDirection = ray.getInverseDirection();
+	float entry;
+	if(!ray.intersects(nodes[0].min, nodes[0].max, inverseDirection, maxDistance, entry))
+		return false;
+
+	std::vector<std::pair<int, float>> stack;
+	stack.reserve(64);
+	stack.emplace_back(0, entry);
+	bool found = false;
+	while(!stack.empty())
+	{
+		auto const[current, currentEntry] = stack.back();
+		stack.pop_back();
+		if(currentEntry > maxDistance)
+			continue;
+		Node const& node = nodes[current];
+		if(node.isLeaf())
+		{
+			//double sided moller-trumbore
+			for(int i = node.first; i < node.first + node.count; i++)
+			{
+				Triangle const& triangle = triangles[i];
+				glm::vec3 const p = glm::cross(ray.direction, triangle.e2);
+				float const determinant = glm::dot(triangle.e1, p);
+				if(std::abs(determinant) < 1e-12f)
+					continue;
+				float const inverseDeterminant = 1.0f / determinant;
+				glm::vec3 const s = ray.origin - triangle.v0;
+				float const u = glm::dot(s, p) * inverseDeterminant;
+				if(u < 0.0f || u > 1.0f)
+					continue;
+				glm::vec3 const q = glm::cross(s, triangle.e1);
+				float const v = glm::dot(ray.direction, q) * inverseDeterminant;
+				if(v < 0.0f || u + v > 1.0f)
+					continue;
+				float const t = glm::dot(triangle.e2, q) * inverseDeterminant;
+				if(t < 0.0f || t > maxDistance)
+					continue;
+				maxDistance = t;
+				hit.triangle = triangleIndices[i];
+				hit.distance = t;
+				hit.barycentric = {u, v};
+				found = true;
+			}
+			continue;
+		}
+		float leftEntry, rightEntry;
+		Node const& left = nodes[node.first];
+		Node const& right = nodes[node.first + 1];
+		bool const hitLeft = ray.intersects(left.min, left.max, inverseDirection, maxDistance, leftEntry);
+		bool const hitRight = ray.intersects(right.min, right.max, inverseDirection, maxDistance, rightEntry);
+		//the nearer child is pushed last so it is visited first
+		if(hitLeft && hitRight)
+		{
+			if(leftEntry < rightEntry)
+			{
+				stack.emplace_back(node.first + 1, rightEntry);
+				stack.emplace_back(node.first, leftEntry);
+			}
+			else
+			{
+				stack.emplace_back(node.first, leftEntry);
+				stack.emplace_back(node.first + 1, rightEntry);
+			}
+		}
+		else if(hitLeft)
+		{
+			stack.emplace_back(node.first, leftEntry);
+		}
+		else if(hitRight)
+		{
+			stack.emplace_back(node.first + 1, rightEntry);
+		}
+	}
+	return found;
+}
@@ -3,10 +3,12 @@
 #include "Lights.h"
 #include "Globals.h"
 #include "SceneManager.h"
+#include "Scene.h"
 #include "Node.h"
 #include "Prop.h"
 #include "Renderer.h"
 #include "Profiler.h"
+#include "Benchmarks.h"
 #include <glad/glad.h>
 
 #include <glm/glm.hpp>
@@ -23,6 +25,7 @@
 #include <optional>
 #include <memory>
 #include <deque>
+#include <string_view>
 #include <thread>
 
 double deltaTime = 0.0f;
@@ -43,11 +46,17 @@ void mouseCallback(GLFWwindow* window, double xpos, double ypos);
 void mouseButtonCallback(GLFWwindow* window, int button, int mode, int modifier);
 void keyCallback(GLFWwindow* window, int key, int keycode, int mode, int modifier);
 void processInput(GLFWwindow* window);
+void pickProp(GLFWwindow* window);
 void drawUI();
 
 
 int main(int argc, char** argv)
 {
+	if(argc > 1 && std::string_view(argv[1]) == "--benchmarks")
+	{
+		benchmarks::runAll();
+		return 0;
+	}
 	//initialize stuff
 	glfwInit();
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
@@ -113,6 +122,7 @@ int main(int argc, char** argv)
 		{
 			std::this_thread::yield();
 		}
+		info::frame++;
 		processInput(window);
 		drawUI();
 		glfwSwapInterval(settings::rendering::vsync);
@@ -142,6 +152,7 @@ void drawUI()
 	static bool drawMainRenderer = false;
 	static bool drawPostprocessingSettings = false;
 	static bool drawProfiler = true;
+	static bool drawBenchmarks = false;
 	static bool drawImGuiDemo = false;
 	static std::deque<bool> drawRenderer;
 
@@ -177,6 +188,8 @@ void drawUI()
 			}
 			if(ImGui::MenuItem("Profiler"))
 				drawProfiler = true;
+			if(ImGui::MenuItem("Benchmarks"))
+				drawBenchmarks = true;
 			if(ImGui::BeginMenu("ImGui"))
 			{
 				if(ImGui::MenuItem("Demo"))
@@ -197,6 +210,7 @@ void drawUI()
 	}
 	settings::postprocessing::drawUI(&drawPostprocessingSettings);
 	profiler::drawUI(&drawProfiler);
+	benchmarks::drawUI(&drawBenchmarks);
 	if(drawImGuiDemo)
 		ImGui::ShowDemoWindow(&drawImGuiDemo);
 }
@@ -248,6 +262,33 @@ void mouseButtonCallback(GLFWwindow* window, int button, int mode, int modifier)
 			glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
 		}
 	}
+	else if(button == GLFW_MOUSE_BUTTON_2 && mode == GLFW_PRESS)
+	{
+		pickProp(window);
+	}
+}
+void pickProp(GLFWwindow* window)
+{
+	Camera* camera = settings::mainRenderer().getCamera();
+	Scene* scene = camera->getScene();
+	if(!scene)
+		return;
+	double x, y;
+	glfwGetCursorPos(window, &x, &y);
+	//the main renderer covers the whole window
+	glm::vec2 const ndc{2.0f * float(x) / info::windowWidth - 1.0f, 1.0f - 2.0f * float(y) / info::windowHeight};
+	glm::mat4 const inverseViewProjection = glm::inverse(camera->getProjectionMatrix() * camera->getViewMatrix());
+	glm::vec4 nearPoint = inverseViewProjection * glm::vec4{ndc, -1.0f, 1.0f};
+	glm::vec4 farPoint = inverseViewProjection * glm::vec4{ndc, 1.0f, 1.0f};
+	nearPoint /= nearPoint.w;
+	farPoint /= farPoint.w;
+	auto const hit = scene->raycast(glm::vec3{nearPoint}, glm::vec3{farPoint - nearPoint});
+
+	scene->getRoot()->recursive([](Node* node){ node->setHighlighted(false); });
+	scene->setCurrent(hit ? hit->prop : nullptr);
+	if(hit)
+		hit->prop->setHighlighted(true);
+	settings::mainRenderer().shouldRender();
 }
 void keyCallback(GLFWwindow* window, int key, int keycode, int mode, int modifier)
 {